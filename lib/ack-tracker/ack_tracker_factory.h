@@ -60,6 +60,8 @@ void ack_tracker_factory_unref(AckTrackerFactory *self);
 AckTrackerFactory *instant_ack_tracker_factory_new(void);
 AckTrackerFactory *instant_ack_tracker_bookmarkless_factory_new(void);
 AckTrackerFactory *consecutive_ack_tracker_factory_new(void);
+void consecutive_ack_tracker_factory_set_bookmark_save_limits(AckTrackerFactory *s, guint batch_size,
+                                                              guint interval);
 AckTrackerFactory *batched_ack_tracker_factory_new(guint timeout, guint batch_size,
                                                    BatchedAckTrackerOnBatchAcked cb,
                                                    gpointer user_data);
@@ -35,6 +35,18 @@ typedef struct _ConsecutiveAckTracker
   GMutex mutex;
   AckTrackerOnAllAcked on_all_acked;
   gboolean bookmark_saving_disabled;
+  gboolean source_ref_held;
+
+  /* deferred bookmark saving: the bookmark of the last acked record is
+   * moved here and written to the persist state only once every
+   * bookmark_save_batch_size acked messages or bookmark_save_interval
+   * milliseconds, whichever comes first */
+  guint bookmark_save_batch_size;
+  guint bookmark_save_interval;
+  Bookmark deferred_bookmark;
+  gboolean has_deferred_bookmark;
+  guint acked_since_last_save;
+  gint64 last_save_time;
 } ConsecutiveAckTracker;
 
 void
@@ -93,14 +105,18 @@ static void
 consecutive_ack_tracker_track_msg(AckTracker *s, LogMessage *msg)
 {
   ConsecutiveAckTracker *self = (ConsecutiveAckTracker *)s;
-  LogSource *source = self->super.source;
 
   g_assert(self->pending_ack_record != NULL);
 
-  log_pipe_ref((LogPipe *)source);
-
   consecutive_ack_tracker_lock(s);
   {
+    /* the source is kept alive as long as it has unacked messages, we
+     * only take a reference for the first one instead of each message */
+    if (!self->source_ref_held)
+      {
+        log_pipe_ref((LogPipe *)self->super.source);
+        self->source_ref_held = TRUE;
+      }
     _ack_records_track_msg(self, msg);
   }
   consecutive_ack_tracker_unlock(s);
@@ -113,11 +129,54 @@ _is_bookmark_saving_enabled(ConsecutiveAckTracker *self)
 }
 
 static void
-_ack_record_save_bookmark(ConsecutiveAckRecord *ack_record)
+_drop_deferred_bookmark(ConsecutiveAckTracker *self)
+{
+  if (!self->has_deferred_bookmark)
+    return;
+
+  bookmark_destroy(&self->deferred_bookmark);
+  self->has_deferred_bookmark = FALSE;
+}
+
+static void
+_flush_deferred_bookmark(ConsecutiveAckTracker *self)
+{
+  if (!self->has_deferred_bookmark)
+    return;
+
+  bookmark_save(&self->deferred_bookmark);
+  _drop_deferred_bookmark(self);
+
+  self->acked_since_last_save = 0;
+  if (self->bookmark_save_interval)
+    self->last_save_time = g_get_monotonic_time();
+}
+
+static gboolean
+_deferred_bookmark_needs_flush(ConsecutiveAckTracker *self)
+{
+  if (self->acked_since_last_save >= self->bookmark_save_batch_size)
+    return TRUE;
+
+  if (self->bookmark_save_interval == 0)
+    return FALSE;
+
+  gint64 elapsed_msec = (g_get_monotonic_time() - self->last_save_time) / 1000;
+  return elapsed_msec >= self->bookmark_save_interval;
+}
+
+/* Takes over the bookmark of ack_record, so that the record itself can be
+ * dropped (and reused) without losing the position it points to. */
+static void
+_ack_record_defer_bookmark(ConsecutiveAckTracker *self, ConsecutiveAckRecord *ack_record, guint32 acked)
 {
-  Bookmark *bookmark = &(ack_record->super.bookmark);
+  _drop_deferred_bookmark(self);
+
+  self->deferred_bookmark = ack_record->super.bookmark;
+  self->has_deferred_bookmark = TRUE;
+  ack_record->super.bookmark.destroy = NULL;
 
-  bookmark_save(bookmark);
+  self->acked_since_last_save += acked;
 }
 
 static guint32
@@ -128,9 +187,15 @@ _ack_records_untrack_msg(ConsecutiveAckTracker *self, LogMessage *msg, AckType a
     {
       if (ack_type != AT_ABORTED && _is_bookmark_saving_enabled(self))
         {
-          _ack_record_save_bookmark(consecutive_ack_record_container_at(self->ack_records, ack_range_length - 1));
+          ConsecutiveAckRecord *last_acked = consecutive_ack_record_container_at(self->ack_records, ack_range_length - 1);
+          _ack_record_defer_bookmark(self, last_acked, ack_range_length);
         }
       consecutive_ack_record_container_drop(self->ack_records, ack_range_length);
+
+      /* an idle source always has its position persisted, this keeps
+       * the number of messages replayed after a crash bounded */
+      if (consecutive_ack_record_container_is_empty(self->ack_records) || _deferred_bookmark_needs_flush(self))
+        _flush_deferred_bookmark(self);
     }
 
   return ack_range_length;
@@ -141,10 +206,13 @@ consecutive_ack_tracker_manage_msg_ack(AckTracker *s, LogMessage *msg, AckType a
 {
   ConsecutiveAckTracker *self = (ConsecutiveAckTracker *)s;
   ConsecutiveAckRecord *ack_rec = (ConsecutiveAckRecord *)msg->ack_record;
+  LogSource *source = self->super.source;
+  gboolean release_source_ref = FALSE;
+
   ack_rec->acked = TRUE;
 
   if (ack_type == AT_SUSPENDED)
-    log_source_flow_control_suspend(self->super.source);
+    log_source_flow_control_suspend(source);
 
   consecutive_ack_tracker_lock(s);
   {
@@ -152,18 +220,26 @@ consecutive_ack_tracker_manage_msg_ack(AckTracker *s, LogMessage *msg, AckType a
     if (ack_range_length > 0)
       {
         if (ack_type == AT_SUSPENDED)
-          log_source_flow_control_adjust_when_suspended(self->super.source, ack_range_length);
+          log_source_flow_control_adjust_when_suspended(source, ack_range_length);
         else
-          log_source_flow_control_adjust(self->super.source, ack_range_length);
+          log_source_flow_control_adjust(source, ack_range_length);
 
         if (consecutive_ack_tracker_is_empty(s))
-          consecutive_ack_tracker_on_all_acked_call(s);
+          {
+            consecutive_ack_tracker_on_all_acked_call(s);
+            release_source_ref = self->source_ref_held;
+            self->source_ref_held = FALSE;
+          }
       }
   }
   consecutive_ack_tracker_unlock(s);
 
   log_msg_unref(msg);
-  log_pipe_unref((LogPipe *)self->super.source);
+
+  /* the last unref may free the source along with this tracker, so this
+   * has to be the very last thing we do */
+  if (release_source_ref)
+    log_pipe_unref((LogPipe *)source);
 }
 
 gboolean
@@ -209,6 +285,7 @@ consecutive_ack_tracker_free(AckTracker *s)
       handler->user_data_free_fn(handler->user_data);
     }
 
+  _drop_deferred_bookmark(self);
   g_mutex_clear(&self->mutex);
 
   consecutive_ack_record_container_free(self->ack_records);
@@ -224,6 +301,7 @@ consecutive_ack_tracker_disable_bookmark_saving(AckTracker *s)
   consecutive_ack_tracker_lock(s);
   {
     self->bookmark_saving_disabled = TRUE;
+    _drop_deferred_bookmark(self);
   }
   consecutive_ack_tracker_unlock(s);
 }
@@ -245,6 +323,7 @@ consecutive_ack_tracker_init_instance(ConsecutiveAckTracker *self, LogSource *so
   self->super.source = source;
   source->ack_tracker = (AckTracker *)self;
   self->ack_records = ack_records;
+  self->bookmark_save_batch_size = 1;
   g_mutex_init(&self->mutex);
   _setup_callbacks(self);
 }
@@ -268,3 +347,13 @@ consecutive_ack_tracker_new(LogSource *source)
 
   return (AckTracker *)self;
 }
+
+void
+consecutive_ack_tracker_set_bookmark_save_limits(AckTracker *s, guint batch_size, guint interval)
+{
+  ConsecutiveAckTracker *self = (ConsecutiveAckTracker *)s;
+
+  self->bookmark_save_batch_size = MAX(batch_size, 1);
+  self->bookmark_save_interval = interval;
+  self->last_save_time = g_get_monotonic_time();
+}
@@ -45,6 +45,7 @@ void consecutive_ack_tracker_set_on_all_acked(AckTracker *s, AckTrackerOnAllAcke
                                               GDestroyNotify user_data_free_fn);
 
 AckTracker *consecutive_ack_tracker_new(LogSource *source);
+void consecutive_ack_tracker_set_bookmark_save_limits(AckTracker *s, guint batch_size, guint interval);
 
 #endif
 
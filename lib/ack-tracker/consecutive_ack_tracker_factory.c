@@ -28,13 +28,19 @@
 typedef struct _ConsecutiveAckTrackerFactory
 {
   AckTrackerFactory super;
+  guint bookmark_save_batch_size;
+  guint bookmark_save_interval;
 } ConsecutiveAckTrackerFactory;
 
-
 static AckTracker *
 _factory_create(AckTrackerFactory *s, LogSource *source)
 {
-  return consecutive_ack_tracker_new(source);
+  ConsecutiveAckTrackerFactory *self = (ConsecutiveAckTrackerFactory *)s;
+  AckTracker *ack_tracker = consecutive_ack_tracker_new(source);
+
+  consecutive_ack_tracker_set_bookmark_save_limits(ack_tracker, self->bookmark_save_batch_size,
+                                                   self->bookmark_save_interval);
+  return ack_tracker;
 }
 
 static void
@@ -59,6 +65,17 @@ consecutive_ack_tracker_factory_new(void)
 {
   ConsecutiveAckTrackerFactory *factory = g_new0(ConsecutiveAckTrackerFactory, 1);
   _init_instance(&factory->super);
+  factory->bookmark_save_batch_size = 1;
 
   return &factory->super;
 }
+
+void
+consecutive_ack_tracker_factory_set_bookmark_save_limits(AckTrackerFactory *s, guint batch_size, guint interval)
+{
+  ConsecutiveAckTrackerFactory *self = (ConsecutiveAckTrackerFactory *)s;
+
+  g_assert(s->type == ACK_CONSECUTIVE);
+  self->bookmark_save_batch_size = batch_size;
+  self->bookmark_save_interval = interval;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "ack-tracker/consecutive_ack_tracker.h"
+#include "ack-tracker/ack_tracker_factory.h"
+#include "logsource.h"
+#include "apphook.h"
+
+GlobalConfig *cfg;
+
+typedef struct _TestBookmarkData
+{
+  guint *saved_ctr;
+} TestBookmarkData;
+
+static void
+_save_bookmark(Bookmark *bookmark)
+{
+  TestBookmarkData *bookmark_data = (TestBookmarkData *) &bookmark->container;
+  (*bookmark_data->saved_ctr)++;
+}
+
+static void
+_fill_bookmark(Bookmark *bookmark, guint *ctr)
+{
+  TestBookmarkData *bookmark_data = (TestBookmarkData *) &bookmark->container;
+
+  bookmark_data->saved_ctr = ctr;
+  bookmark->save = _save_bookmark;
+}
+
+static LogSource *
+_init_log_source(AckTrackerFactory *factory)
+{
+  LogSource *src = g_new0(LogSource, 1);
+  LogSourceOptions *options = g_new0(LogSourceOptions, 1);
+
+  log_source_options_defaults(options);
+  options->init_window_size = 10;
+  log_source_init_instance(src, cfg);
+  log_source_options_init(options, cfg, "testgroup");
+  log_source_set_options(src, options, "test_stats_id", NULL, TRUE, NULL);
+  log_source_set_ack_tracker_factory(src, factory);
+
+  cr_assert(log_pipe_init(&src->super));
+
+  return src;
+}
+
+static void
+_deinit_log_source(LogSource *src)
+{
+  log_pipe_deinit(&src->super);
+  g_free(src->options);
+  log_pipe_unref(&src->super);
+}
+
+static void
+_track_messages(AckTracker *ack_tracker, LogMessage **msgs, gint num, guint *saved_ctr)
+{
+  for (gint i = 0; i < num; i++)
+    {
+      Bookmark *bm = ack_tracker_request_bookmark(ack_tracker);
+      _fill_bookmark(bm, saved_ctr);
+      msgs[i] = log_msg_new_empty();
+      ack_tracker_track_msg(ack_tracker, msgs[i]);
+    }
+}
+
+static void
+_setup(void)
+{
+  cfg = cfg_new_snippet();
+  app_startup();
+}
+
+static void
+_teardown(void)
+{
+  app_shutdown();
+  cfg_free(cfg);
+}
+
+TestSuite(consecutive_ack_tracker, .init = _setup, .fini = _teardown);
+
+Test(consecutive_ack_tracker, bookmark_is_saved_on_each_ack_by_default)
+{
+  LogSource *src = _init_log_source(consecutive_ack_tracker_factory_new());
+  AckTracker *ack_tracker = src->ack_tracker;
+  LogMessage *msgs[3];
+  guint saved_ctr = 0;
+
+  _track_messages(ack_tracker, msgs, G_N_ELEMENTS(msgs), &saved_ctr);
+
+  for (gint i = 0; i < G_N_ELEMENTS(msgs); i++)
+    {
+      ack_tracker_manage_msg_ack(ack_tracker, msgs[i], AT_PROCESSED);
+      cr_expect_eq(saved_ctr, i + 1);
+    }
+
+  cr_expect(consecutive_ack_tracker_is_empty(ack_tracker));
+  _deinit_log_source(src);
+}
+
+Test(consecutive_ack_tracker, bookmark_saving_is_deferred_until_batch_is_acked)
+{
+  AckTrackerFactory *factory = consecutive_ack_tracker_factory_new();
+  consecutive_ack_tracker_factory_set_bookmark_save_limits(factory, 3, 0);
+  LogSource *src = _init_log_source(factory);
+  AckTracker *ack_tracker = src->ack_tracker;
+  LogMessage *msgs[5];
+  guint saved_ctr = 0;
+
+  _track_messages(ack_tracker, msgs, G_N_ELEMENTS(msgs), &saved_ctr);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[0], AT_PROCESSED);
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[1], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 0);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[2], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 1);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[3], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 1);
+
+  /* the last ack drains the tracker, the position is persisted regardless of the batch size */
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[4], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 2);
+
+  _deinit_log_source(src);
+}
+
+Test(consecutive_ack_tracker, out_of_order_acks_are_saved_once_the_range_closes)
+{
+  AckTrackerFactory *factory = consecutive_ack_tracker_factory_new();
+  consecutive_ack_tracker_factory_set_bookmark_save_limits(factory, 2, 0);
+  LogSource *src = _init_log_source(factory);
+  AckTracker *ack_tracker = src->ack_tracker;
+  LogMessage *msgs[4];
+  guint saved_ctr = 0;
+
+  _track_messages(ack_tracker, msgs, G_N_ELEMENTS(msgs), &saved_ctr);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[2], AT_PROCESSED);
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[1], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 0);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[0], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 1);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[3], AT_PROCESSED);
+  cr_expect_eq(saved_ctr, 2);
+
+  _deinit_log_source(src);
+}
+
+Test(consecutive_ack_tracker, aborted_messages_do_not_save_bookmarks)
+{
+  AckTrackerFactory *factory = consecutive_ack_tracker_factory_new();
+  consecutive_ack_tracker_factory_set_bookmark_save_limits(factory, 2, 0);
+  LogSource *src = _init_log_source(factory);
+  AckTracker *ack_tracker = src->ack_tracker;
+  LogMessage *msgs[2];
+  guint saved_ctr = 0;
+
+  _track_messages(ack_tracker, msgs, G_N_ELEMENTS(msgs), &saved_ctr);
+
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[0], AT_ABORTED);
+  ack_tracker_manage_msg_ack(ack_tracker, msgs[1], AT_ABORTED);
+  cr_expect_eq(saved_ctr, 0);
+
+  _deinit_log_source(src);
+}
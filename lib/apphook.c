@@ -26,6 +26,7 @@
 #include "messages.h"
 #include "children.h"
 #include "dnscache.h"
+#include "dns-resolver.h"
 #include "alarms.h"
 #include "stats/stats-registry.h"
 #include "healthcheck/healthcheck-stats.h"
@@ -40,6 +41,7 @@
 #include "crypto.h"
 #include "value-pairs/value-pairs.h"
 #include "scratch-buffers.h"
+#include "logproto/logproto-buffer-pool.h"
 #include "mainloop.h"
 #include "secret-storage/nondumpable-allocator.h"
 #include "secret-storage/secret-storage.h"
@@ -222,6 +224,7 @@ app_startup(void)
   hostname_global_init();
   dns_caching_global_init();
   dns_caching_thread_init();
+  dns_resolver_global_init();
   afinter_global_init();
   child_manager_init();
   alarm_init();
@@ -235,6 +238,7 @@ app_startup(void)
   value_pairs_global_init();
   service_management_init();
   scratch_buffers_allocator_init();
+  log_proto_buffer_pool_allocator_init();
   nondumpable_setlogger(nondumpable_allocator_msg_debug, nondumpable_allocator_msg_fatal);
   secret_storage_init();
   transport_factory_id_global_init();
@@ -274,6 +278,7 @@ app_shutdown(void)
   multi_line_global_deinit();
   main_loop_thread_resource_deinit();
   secret_storage_deinit();
+  log_proto_buffer_pool_allocator_deinit();
   scratch_buffers_allocator_deinit();
   scratch_buffers_global_deinit();
   value_pairs_global_deinit();
@@ -287,6 +292,7 @@ app_shutdown(void)
   g_list_free(application_hooks);
   g_list_free_full(application_thread_init_hooks, g_free);
   g_list_free_full(application_thread_deinit_hooks, g_free);
+  dns_resolver_global_deinit();
   dns_caching_thread_deinit();
   dns_caching_global_deinit();
   hostname_global_deinit();
@@ -342,6 +348,7 @@ void
 app_thread_start(void)
 {
   scratch_buffers_allocator_init();
+  log_proto_buffer_pool_allocator_init();
   dns_caching_thread_init();
   main_loop_call_thread_init();
   run_application_thread_init_hooks();
@@ -353,6 +360,7 @@ app_thread_stop(void)
   run_application_thread_deinit_hooks();
   main_loop_call_thread_deinit();
   dns_caching_thread_deinit();
+  log_proto_buffer_pool_allocator_deinit();
   scratch_buffers_allocator_deinit();
   timeutils_cache_deinit();
 }
@@ -213,6 +213,7 @@
 %token KW_SYSLOG_STATS                10405
 %token KW_HEALTHCHECK_FREQ            10406
 %token KW_WORKER_PARTITION_KEY        10407
+%token KW_PIPE_LATENCY_SAMPLING       10408
 
 %token KW_CHAIN_HOSTNAMES             10090
 %token KW_NORMALIZE_HOSTNAMES         10091
@@ -233,6 +234,8 @@
 %token KW_DNS_CACHE_EXPIRE            10130
 %token KW_DNS_CACHE_EXPIRE_FAILED     10131
 %token KW_DNS_CACHE_HOSTS             10132
+%token KW_DNS_RESOLVER_THREADS        10133
+%token KW_DNS_RESOLVER_WAIT           10134
 
 %token KW_PERSIST_ONLY                10140
 %token KW_USE_RCPTID                  10141
@@ -381,6 +384,14 @@
 %token KW_RETRIES                     10521
 
 %token KW_FETCH_NO_DATA_DELAY         10522
+%token KW_FETCH_BATCH_SIZE            10523
+
+%token KW_ADAPTIVE_BATCHING           10524
+%token KW_BATCH_LINES_MIN             10525
+%token KW_BATCH_LATENCY_TARGET        10526
+
+%token KW_WORKER_PARTITION_STRATEGY   10527
+%token KW_WORKER_PARTITION_MAX_LOAD   10528
 /* END_DECLS */
 
 %type   <ptr> expr_stmt
@@ -1099,6 +1110,7 @@ stats_group_option
 	| KW_LIFETIME '(' positive_integer ')'      { last_stats_options->lifetime = $3; }
 	| KW_MAX_DYNAMIC '(' nonnegative_integer ')'   { last_stats_options->max_dynamic = $3; }
 	| KW_SYSLOG_STATS '(' yesnoauto ')'     { last_stats_options->syslog_stats = $3; }
+	| KW_PIPE_LATENCY_SAMPLING '(' nonnegative_integer ')' { last_stats_options->pipe_latency_sampling = $3; }
 	| KW_HEALTHCHECK_FREQ '(' nonnegative_integer ')' { last_healthcheck_options->freq = $3; }
 	;
 
@@ -1108,6 +1120,10 @@ dns_cache_option
 	| KW_DNS_CACHE_EXPIRE_FAILED '(' positive_integer ')'
 	                                        { last_dns_cache_options->expire_failed = $3; }
 	| KW_DNS_CACHE_HOSTS '(' string ')'     { last_dns_cache_options->hosts = g_strdup($3); free($3); }
+	| KW_DNS_RESOLVER_THREADS '(' nonnegative_integer ')'
+	                                        { last_dns_cache_options->resolver_threads = $3; }
+	| KW_DNS_RESOLVER_WAIT '(' nonnegative_integer ')'
+	                                        { last_dns_cache_options->resolver_wait = $3; }
         ;
 
 
@@ -1344,11 +1360,21 @@ dest_driver_option
 threaded_dest_driver_batch_option
         : KW_BATCH_LINES '(' nonnegative_integer ')' { log_threaded_dest_driver_set_batch_lines(last_driver, $3); }
         | KW_BATCH_TIMEOUT '(' positive_integer ')' { log_threaded_dest_driver_set_batch_timeout(last_driver, $3); }
+        | KW_ADAPTIVE_BATCHING '(' yesno ')' { log_threaded_dest_driver_set_adaptive_batching(last_driver, $3); }
+        | KW_BATCH_LINES_MIN '(' positive_integer ')' { log_threaded_dest_driver_set_batch_lines_min(last_driver, $3); }
+        | KW_BATCH_LATENCY_TARGET '(' nonnegative_integer ')' { log_threaded_dest_driver_set_batch_latency_target(last_driver, $3); }
         ;
 
 threaded_dest_driver_workers_option
         : KW_WORKERS '(' positive_integer ')'  { log_threaded_dest_driver_set_num_workers(last_driver, $3); }
         | KW_WORKER_PARTITION_KEY '(' template_content ')' { log_threaded_dest_driver_set_worker_partition_key_ref(last_driver, $3); }
+        | KW_WORKER_PARTITION_STRATEGY '(' string ')'
+          {
+            CHECK_ERROR(log_threaded_dest_driver_set_worker_partition_strategy(last_driver, $3), @3,
+                        "Unknown worker-partition-strategy() \"%s\", valid values: modulo, consistent-hash", $3);
+            free($3);
+          }
+        | KW_WORKER_PARTITION_MAX_LOAD '(' nonnegative_integer ')' { log_threaded_dest_driver_set_worker_partition_max_load(last_driver, $3); }
         ;
 
 /* implies dest_driver_option */
@@ -1391,6 +1417,7 @@ threaded_source_driver_workers_option
 threaded_fetcher_driver_option
         : KW_FETCH_NO_DATA_DELAY '(' nonnegative_float ')' { log_threaded_fetcher_driver_set_fetch_no_data_delay(last_driver, $3); }
         | KW_TIME_REOPEN '(' positive_integer ')' { log_threaded_fetcher_driver_set_time_reopen(last_driver, $3); }
+        | KW_FETCH_BATCH_SIZE '(' positive_integer ')' { log_threaded_fetcher_driver_set_fetch_batch_size(last_driver, $3); }
         ;
 
 threaded_source_driver_option_flags
@@ -103,6 +103,7 @@ static CfgLexerKeyword main_keywords[] =
   { "lifetime",           KW_LIFETIME },
   { "max_dynamics",       KW_MAX_DYNAMIC },
   { "syslog_stats",       KW_SYSLOG_STATS },
+  { "pipe_latency_sampling", KW_PIPE_LATENCY_SAMPLING },
   { "healthcheck_freq",   KW_HEALTHCHECK_FREQ},
   { "min_iw_size_per_reader", KW_MIN_IW_SIZE_PER_READER },
   { "flush_lines",        KW_FLUSH_LINES },
@@ -173,6 +174,8 @@ static CfgLexerKeyword main_keywords[] =
   { "dns_cache_size",     KW_DNS_CACHE_SIZE },
   { "dns_cache_expire",   KW_DNS_CACHE_EXPIRE },
   { "dns_cache_expire_failed", KW_DNS_CACHE_EXPIRE_FAILED },
+  { "dns_resolver_threads", KW_DNS_RESOLVER_THREADS },
+  { "dns_resolver_wait",  KW_DNS_RESOLVER_WAIT },
   {
     "pass_unix_credentials",   KW_PASS_UNIX_CREDENTIALS, KWS_OBSOLETE,
     "The use of pass-unix-credentials() has been deprecated in " VERSION_3_35 " in favour of "
@@ -184,12 +187,18 @@ static CfgLexerKeyword main_keywords[] =
   { "retries",            KW_RETRIES },
   { "workers",            KW_WORKERS },
   { "worker_partition_key", KW_WORKER_PARTITION_KEY },
+  { "worker_partition_strategy", KW_WORKER_PARTITION_STRATEGY },
+  { "worker_partition_max_load", KW_WORKER_PARTITION_MAX_LOAD },
   { "batch_lines",        KW_BATCH_LINES },
   { "batch_timeout",      KW_BATCH_TIMEOUT },
+  { "adaptive_batching",  KW_ADAPTIVE_BATCHING },
+  { "batch_lines_min",    KW_BATCH_LINES_MIN },
+  { "batch_latency_target", KW_BATCH_LATENCY_TARGET },
 
   { "read_old_records",   KW_READ_OLD_RECORDS},
   { "use_syslogng_pid",   KW_USE_SYSLOGNG_PID },
   { "fetch_no_data_delay", KW_FETCH_NO_DATA_DELAY},
+  { "fetch_batch_size",   KW_FETCH_BATCH_SIZE },
 
   /* multi-line */
   { "multi_line_mode",    KW_MULTI_LINE_MODE  },
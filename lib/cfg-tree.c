@@ -26,6 +26,7 @@
 #include "logmpx.h"
 #include "logpipe.h"
 #include "metrics-pipe.h"
+#include "logpipe-latency.h"
 
 #include <string.h>
 
@@ -1566,6 +1567,28 @@ _verify_unique_persist_names_among_pipes(const GPtrArray *initialized_pipes)
   return result;
 }
 
+static void
+_start_pipe_latency_sampling(CfgTree *self)
+{
+  gint sample_rate = self->cfg->stats_options.pipe_latency_sampling;
+
+  if (sample_rate <= 0)
+    return;
+
+  for (gint i = 0; i < self->initialized_pipes->len; i++)
+    log_pipe_latency_register(g_ptr_array_index(self->initialized_pipes, i));
+  log_pipe_latency_set_sampling(sample_rate);
+}
+
+/* threaded sources and destinations keep posting messages until they are
+ * deinitialized, so the histograms are only freed once all pipes are */
+static void
+_free_pipe_latency_histograms(CfgTree *self)
+{
+  for (gint i = 0; i < self->initialized_pipes->len; i++)
+    log_pipe_latency_unregister(g_ptr_array_index(self->initialized_pipes, i));
+}
+
 gboolean
 cfg_tree_start(CfgTree *self)
 {
@@ -1592,6 +1615,7 @@ cfg_tree_start(CfgTree *self)
         }
     }
 
+  _start_pipe_latency_sampling(self);
   return _verify_unique_persist_names_among_pipes(self->initialized_pipes);
 }
 
@@ -1601,11 +1625,13 @@ cfg_tree_stop(CfgTree *self)
   gboolean success = TRUE;
   gint i;
 
+  log_pipe_latency_set_sampling(0);
   for (i = 0; i < self->initialized_pipes->len; i++)
     {
       if (!log_pipe_deinit(g_ptr_array_index(self->initialized_pipes, i)))
         success = FALSE;
     }
+  _free_pipe_latency_histograms(self);
 
   return success;
 }
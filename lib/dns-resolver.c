@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "dns-resolver.h"
+#include "messages.h"
+
+#include <sys/socket.h>
+#include <netdb.h>
+#include <string.h>
+
+typedef struct _DNSResolverEntry
+{
+  gchar *key;
+  gchar *hostname;
+  gboolean positive;
+  gboolean pending;
+  gint64 resolved;
+} DNSResolverEntry;
+
+typedef struct _DNSResolverRequest
+{
+  gchar *key;
+  GSockAddr *saddr;
+} DNSResolverRequest;
+
+typedef struct _DNSResolver
+{
+  GMutex lock;
+  GCond resolved_cond;
+  GHashTable *cache;
+  /* keys in insertion order, the oldest entries are evicted first */
+  GQueue eviction_order;
+  GThreadPool *workers;
+
+  gint num_threads;
+  gint wait_msec;
+  gint cache_size;
+  gint expire;
+  gint expire_failed;
+  DNSResolverResolveFunc resolve_func;
+} DNSResolver;
+
+static DNSResolver dns_resolver;
+
+static const gchar *
+_resolve_using_getnameinfo(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+  if (getnameinfo(&saddr->sa, saddr->salen, buf, buf_len, NULL, 0, NI_NAMEREQD) == 0)
+    return buf;
+  return NULL;
+}
+
+static void
+_entry_free(DNSResolverEntry *entry)
+{
+  g_free(entry->key);
+  g_free(entry->hostname);
+  g_free(entry);
+}
+
+static gboolean
+_entry_is_expired(DNSResolver *self, DNSResolverEntry *entry, gint64 now)
+{
+  if (entry->pending)
+    return FALSE;
+
+  gint expire = entry->positive ? self->expire : self->expire_failed;
+  return entry->resolved + expire < now;
+}
+
+static void
+_evict_oldest_entries(DNSResolver *self)
+{
+  while ((gint) g_hash_table_size(self->cache) > self->cache_size)
+    {
+      gchar *key = g_queue_pop_head(&self->eviction_order);
+      DNSResolverEntry *entry = g_hash_table_lookup(self->cache, key);
+
+      /* in-flight lookups have to stay reachable for the worker */
+      if (entry->pending)
+        {
+          g_queue_push_tail(&self->eviction_order, key);
+          break;
+        }
+      g_hash_table_remove(self->cache, key);
+    }
+}
+
+static void
+_resolve_request(gpointer data, gpointer user_data)
+{
+  DNSResolver *self = (DNSResolver *) user_data;
+  DNSResolverRequest *request = (DNSResolverRequest *) data;
+  gchar buf[256];
+
+  const gchar *hostname = self->resolve_func(request->saddr, buf, sizeof(buf));
+
+  g_mutex_lock(&self->lock);
+  DNSResolverEntry *entry = g_hash_table_lookup(self->cache, request->key);
+  if (entry)
+    {
+      entry->positive = (hostname != NULL);
+      entry->hostname = g_strdup(hostname ? : request->key);
+      entry->resolved = g_get_monotonic_time() / G_USEC_PER_SEC;
+      entry->pending = FALSE;
+    }
+  g_cond_broadcast(&self->resolved_cond);
+  g_mutex_unlock(&self->lock);
+
+  g_sockaddr_unref(request->saddr);
+  g_free(request->key);
+  g_free(request);
+}
+
+static DNSResolverEntry *
+_start_lookup(DNSResolver *self, const gchar *key, GSockAddr *saddr)
+{
+  DNSResolverEntry *entry = g_new0(DNSResolverEntry, 1);
+  entry->key = g_strdup(key);
+  entry->pending = TRUE;
+
+  g_hash_table_replace(self->cache, entry->key, entry);
+  g_queue_push_tail(&self->eviction_order, entry->key);
+  _evict_oldest_entries(self);
+
+  DNSResolverRequest *request = g_new0(DNSResolverRequest, 1);
+  request->key = g_strdup(key);
+  request->saddr = g_sockaddr_ref(saddr);
+  g_thread_pool_push(self->workers, request, NULL);
+
+  return entry;
+}
+
+/* g_cond_wait_until() releases the lock, meanwhile the entry may be
+ * resolved and then evicted or expired by another caller, so it is looked up
+ * again by its key after each wake-up */
+static DNSResolverEntry *
+_wait_for_entry(DNSResolver *self, const gchar *key)
+{
+  gint64 deadline = g_get_monotonic_time() + self->wait_msec * G_TIME_SPAN_MILLISECOND;
+  DNSResolverEntry *entry = g_hash_table_lookup(self->cache, key);
+  gboolean timed_out = FALSE;
+
+  while (entry && entry->pending && !timed_out)
+    {
+      timed_out = !g_cond_wait_until(&self->resolved_cond, &self->lock, deadline);
+      entry = g_hash_table_lookup(self->cache, key);
+    }
+  return entry;
+}
+
+gboolean
+dns_resolver_is_enabled(void)
+{
+  return dns_resolver.workers != NULL;
+}
+
+/*
+ * Looks up the hostname of saddr in the shared cache, starting a
+ * background lookup if it is not there yet.
+ *
+ * Returns DNS_RESOLVER_RESOLVED if a result was available (possibly after
+ * waiting at most dns-resolver-wait() milliseconds), in which case
+ * @hostname contains the name (@positive is TRUE) or the address (@positive
+ * is FALSE), and DNS_RESOLVER_PENDING if the result is not known yet.
+ */
+DNSResolverResult
+dns_resolver_lookup(GSockAddr *saddr, gchar *hostname, gsize hostname_len, gboolean *positive)
+{
+  DNSResolver *self = &dns_resolver;
+  DNSResolverResult result = DNS_RESOLVER_PENDING;
+  gchar key[64];
+
+  g_sockaddr_format(saddr, key, sizeof(key), GSA_ADDRESS_ONLY);
+
+  g_mutex_lock(&self->lock);
+  DNSResolverEntry *entry = g_hash_table_lookup(self->cache, key);
+
+  if (entry && _entry_is_expired(self, entry, g_get_monotonic_time() / G_USEC_PER_SEC))
+    {
+      g_queue_remove(&self->eviction_order, entry->key);
+      g_hash_table_remove(self->cache, key);
+      entry = NULL;
+    }
+
+  if (!entry)
+    entry = _start_lookup(self, key, saddr);
+
+  if (entry->pending && self->wait_msec > 0)
+    entry = _wait_for_entry(self, key);
+
+  if (entry && !entry->pending)
+    {
+      g_strlcpy(hostname, entry->hostname, hostname_len);
+      *positive = entry->positive;
+      result = DNS_RESOLVER_RESOLVED;
+    }
+  g_mutex_unlock(&self->lock);
+
+  return result;
+}
+
+void
+dns_resolver_set_resolve_func(DNSResolverResolveFunc resolve_func)
+{
+  dns_resolver.resolve_func = resolve_func ? : _resolve_using_getnameinfo;
+}
+
+static void
+_stop_workers(DNSResolver *self)
+{
+  if (!self->workers)
+    return;
+
+  /* finish in-flight lookups, they reference the cache */
+  g_thread_pool_free(self->workers, FALSE, TRUE);
+  self->workers = NULL;
+}
+
+static void
+_clear_cache(DNSResolver *self)
+{
+  g_queue_clear(&self->eviction_order);
+  g_hash_table_remove_all(self->cache);
+}
+
+void
+dns_resolver_update_options(const DNSCacheOptions *dns_cache_options)
+{
+  DNSResolver *self = &dns_resolver;
+
+  if (self->num_threads != dns_cache_options->resolver_threads)
+    {
+      _stop_workers(self);
+      self->num_threads = dns_cache_options->resolver_threads;
+
+      if (self->num_threads > 0)
+        self->workers = g_thread_pool_new(_resolve_request, self, self->num_threads, FALSE, NULL);
+    }
+
+  g_mutex_lock(&self->lock);
+  self->wait_msec = dns_cache_options->resolver_wait;
+  self->cache_size = dns_cache_options->cache_size;
+  self->expire = dns_cache_options->expire;
+  self->expire_failed = dns_cache_options->expire_failed;
+
+  if (!self->workers)
+    _clear_cache(self);
+  g_mutex_unlock(&self->lock);
+}
+
+void
+dns_resolver_global_init(void)
+{
+  DNSResolver *self = &dns_resolver;
+
+  g_mutex_init(&self->lock);
+  g_cond_init(&self->resolved_cond);
+  self->cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify) _entry_free);
+  g_queue_init(&self->eviction_order);
+  self->resolve_func = _resolve_using_getnameinfo;
+}
+
+void
+dns_resolver_global_deinit(void)
+{
+  DNSResolver *self = &dns_resolver;
+
+  _stop_workers(self);
+  self->num_threads = 0;
+
+  _clear_cache(self);
+  g_hash_table_destroy(self->cache);
+  g_cond_clear(&self->resolved_cond);
+  g_mutex_clear(&self->lock);
+}
@@ -361,6 +361,8 @@ dns_cache_options_defaults(DNSCacheOptions *options)
   options->expire = 3600;
   options->expire_failed = 60;
   options->hosts = NULL;
+  options->resolver_threads = 0;
+  options->resolver_wait = 0;
 }
 
 void
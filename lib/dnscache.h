@@ -34,6 +34,8 @@ typedef struct
   gint expire;
   gint expire_failed;
   gchar *hosts;
+  gint resolver_threads;
+  gint resolver_wait;
 } DNSCacheOptions;
 
 typedef struct _DNSCache DNSCache;
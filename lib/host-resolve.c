@@ -23,6 +23,7 @@
 #include "host-resolve.h"
 #include "hostname.h"
 #include "dnscache.h"
+#include "dns-resolver.h"
 #include "messages.h"
 #include "cfg.h"
 #include "tls-support.h"
@@ -360,7 +361,19 @@ resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
         return hostname_apply_options_fqdn(hname_len, result_len, hname, positive, host_resolve_options);
     }
 
-  if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
+  if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2 && dns_resolver_is_enabled())
+    {
+      if (dns_resolver_lookup(saddr, hostname_buffer, sizeof(hostname_buffer), &positive) == DNS_RESOLVER_PENDING)
+        {
+          /* the name is not known yet, use the address for now without
+           * caching it, later messages will pick up the resolved name */
+          hname = g_sockaddr_format(saddr, hostname_buffer, sizeof(hostname_buffer), GSA_ADDRESS_ONLY);
+          return hostname_apply_options_fqdn(-1, result_len, hname, FALSE, host_resolve_options);
+        }
+
+      hname = positive ? hostname_buffer : NULL;
+    }
+  else if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
     {
 #ifdef SYSLOG_NG_HAVE_GETNAMEINFO
       hname = resolve_address_using_getnameinfo(saddr, hostname_buffer, sizeof(hostname_buffer));
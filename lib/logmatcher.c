@@ -278,9 +278,89 @@ log_matcher_glob_new(const LogMatcherOptions *options)
 
 /* libpcre support */
 
+/*
+ * Compiled (and JIT compiled) patterns are shared between matchers using
+ * the same expression with the same flags.  They are read-only once
+ * compiled, and since a new configuration is parsed while the old one is
+ * still running, sharing them means that a reload doesn't compile and JIT
+ * the regular expressions that didn't change.
+ */
+typedef struct _PcreCacheEntry
+{
+  gint ref_cnt;
+  gchar *key;
+  pcre2_code *pattern;
+} PcreCacheEntry;
+
+static GHashTable *pcre_cache;
+static GMutex pcre_cache_lock;
+
+static PcreCacheEntry *
+_pcre_cache_lookup(const gchar *key)
+{
+  PcreCacheEntry *entry = NULL;
+
+  g_mutex_lock(&pcre_cache_lock);
+  if (pcre_cache)
+    entry = g_hash_table_lookup(pcre_cache, key);
+  if (entry)
+    entry->ref_cnt++;
+  g_mutex_unlock(&pcre_cache_lock);
+  return entry;
+}
+
+/* takes over @key and @pattern */
+static PcreCacheEntry *
+_pcre_cache_add(gchar *key, pcre2_code *pattern)
+{
+  PcreCacheEntry *entry;
+
+  g_mutex_lock(&pcre_cache_lock);
+  if (!pcre_cache)
+    pcre_cache = g_hash_table_new(g_str_hash, g_str_equal);
+
+  entry = g_hash_table_lookup(pcre_cache, key);
+  if (entry)
+    {
+      /* compiled in parallel by someone else */
+      g_free(key);
+      pcre2_code_free(pattern);
+    }
+  else
+    {
+      entry = g_new0(PcreCacheEntry, 1);
+      entry->key = key;
+      entry->pattern = pattern;
+      g_hash_table_insert(pcre_cache, entry->key, entry);
+    }
+  entry->ref_cnt++;
+  g_mutex_unlock(&pcre_cache_lock);
+  return entry;
+}
+
+static void
+_pcre_cache_release(PcreCacheEntry *entry)
+{
+  g_mutex_lock(&pcre_cache_lock);
+  if (--entry->ref_cnt == 0)
+    {
+      g_hash_table_remove(pcre_cache, entry->key);
+      if (g_hash_table_size(pcre_cache) == 0)
+        {
+          g_hash_table_destroy(pcre_cache);
+          pcre_cache = NULL;
+        }
+      pcre2_code_free(entry->pattern);
+      g_free(entry->key);
+      g_free(entry);
+    }
+  g_mutex_unlock(&pcre_cache_lock);
+}
+
 typedef struct _LogMatcherPcreRe
 {
   LogMatcher super;
+  PcreCacheEntry *cached_pattern;
   pcre2_code *pattern;
   gint match_options;
   gchar *nv_prefix;
@@ -288,12 +368,9 @@ typedef struct _LogMatcherPcreRe
 } LogMatcherPcreRe;
 
 static gboolean
-_compile_pcre2_regexp(LogMatcherPcreRe *self, const gchar *re, GError **error)
+_get_pcre2_compile_flags(LogMatcherPcreRe *self, guint32 *compile_flags, GError **error)
 {
-  gint rc;
-  gint flags = 0;
-
-  g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+  guint32 flags = 0;
 
   if (self->super.flags & LMF_ICASE)
     flags |= PCRE2_CASELESS;
@@ -325,6 +402,15 @@ _compile_pcre2_regexp(LogMatcherPcreRe *self, const gchar *re, GError **error)
       flags |= PCRE2_DUPNAMES;
     }
 
+  *compile_flags = flags;
+  return TRUE;
+}
+
+static gboolean
+_compile_pcre2_regexp(LogMatcherPcreRe *self, const gchar *re, guint32 flags, GError **error)
+{
+  gint rc;
+
   /* compile the regexp */
   PCRE2_SIZE error_offset;
 
@@ -361,20 +447,54 @@ _jit_pcre2_regexp(LogMatcherPcreRe *self, const gchar *re, GError **error)
   return TRUE;
 }
 
+static void
+_release_pcre2_regexp(LogMatcherPcreRe *self)
+{
+  if (self->cached_pattern)
+    _pcre_cache_release(self->cached_pattern);
+  self->cached_pattern = NULL;
+  self->pattern = NULL;
+}
+
 static gboolean
 log_matcher_pcre_re_compile(LogMatcher *s, const gchar *re, GError **error)
 {
   LogMatcherPcreRe *self = (LogMatcherPcreRe *) s;
+  guint32 flags;
 
   g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
   log_matcher_store_pattern(s, re);
+  _release_pcre2_regexp(self);
 
-  if (!_compile_pcre2_regexp(self, re, error))
+  if (!_get_pcre2_compile_flags(self, &flags, error))
     return FALSE;
 
+  gchar *key = g_strdup_printf("%x:%d:%s", flags, !(self->super.flags & LMF_DISABLE_JIT), re);
+
+  self->cached_pattern = _pcre_cache_lookup(key);
+  if (self->cached_pattern)
+    {
+      g_free(key);
+      self->pattern = self->cached_pattern->pattern;
+      return TRUE;
+    }
+
+  if (!_compile_pcre2_regexp(self, re, flags, error))
+    {
+      g_free(key);
+      return FALSE;
+    }
+
   if (!_jit_pcre2_regexp(self, re, error))
-    return FALSE;
+    {
+      pcre2_code_free(self->pattern);
+      self->pattern = NULL;
+      g_free(key);
+      return FALSE;
+    }
 
+  self->cached_pattern = _pcre_cache_add(key, self->pattern);
+  self->pattern = self->cached_pattern->pattern;
   return TRUE;
 }
 
@@ -691,7 +811,8 @@ static void
 log_matcher_pcre_re_free(LogMatcher *s)
 {
   LogMatcherPcreRe *self = (LogMatcherPcreRe *) s;
-  pcre2_code_free(self->pattern);
+
+  _release_pcre2_regexp(self);
   log_matcher_free_method(s);
 }
 
@@ -729,6 +850,15 @@ log_matcher_pcre_set_nv_prefix(LogMatcher *s, const gchar *prefix)
     }
 }
 
+/* the compiled pattern is shared by the matchers with the same regexp and flags */
+gconstpointer
+log_matcher_pcre_get_compiled_pattern(LogMatcher *s)
+{
+  LogMatcherPcreRe *self = (LogMatcherPcreRe *) s;
+
+  return self->pattern;
+}
+
 typedef LogMatcher *(*LogMatcherConstructFunc)(const LogMatcherOptions *options);
 
 gboolean
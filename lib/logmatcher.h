@@ -129,5 +129,6 @@ void log_matcher_options_init(LogMatcherOptions *options);
 void log_matcher_options_destroy(LogMatcherOptions *options);
 
 void log_matcher_pcre_set_nv_prefix(LogMatcher *s, const gchar *prefix);
+gconstpointer log_matcher_pcre_get_compiled_pattern(LogMatcher *s);
 
 #endif
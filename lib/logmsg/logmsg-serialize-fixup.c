@@ -25,6 +25,7 @@
  */
 #include "logmsg-serialize-fixup.h"
 #include "nvtable-serialize.h"
+#include "tls-support.h"
 
 #include <stdlib.h>
 
@@ -104,8 +105,29 @@ log_msg_map_legacy_dbparser_type_to_generic_type(guint8 dbparser_type)
  *   - the SDATA handles array that ensures that SDATA values are ordered
  *     the same way they were received.
  *
+ * Messages read back from the same source share the same old handles, so
+ * the old -> new mapping is cached per thread.  A cached mapping is only
+ * used if the name of the new handle matches the name stored in the entry,
+ * so a stale or colliding slot costs just a registry lookup by name.
+ *
  **********************************************************************/
 
+#define HANDLE_REMAP_CACHE_SIZE 1024
+
+typedef struct _HandleRemapCacheEntry
+{
+  NVHandle old_handle;
+  NVHandle new_handle;
+} HandleRemapCacheEntry;
+
+TLS_BLOCK_START
+{
+  HandleRemapCacheEntry handle_remap_cache[HANDLE_REMAP_CACHE_SIZE];
+}
+TLS_BLOCK_END;
+
+#define handle_remap_cache  __tls_deref(handle_remap_cache)
+
 static gint
 _index_entry_cmp(const void *a, const void *b)
 {
@@ -128,11 +150,28 @@ _copy_updated_sdata_handles(LogMessageSerializationState *state)
   memcpy(state->msg->sdata, state->updated_sdata_handles, sizeof(state->msg->sdata[0]) * state->msg->num_sdata);
 }
 
+static gboolean
+_is_updated_index_sorted(LogMessageSerializationState *state)
+{
+  NVTable *self = state->nvtable;
+
+  for (gint i = 1; i < self->index_size; i++)
+    {
+      if (state->updated_index[i - 1].handle > state->updated_index[i].handle)
+        return FALSE;
+    }
+  return TRUE;
+}
+
 static void
 _sort_updated_index(LogMessageSerializationState *state)
 {
   NVTable *self = state->nvtable;
 
+  /* handles allocated in the same order keep the index sorted */
+  if (_is_updated_index_sorted(state))
+    return;
+
   qsort(state->updated_index, self->index_size, sizeof(NVIndexEntry), _index_entry_cmp);
 }
 
@@ -180,16 +219,16 @@ _is_static_entry(NVEntry *entry)
 }
 
 static gboolean
-_old_handle_has_the_same_name(NVHandle old_handle, NVEntry *entry)
+_handle_has_the_same_name(NVHandle handle, NVEntry *entry)
 {
-  gssize old_handle_name_len = 0;
-  const gchar *old_handle_name = log_msg_get_value_name(old_handle, &old_handle_name_len);
+  gssize handle_name_len = 0;
+  const gchar *handle_name = log_msg_get_value_name(handle, &handle_name_len);
 
-  if (!old_handle_name)
+  if (!handle_name)
     return FALSE;
-  if (old_handle_name_len != entry->name_len)
+  if (handle_name_len != entry->name_len)
     return FALSE;
-  return memcmp(nv_entry_get_name(entry), old_handle_name, old_handle_name_len) == 0;
+  return memcmp(nv_entry_get_name(entry), handle_name, handle_name_len) == 0;
 }
 
 static NVHandle
@@ -198,10 +237,17 @@ _allocate_handle_for_entry_name(NVHandle old_handle, NVEntry *entry)
   if (_is_static_entry(entry))
     return old_handle;
 
-  if (_old_handle_has_the_same_name(old_handle, entry))
+  if (_handle_has_the_same_name(old_handle, entry))
     return old_handle;
 
-  return log_msg_get_value_handle(nv_entry_get_name(entry));
+  HandleRemapCacheEntry *cached = &handle_remap_cache[old_handle % HANDLE_REMAP_CACHE_SIZE];
+  if (cached->old_handle == old_handle && _handle_has_the_same_name(cached->new_handle, entry))
+    return cached->new_handle;
+
+  NVHandle new_handle = log_msg_get_value_handle(nv_entry_get_name(entry));
+  cached->old_handle = old_handle;
+  cached->new_handle = new_handle;
+  return new_handle;
 }
 
 static NVHandle
@@ -45,15 +45,6 @@ _setup_ts_processed(UnixTime *timestamps, const UnixTime *processed)
     timestamps[LM_TS_PROCESSED] = timestamps[LM_TS_RECVD];
 }
 
-static void
-nv_table_serialize_with_compaction(LogMessageSerializationState *state, NVTable *old)
-{
-  NVTable *payload;
-  payload = nv_table_compact(old);
-  nv_table_serialize(state, payload);
-  nv_table_unref(payload);
-};
-
 static gboolean
 _serialize_message(LogMessageSerializationState *state)
 {
@@ -80,7 +71,7 @@ _serialize_message(LogMessageSerializationState *state)
   serialize_write_uint32_array(sa, (guint32 *) msg->sdata, msg->num_sdata);
 
   if (state->flags & LMSF_COMPACTION)
-    nv_table_serialize_with_compaction(state, msg->payload);
+    nv_table_serialize_compact(state, msg->payload);
   else
     nv_table_serialize(state, msg->payload);
   return TRUE;
@@ -92,6 +83,8 @@ log_msg_serialize_with_ts_processed(LogMessage *self, SerializeArchive *sa, cons
   LogMessageSerializationState state = { 0 };
 
   state.version = LGM_V26;
+  log_msg_materialize_sdata(self);
+
   state.msg = self;
   state.sa = sa;
   state.processed = processed;
@@ -305,13 +305,65 @@ static StatsCounterItem *count_payload_reallocs;
 static StatsCounterItem *count_sdata_updates;
 static StatsCounterItem *count_allocated_bytes;
 static GPrivate priv_macro_value = G_PRIVATE_INIT(__free_macro_value);
+/* lazy SDATA decoding */
+static NVHandle lazy_sdata_handle;
+static LogMessageSDataDecoder sdata_decoder;
 
 void
 log_msg_write_protect(LogMessage *self)
 {
+  /* once write protected, the message may be shared between threads, so
+   * we can't decode SDATA on demand anymore */
+  log_msg_materialize_sdata(self);
   self->write_protected = TRUE;
 }
 
+void
+log_msg_register_sdata_decoder(LogMessageSDataDecoder decoder)
+{
+  sdata_decoder = decoder;
+}
+
+/*
+ * Store the raw SDATA block of the message and postpone decoding it into
+ * name-value pairs until an SDATA value is first accessed.  Parsers that
+ * use this need to register a decoder via log_msg_register_sdata_decoder().
+ */
+void
+log_msg_set_lazy_sdata(LogMessage *self, const gchar *raw_sdata, gsize raw_sdata_len)
+{
+  g_assert(sdata_decoder);
+
+  log_msg_set_value(self, lazy_sdata_handle, raw_sdata, raw_sdata_len);
+  log_msg_set_flag(self, LF_STATE_LAZY_SDATA);
+}
+
+void
+log_msg_materialize_sdata(LogMessage *self)
+{
+  if (!log_msg_chk_flag(self, LF_STATE_LAZY_SDATA))
+    return;
+
+  g_assert(!log_msg_is_write_protected(self));
+  self->flags &= ~LF_STATE_LAZY_SDATA;
+
+  gssize raw_sdata_len;
+  const gchar *value = log_msg_get_value(self, lazy_sdata_handle, &raw_sdata_len);
+
+  /* decoding may reallocate the payload, so don't point into it */
+  gchar *raw_sdata = g_strndup(value, raw_sdata_len);
+  log_msg_unset_value(self, lazy_sdata_handle);
+  sdata_decoder(self, raw_sdata, raw_sdata_len);
+  g_free(raw_sdata);
+}
+
+static inline void
+_materialize_sdata_before_update(LogMessage *self, NVHandle handle)
+{
+  if (G_UNLIKELY(log_msg_chk_flag(self, LF_STATE_LAZY_SDATA)) && log_msg_is_handle_sdata(handle))
+    log_msg_materialize_sdata(self);
+}
+
 LogMessage *
 log_msg_make_writable(LogMessage **pself, const LogPathOptions *path_options)
 {
@@ -497,8 +549,12 @@ log_msg_get_macro_value(const LogMessage *self, gint id, gssize *value_len, LogM
   return value->str;
 }
 
+/* upper limit of the LogMessageQueueNodes preallocated in the LogMessage
+ * structure, the nodes needed by further queues come from the queue's own
+ * node pool (see logqueue-fifo.c) or from the heap */
+#define LOGMSG_EMBEDDED_QUEUE_NODES_MAX 32
 
-static void
+void
 log_msg_init_queue_node(LogMessage *msg, LogMessageQueueNode *node, const LogPathOptions *path_options)
 {
   INIT_IV_LIST_HEAD(&node->list);
@@ -517,15 +573,25 @@ log_msg_init_queue_node(LogMessage *msg, LogMessageQueueNode *node, const LogPat
  */
 LogMessageQueueNode *
 log_msg_alloc_queue_node(LogMessage *msg, const LogPathOptions *path_options)
+{
+  LogMessageQueueNode *node = log_msg_alloc_embedded_queue_node(msg, path_options);
+
+  if (node)
+    return node;
+  return log_msg_alloc_dynamic_queue_node(msg, path_options);
+}
+
+/*
+ * Returns one of the LogMessageQueueNode instances preallocated in the
+ * message or NULL if those are used up already.  Same threading
+ * assumptions as log_msg_alloc_queue_node().
+ */
+LogMessageQueueNode *
+log_msg_alloc_embedded_queue_node(LogMessage *msg, const LogPathOptions *path_options)
 {
   LogMessageQueueNode *node;
 
-  if (msg->cur_node < msg->num_nodes)
-    {
-      node = &msg->nodes[msg->cur_node++];
-      node->embedded = TRUE;
-    }
-  else
+  if (msg->cur_node >= msg->num_nodes)
     {
       gint nodes = (volatile gint) logmsg_queue_node_max;
 
@@ -534,14 +600,16 @@ log_msg_alloc_queue_node(LogMessage *msg, const LogPathOptions *path_options)
        * for some time yet, since the smaller number only means that we
        * pre-allocate somewhat less LogMsgQueueNodes in the message
        * structure, but will be fine regardless (if we'd overflow the
-       * pre-allocated space, we start allocating nodes dynamically from
-       * heap.
+       * pre-allocated space, the nodes come from the pool of the queue or
+       * from the heap).
        */
-      if (nodes < 32 && nodes <= msg->num_nodes)
+      if (nodes < LOGMSG_EMBEDDED_QUEUE_NODES_MAX && nodes <= msg->num_nodes)
         logmsg_queue_node_max = msg->num_nodes + 1;
-      node = g_slice_new(LogMessageQueueNode);
-      node->embedded = FALSE;
+      return NULL;
     }
+
+  node = &msg->nodes[msg->cur_node++];
+  node->embedded = TRUE;
   log_msg_init_queue_node(msg, node, path_options);
   return node;
 }
@@ -609,6 +677,8 @@ log_msg_set_value_with_type(LogMessage *self, NVHandle handle,
   if (handle == LM_V_NONE)
     return;
 
+  _materialize_sdata_before_update(self, handle);
+
   name_len = 0;
   name = log_msg_get_value_name(handle, &name_len);
 
@@ -673,6 +743,8 @@ log_msg_unset_value(LogMessage *self, NVHandle handle)
 {
   g_assert(!log_msg_is_write_protected(self));
 
+  _materialize_sdata_before_update(self, handle);
+
   if (_log_name_value_updates(self))
     {
       msg_trace("Unsetting value",
@@ -731,6 +803,8 @@ log_msg_set_value_indirect_with_type(LogMessage *self, NVHandle handle,
 
   g_assert(handle >= LM_V_MAX);
 
+  _materialize_sdata_before_update(self, handle);
+
   name_len = 0;
   name = log_msg_get_value_name(handle, &name_len);
 
@@ -787,6 +861,7 @@ log_msg_set_value_indirect(LogMessage *self, NVHandle handle, NVHandle ref_handl
 gboolean
 log_msg_values_foreach(const LogMessage *self, NVTableForeachFunc func, gpointer user_data)
 {
+  log_msg_ensure_sdata(self);
   return nv_table_foreach(self->payload, logmsg_registry, func, user_data);
 }
 
@@ -994,7 +1069,8 @@ log_msg_set_tag_by_id_onoff(LogMessage *self, LogTagId id, gboolean on)
     {
       /* we can't put this tag inline, either because it is too large, or we don't have the inline space any more */
 
-      if ((self->num_tags * LOGMSG_TAGS_BITS) <= id)
+      /* clearing a tag beyond the stored ones is a no-op, don't grow the array for it */
+      if (on && (self->num_tags * LOGMSG_TAGS_BITS) <= id)
         {
           if (G_UNLIKELY(8159 < id))
             {
@@ -1015,7 +1091,8 @@ log_msg_set_tag_by_id_onoff(LogMessage *self, LogTagId id, gboolean on)
             self->tags[0] = (gulong) old_tags;
         }
 
-      log_msg_set_bit(self->tags, id, on);
+      if (id < self->num_tags * LOGMSG_TAGS_BITS)
+        log_msg_set_bit(self->tags, id, on);
     }
   if (on)
     {
@@ -1126,6 +1203,7 @@ log_msg_append_format_sdata(const LogMessage *self, GString *result,  guint32 se
   gboolean has_seq_num = FALSE;
   const gchar *seqid;
 
+  log_msg_ensure_sdata(self);
   if (!meta_seqid)
     meta_seqid = log_msg_get_value_handle(".SDATA.meta.sequenceId");
 
@@ -2045,6 +2123,8 @@ log_msg_registry_init(void)
       match_handles[i] = nv_registry_alloc_handle(logmsg_registry, buf);
       nv_registry_set_handle_flags(logmsg_registry, match_handles[i], (i << 8) + LM_VF_MATCH);
     }
+
+  lazy_sdata_handle = nv_registry_alloc_handle(logmsg_registry, "._LAZY_SDATA");
 }
 
 void
@@ -155,6 +155,10 @@ enum
   /* part of the state that is kept across clones */
   LF_STATE_CLONED_MASK = 0xFE00,
   LF_STATE_TRACING     = 0x0200,
+  /* SDATA is kept in its raw form until first accessed, see
+   * log_msg_set_lazy_sdata().  It is never set on a write protected (and
+   * thus on a cloned) message. */
+  LF_STATE_LAZY_SDATA  = 0x0400,
 
   LF_CHAINED_HOSTNAME  = 0x00010000,
 
@@ -215,8 +219,10 @@ typedef struct _LogMessageQueueNode
 
 
 /* NOTE: the members are ordered according to the presumed use frequency.
- * The structure itself is 2 cachelines, the border is right after the "msg"
- * member */
+ * The pointers and the flags that are touched for every message (refcount,
+ * payload, timestamps, tags, flags) come first and span exactly 2
+ * cachelines, everything used only by specific drivers or macros (rcptid,
+ * host_id, the raw message size) is packed after them, without holes.  */
 struct _LogMessage
 {
   /* if you change any of the fields here, be sure to adjust
@@ -229,10 +235,6 @@ struct _LogMessage
    * log_msg_ref/unref.
    */
 
-  /* FIXME: the structure has holes, but right now it's 1 byte short to make
-   * it smaller (it is possible to create a 7 byte contiguos block but 8
-   * byte alignment is needed. Let's check this with the inline-tags stuff */
-
   gint ack_and_ref_and_abort_and_suspended;
 
   /* NOTE: in theory this should be a size_t (or gsize), however that takes
@@ -241,8 +243,6 @@ struct _LogMessage
 
   guint allocated_bytes;
 
-  guint32 recvd_rawmsg_size;
-
   AckRecord *ack_record;
   LMAckFunc ack_func;
   LogMessage *original;
@@ -277,8 +277,9 @@ struct _LogMessage
 
          proto:6;
   guint8 num_matches;
-  guint32 host_id;
   guint64 rcptid;
+  guint32 host_id;
+  guint32 recvd_rawmsg_size;
   guint8 num_tags;
   guint8 alloc_sdata;
   guint8 num_sdata;
@@ -310,6 +311,24 @@ log_msg_is_write_protected(const LogMessage *self)
   return self->write_protected;
 }
 
+typedef void (*LogMessageSDataDecoder)(LogMessage *msg, const gchar *raw_sdata, gsize raw_sdata_len);
+
+void log_msg_register_sdata_decoder(LogMessageSDataDecoder decoder);
+void log_msg_set_lazy_sdata(LogMessage *self, const gchar *raw_sdata, gsize raw_sdata_len);
+void log_msg_materialize_sdata(LogMessage *self);
+
+/*
+ * A message with lazy SDATA is never write protected, so it is still owned
+ * by the thread accessing it, which makes it safe to decode SDATA in place
+ * even if we only have a const pointer to it.
+ */
+static inline void
+log_msg_ensure_sdata(const LogMessage *self)
+{
+  if (G_UNLIKELY(self->flags & LF_STATE_LAZY_SDATA))
+    log_msg_materialize_sdata((LogMessage *) self);
+}
+
 LogMessage *log_msg_clone_cow(LogMessage *msg, const LogPathOptions *path_options);
 LogMessage *log_msg_make_writable(LogMessage **pmsg, const LogPathOptions *path_options);
 
@@ -367,13 +386,17 @@ log_msg_get_value_if_set_with_type(const LogMessage *self, NVHandle handle,
   flags = nv_registry_get_handle_flags(logmsg_registry, handle);
   if (G_UNLIKELY((flags & LM_VF_MACRO)))
     return log_msg_get_macro_value(self, flags >> 8, value_len, type);
-  else
-    return nv_table_get_value(self->payload, handle, value_len, type);
+
+  if (G_UNLIKELY((flags & LM_VF_SDATA)))
+    log_msg_ensure_sdata(self);
+  return nv_table_get_value(self->payload, handle, value_len, type);
 }
 
 static inline gboolean
 log_msg_is_value_set(const LogMessage *self, NVHandle handle)
 {
+  if (G_UNLIKELY(self->flags & LF_STATE_LAZY_SDATA) && log_msg_is_handle_sdata(handle))
+    log_msg_materialize_sdata((LogMessage *) self);
   return nv_table_is_value_set(self->payload, handle);
 }
 
@@ -508,6 +531,8 @@ void log_msg_set_daddr_ref(LogMessage *self, GSockAddr *daddr);
 
 LogMessageQueueNode *log_msg_alloc_queue_node(LogMessage *msg, const LogPathOptions *path_options);
 LogMessageQueueNode *log_msg_alloc_dynamic_queue_node(LogMessage *msg, const LogPathOptions *path_options);
+LogMessageQueueNode *log_msg_alloc_embedded_queue_node(LogMessage *msg, const LogPathOptions *path_options);
+void log_msg_init_queue_node(LogMessage *msg, LogMessageQueueNode *node, const LogPathOptions *path_options);
 void log_msg_free_queue_node(LogMessageQueueNode *node);
 
 void log_msg_clear(LogMessage *self);
@@ -250,3 +250,172 @@ nv_table_serialize(LogMessageSerializationState *state, NVTable *self)
   _write_payload(sa, self);
   return TRUE;
 }
+
+/**********************************************************************
+ * serialize an NVTable, leaving out the space of overwritten entries
+ **********************************************************************/
+
+#define NV_TABLE_COMPACT_PREALLOC_ENTRIES 64
+
+typedef struct _NVTableLiveEntry
+{
+  guint32 ofs;
+  guint32 new_ofs;
+} NVTableLiveEntry;
+
+typedef struct _NVTableCompactLayout
+{
+  NVTableLiveEntry *entries;
+  gint num_entries;
+  guint32 used;
+  NVTableLiveEntry prealloc[NV_TABLE_COMPACT_PREALLOC_ENTRIES];
+} NVTableCompactLayout;
+
+static gint
+_compare_live_entries(gconstpointer a, gconstpointer b)
+{
+  guint32 ofs_a = ((const NVTableLiveEntry *) a)->ofs;
+  guint32 ofs_b = ((const NVTableLiveEntry *) b)->ofs;
+
+  return (ofs_a > ofs_b) - (ofs_a < ofs_b);
+}
+
+static void
+_add_live_entry(NVTableCompactLayout *layout, NVTable *self, guint32 ofs)
+{
+  NVEntry *entry = nv_table_get_entry_at_ofs(self, ofs);
+
+  /* unset entries are left out, just like nv_table_compact() does */
+  if (!entry || entry->unset)
+    return;
+
+  layout->entries[layout->num_entries++].ofs = ofs;
+}
+
+/*
+ * Entries keep their relative order and are only shifted towards the top
+ * over the holes left behind by overwritten values, so each one moves by
+ * the size of the holes above it.
+ */
+static void
+_calculate_compact_layout(NVTableCompactLayout *layout, NVTable *self)
+{
+  NVIndexEntry *index_table = nv_table_get_index(self);
+  gint max_entries = self->num_static_entries + self->index_size;
+
+  layout->entries = max_entries > NV_TABLE_COMPACT_PREALLOC_ENTRIES
+                    ? g_new(NVTableLiveEntry, max_entries)
+                    : layout->prealloc;
+  layout->num_entries = 0;
+
+  for (gint i = 0; i < self->num_static_entries; i++)
+    _add_live_entry(layout, self, self->static_entries[i]);
+  for (gint i = 0; i < self->index_size; i++)
+    _add_live_entry(layout, self, index_table[i].ofs);
+
+  qsort(layout->entries, layout->num_entries, sizeof(layout->entries[0]), _compare_live_entries);
+
+  layout->used = 0;
+  for (gint i = 0; i < layout->num_entries; i++)
+    {
+      NVEntry *entry = nv_table_get_entry_at_ofs(self, layout->entries[i].ofs);
+
+      layout->used += entry->alloc_len;
+      layout->entries[i].new_ofs = layout->used;
+    }
+}
+
+static void
+_free_compact_layout(NVTableCompactLayout *layout)
+{
+  if (layout->entries != layout->prealloc)
+    g_free(layout->entries);
+}
+
+static guint32
+_remap_ofs(NVTableCompactLayout *layout, guint32 ofs)
+{
+  NVTableLiveEntry key = { .ofs = ofs };
+  NVTableLiveEntry *live_entry;
+
+  if (!ofs)
+    return 0;
+
+  live_entry = bsearch(&key, layout->entries, layout->num_entries, sizeof(key), _compare_live_entries);
+  return live_entry ? live_entry->new_ofs : 0;
+}
+
+/*
+ * Dynamic entries that are not part of the layout (unset ones) are left out
+ * of the index altogether, just like nv_table_compact() does.  Keeping them
+ * with a zero offset would leave holes in the index that the handle fixup
+ * after deserialization skips.
+ */
+static void
+_write_compact_struct(SerializeArchive *sa, NVTable *self, NVTableCompactLayout *layout)
+{
+  NVIndexEntry *index_table = nv_table_get_index(self);
+  guint16 index_size = 0;
+
+  for (gint i = 0; i < self->index_size; i++)
+    {
+      if (_remap_ofs(layout, index_table[i].ofs))
+        index_size++;
+    }
+
+  serialize_write_uint32(sa, self->size);
+  serialize_write_uint32(sa, layout->used);
+  serialize_write_uint16(sa, index_size);
+  serialize_write_uint8(sa, self->num_static_entries);
+
+  for (gint i = 0; i < self->num_static_entries; i++)
+    serialize_write_uint32(sa, _remap_ofs(layout, self->static_entries[i]));
+
+  for (gint i = 0; i < self->index_size; i++)
+    {
+      guint32 ofs = _remap_ofs(layout, index_table[i].ofs);
+
+      if (!ofs)
+        continue;
+
+      serialize_write_uint32(sa, index_table[i].handle);
+      serialize_write_uint32(sa, ofs);
+    }
+}
+
+/* entries are written bottom up, adjacent live entries in a single blob */
+static void
+_write_compact_payload(SerializeArchive *sa, NVTable *self, NVTableCompactLayout *layout)
+{
+  gint i = layout->num_entries - 1;
+
+  while (i >= 0)
+    {
+      guint32 run_ofs = layout->entries[i].ofs;
+      guint32 run_len = nv_table_get_entry_at_ofs(self, run_ofs)->alloc_len;
+
+      for (i--; i >= 0 && layout->entries[i].ofs == run_ofs - run_len; i--)
+        run_len += nv_table_get_entry_at_ofs(self, layout->entries[i].ofs)->alloc_len;
+
+      serialize_archive_write_bytes(sa, nv_table_get_top(self) - run_ofs, run_len);
+    }
+}
+
+gboolean
+nv_table_serialize_compact(LogMessageSerializationState *state, NVTable *self)
+{
+  NVTableMetaData meta_data = { 0 };
+  NVTableCompactLayout layout;
+  SerializeArchive *sa = state->sa;
+
+  _calculate_compact_layout(&layout, self);
+
+  _fill_meta_data(self, &meta_data);
+  _write_meta_data(sa, &meta_data);
+
+  _write_compact_struct(sa, self, &layout);
+  _write_compact_payload(sa, self, &layout);
+
+  _free_compact_layout(&layout);
+  return TRUE;
+}
@@ -38,6 +38,7 @@
 
 NVTable *nv_table_deserialize(LogMessageSerializationState *state);
 gboolean nv_table_serialize(LogMessageSerializationState *state, NVTable *self);
+gboolean nv_table_serialize_compact(LogMessageSerializationState *state, NVTable *self);
 gboolean nv_table_fixup_handles(LogMessageSerializationState *state);
 
 #endif
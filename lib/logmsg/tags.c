@@ -29,6 +29,8 @@
 #include "stats/stats-cluster-single.h"
 #include "apphook.h"
 
+#include <string.h>
+
 typedef struct _LogTag
 {
   LogTagId id;
@@ -36,19 +38,91 @@ typedef struct _LogTag
   StatsCounterItem *counter;
 } LogTag;
 
-static GArray *log_tags;
-static GHashTable *log_tags_hash = NULL;
+/*
+ * The tag registry is read from the message processing threads (tag
+ * counters, $TAGS, name resolution for templated tag names), while it is
+ * only extended when a previously unseen tag name is resolved.  Reads are
+ * therefore lock-free, writers are serialized by log_tags_lock:
+ *
+ *   - LogTag entries live in fixed chunks that are never moved or freed
+ *     until log_tags_global_deinit(), an entry is published by setting
+ *     its name
+ *
+ *   - names are resolved through an open addressing hash table with
+ *     LOG_TAGS_HASH_SIZE slots (twice the possible number of tags, so it
+ *     never fills up), a slot is published by storing id + 1 into it,
+ *     after the entry itself was published
+ */
+#define LOG_TAGS_CHUNK_SHIFT  8
+#define LOG_TAGS_CHUNK_SIZE   (1 << LOG_TAGS_CHUNK_SHIFT)
+#define LOG_TAGS_CHUNK_MASK   (LOG_TAGS_CHUNK_SIZE - 1)
+#define LOG_TAGS_NUM_CHUNKS   (LOG_TAGS_MAX / LOG_TAGS_CHUNK_SIZE)
+#define LOG_TAGS_HASH_SIZE    (LOG_TAGS_MAX * 2)
+
+static LogTag *log_tags_chunks[LOG_TAGS_NUM_CHUNKS];
+static gint *log_tags_hash = NULL;
+static guint log_tags_len;
 static GMutex log_tags_lock;
 
+static inline LogTag *
+_lookup_tag(guint id)
+{
+  if (id >= LOG_TAGS_MAX)
+    return NULL;
+
+  LogTag *chunk = g_atomic_pointer_get(&log_tags_chunks[id >> LOG_TAGS_CHUNK_SHIFT]);
+  if (!chunk)
+    return NULL;
+
+  LogTag *tag = &chunk[id & LOG_TAGS_CHUNK_MASK];
+  if (!g_atomic_pointer_get(&tag->name))
+    return NULL;
+  return tag;
+}
+
+/* returns the id of @name or -1, in which case @slot is set to the empty
+ * slot where it could be inserted */
+static gint
+_lookup_tag_id_by_name(const gchar *name, guint *slot)
+{
+  guint i = g_str_hash(name) & (LOG_TAGS_HASH_SIZE - 1);
+
+  while (TRUE)
+    {
+      gint value = g_atomic_int_get(&log_tags_hash[i]);
+
+      if (value == 0)
+        {
+          if (slot)
+            *slot = i;
+          return -1;
+        }
+
+      LogTag *tag = _lookup_tag(value - 1);
+      if (tag && strcmp(tag->name, name) == 0)
+        return value - 1;
+
+      i = (i + 1) & (LOG_TAGS_HASH_SIZE - 1);
+    }
+}
+
+/* log_tags_lock must be held */
 static guint
 _register_tag(const gchar *name, guint id)
 {
-  LogTag new_tag =
-  {
-    .id = id,
-    .name = g_strdup(name),
-    0,
-  };
+  guint slot;
+
+  g_assert(id < LOG_TAGS_MAX);
+  g_assert(_lookup_tag_id_by_name(name, &slot) < 0);
+
+  LogTag **chunk = &log_tags_chunks[id >> LOG_TAGS_CHUNK_SHIFT];
+  if (!*chunk)
+    g_atomic_pointer_set(chunk, g_new0(LogTag, LOG_TAGS_CHUNK_SIZE));
+
+  LogTag *elem = &(*chunk)[id & LOG_TAGS_CHUNK_MASK];
+  g_assert(elem->name == NULL);
+
+  elem->id = id;
 
   /* NOTE: stats-level may not be set for calls that happen during
    * config file parsing, those get fixed up by
@@ -59,25 +133,21 @@ _register_tag(const gchar *name, guint id)
   StatsClusterLabel labels[] = { stats_cluster_label("id", name) };
   stats_cluster_single_key_set(&sc_key, "tagged_events_total", labels, G_N_ELEMENTS(labels));
   stats_cluster_single_key_add_legacy_alias_with_name(&sc_key, SCS_TAG, name, NULL, "processed");
-  stats_register_counter(3, &sc_key, SC_TYPE_SINGLE_VALUE, &new_tag.counter);
+  stats_register_counter(3, &sc_key, SC_TYPE_SINGLE_VALUE, &elem->counter);
   stats_unlock();
 
-  if (id >= log_tags->len)
-    g_array_set_size(log_tags, id + 1);
+  g_atomic_pointer_set(&elem->name, g_strdup(name));
+  g_atomic_int_set(&log_tags_hash[slot], id + 1);
 
-  LogTag *elem = &g_array_index(log_tags, LogTag, id);
-
-  g_assert(elem->id == 0);
-  *elem = new_tag;
-
-  g_hash_table_insert(log_tags_hash, new_tag.name, GUINT_TO_POINTER(id + 1));
+  if (id >= log_tags_len)
+    log_tags_len = id + 1;
   return id;
 }
 
 static guint
 _register_new_tag(const gchar *name)
 {
-  guint id = log_tags->len;
+  guint id = log_tags_len;
   return _register_tag(name, id);
 }
 
@@ -102,26 +172,25 @@ log_tags_get_by_name(const gchar *name)
 
      In both cases the return value is 0.
    */
-  guint id = 0;
+  gint id;
 
   g_assert(log_tags_hash != NULL);
 
+  id = _lookup_tag_id_by_name(name, NULL);
+  if (id >= 0)
+    return id;
+
   g_mutex_lock(&log_tags_lock);
 
-  gpointer key = g_hash_table_lookup(log_tags_hash, name);
-  if (!key)
+  /* somebody else might have registered it in the meanwhile */
+  id = _lookup_tag_id_by_name(name, NULL);
+  if (id < 0)
     {
-      if (log_tags->len < LOG_TAGS_MAX - 1)
-        {
-          id = _register_new_tag(name);
-        }
+      if (log_tags_len < LOG_TAGS_MAX - 1)
+        id = _register_new_tag(name);
       else
         id = 0;
     }
-  else
-    {
-      id = GPOINTER_TO_UINT(key) - 1;
-    }
 
   g_mutex_unlock(&log_tags_lock);
 
@@ -133,9 +202,6 @@ log_tags_register_predefined_tag(const gchar *name, LogTagId id)
 {
   g_mutex_lock(&log_tags_lock);
 
-  gpointer key = g_hash_table_lookup(log_tags_hash, name);
-  g_assert(key == NULL);
-
   LogTagId rid = _register_tag(name, id);
   g_assert(rid == id);
   g_mutex_unlock(&log_tags_lock);
@@ -156,39 +222,27 @@ log_tags_register_predefined_tag(const gchar *name, LogTagId id)
 const gchar *
 log_tags_get_by_id(LogTagId id)
 {
-  gchar *name = NULL;
-
-  g_mutex_lock(&log_tags_lock);
-
-  if (id < log_tags->len)
-    name = g_array_index(log_tags, LogTag, id).name;
+  LogTag *tag = _lookup_tag(id);
 
-  g_mutex_unlock(&log_tags_lock);
-
-  return name;
+  return tag ? tag->name : NULL;
 }
 
 void
 log_tags_inc_counter(LogTagId id)
 {
-  g_mutex_lock(&log_tags_lock);
-
-  if (id < log_tags->len)
-    stats_counter_inc(g_array_index(log_tags, LogTag, id).counter);
+  LogTag *tag = _lookup_tag(id);
 
-  g_mutex_unlock(&log_tags_lock);
+  if (tag)
+    stats_counter_inc(g_atomic_pointer_get(&tag->counter));
 }
 
 void
 log_tags_dec_counter(LogTagId id)
 {
-  /* Reader lock because the log_tag_list is not written */
-  g_mutex_lock(&log_tags_lock);
-
-  if (id < log_tags->len)
-    stats_counter_dec(g_array_index(log_tags, LogTag, id).counter);
+  LogTag *tag = _lookup_tag(id);
 
-  g_mutex_unlock(&log_tags_lock);
+  if (tag)
+    stats_counter_dec(g_atomic_pointer_get(&tag->counter));
 }
 
 /*
@@ -209,9 +263,12 @@ log_tags_reinit_stats(void)
   g_mutex_lock(&log_tags_lock);
   stats_lock();
 
-  for (id = 0; id < log_tags->len; id++)
+  for (id = 0; id < log_tags_len; id++)
     {
-      LogTag *elem = &g_array_index(log_tags, LogTag, id);
+      LogTag *elem = _lookup_tag(id);
+
+      if (!elem)
+        continue;
 
       StatsClusterKey sc_key;
       StatsClusterLabel labels[] = { stats_cluster_label("id", elem->name) };
@@ -231,8 +288,8 @@ log_tags_reinit_stats(void)
 void
 log_tags_global_init(void)
 {
-  log_tags_hash = g_hash_table_new(g_str_hash, g_str_equal);
-  log_tags = g_array_new(FALSE, TRUE, sizeof(LogTag));
+  log_tags_hash = g_new0(gint, LOG_TAGS_HASH_SIZE);
+  log_tags_len = 0;
 
   register_application_hook(AH_CONFIG_CHANGED, (ApplicationHookFunc) log_tags_reinit_stats, NULL, AHM_RUN_REPEAT);
 }
@@ -240,13 +297,17 @@ log_tags_global_init(void)
 void
 log_tags_global_deinit(void)
 {
-  g_hash_table_destroy(log_tags_hash);
+  g_free(log_tags_hash);
+  log_tags_hash = NULL;
 
   stats_lock();
   StatsClusterKey sc_key;
-  for (guint id = 0; id < log_tags->len; id++)
+  for (guint id = 0; id < log_tags_len; id++)
     {
-      LogTag *elem = &g_array_index(log_tags, LogTag, id);
+      LogTag *elem = _lookup_tag(id);
+
+      if (!elem)
+        continue;
 
       StatsClusterLabel labels[] = { stats_cluster_label("id", elem->name) };
       stats_cluster_single_key_set(&sc_key, "tagged_events_total", labels, G_N_ELEMENTS(labels));
@@ -255,5 +316,11 @@ log_tags_global_deinit(void)
       g_free(elem->name);
     }
   stats_unlock();
-  g_array_free(log_tags, TRUE);
+
+  for (gint i = 0; i < LOG_TAGS_NUM_CHUNKS; i++)
+    {
+      g_free(log_tags_chunks[i]);
+      log_tags_chunks[i] = NULL;
+    }
+  log_tags_len = 0;
 }
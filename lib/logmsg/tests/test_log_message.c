@@ -930,3 +930,57 @@ Test(log_message, test_cow_unset_value)
   log_msg_unref(orig_msg);
   log_msg_unref(msg);
 }
+
+static void
+_free_queue_nodes(LogMessageQueueNode **nodes, gint n)
+{
+  for (gint i = 0; i < n; i++)
+    {
+      log_msg_unref(nodes[i]->msg);
+      log_msg_free_queue_node(nodes[i]);
+    }
+}
+
+Test(log_message, test_embedded_queue_nodes_are_used_up_before_dynamic_ones)
+{
+  LogMessage *msg = _construct_log_message();
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessageQueueNode *nodes[2];
+
+  nodes[0] = log_msg_alloc_embedded_queue_node(msg, &path_options);
+  cr_assert_not_null(nodes[0]);
+  cr_assert(nodes[0]->embedded);
+  cr_assert_eq(msg->num_nodes, 1);
+  cr_assert_null(log_msg_alloc_embedded_queue_node(msg, &path_options));
+
+  nodes[1] = log_msg_alloc_queue_node(msg, &path_options);
+  cr_assert_not(nodes[1]->embedded);
+  cr_assert_eq(nodes[1]->msg, msg);
+
+  _free_queue_nodes(nodes, 2);
+  log_msg_unref(msg);
+}
+
+Test(log_message, test_embedded_queue_nodes_follow_the_fan_out)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = _construct_log_message();
+  LogMessageQueueNode *nodes[2];
+
+  /* a message put into two queues ... */
+  nodes[0] = log_msg_alloc_queue_node(msg, &path_options);
+  nodes[1] = log_msg_alloc_queue_node(msg, &path_options);
+  cr_assert_not(nodes[1]->embedded);
+  _free_queue_nodes(nodes, 2);
+  log_msg_unref(msg);
+
+  /* ... makes the next messages embed a node for both */
+  msg = _construct_log_message();
+  cr_assert_eq(msg->num_nodes, 2);
+  nodes[0] = log_msg_alloc_queue_node(msg, &path_options);
+  nodes[1] = log_msg_alloc_queue_node(msg, &path_options);
+  cr_assert(nodes[0]->embedded);
+  cr_assert(nodes[1]->embedded);
+  _free_queue_nodes(nodes, 2);
+  log_msg_unref(msg);
+}
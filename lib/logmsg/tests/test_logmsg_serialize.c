@@ -176,6 +176,129 @@ Test(logmsg_serialize, serialize)
   g_string_free(stream, TRUE);
 }
 
+Test(logmsg_serialize, serialize_with_compaction_skips_overwritten_values)
+{
+  LogMessage *msg = _create_message_to_be_serialized(RAW_MSG, strlen(RAW_MSG));
+  GString *compacted = g_string_new("");
+  GString *full = g_string_new("");
+
+  /* each of these is longer than the previous one, leaving dead entries behind */
+  log_msg_set_value_by_name(msg, "overwritten", "1", -1);
+  log_msg_set_value_by_name(msg, "overwritten", "1234567890", -1);
+  log_msg_set_value_by_name(msg, "overwritten", "1234567890abcdefghijklmnopqrstuvwxyz", -1);
+  log_msg_set_value(msg, LM_V_PROGRAM, "a-program-name-longer-than-the-original", -1);
+
+  SerializeArchive *sa = serialize_string_archive_new(compacted);
+  log_msg_serialize(msg, sa, LMSF_COMPACTION);
+  serialize_archive_free(sa);
+
+  sa = serialize_string_archive_new(full);
+  log_msg_serialize(msg, sa, 0);
+  serialize_archive_free(sa);
+  log_msg_unref(msg);
+
+  cr_assert_lt(compacted->len, full->len);
+
+  sa = serialize_string_archive_new(compacted);
+  msg = log_msg_new_empty();
+  cr_assert(log_msg_deserialize(msg, sa), ERROR_MSG);
+
+  assert_log_message_value_by_name(msg, "overwritten", "1234567890abcdefghijklmnopqrstuvwxyz");
+  assert_log_message_value(msg, LM_V_PROGRAM, "a-program-name-longer-than-the-original");
+  assert_log_message_value(msg, log_msg_get_value_handle("indirect_1"), "val");
+  assert_log_message_value_and_type(msg, log_msg_get_value_handle("indirect_2"), "53", LM_VT_INTEGER);
+  assert_log_message_value_by_name(msg, ".SDATA.dynamic.field31", "value");
+  assert_log_message_value_by_name(msg, ".normal.dynamic.field0", "value");
+  cr_assert_not(log_msg_is_value_set(msg, log_msg_get_value_handle("unset_value")));
+
+  log_msg_unref(msg);
+  serialize_archive_free(sa);
+  g_string_free(compacted, TRUE);
+  g_string_free(full, TRUE);
+}
+
+static LogMessage *
+_deserialize_message_without_registry_reset(const GString *serialized)
+{
+  GString *s = g_string_new_len(serialized->str, serialized->len);
+  SerializeArchive *sa = serialize_string_archive_new(s);
+  LogMessage *msg = log_msg_new_empty();
+
+  cr_assert(log_msg_deserialize(msg, sa), ERROR_MSG);
+  serialize_archive_free(sa);
+  g_string_free(s, TRUE);
+  return msg;
+}
+
+Test(logmsg_serialize, repeated_deserialization_remaps_handles_consistently)
+{
+  GString *stream = g_string_new("");
+  SerializeArchive *sa = _serialize_message_for_test(stream, RAW_MSG);
+  serialize_archive_free(sa);
+
+  /* the first one populates the remap cache, the second one hits it */
+  for (gint i = 0; i < 2; i++)
+    {
+      LogMessage *msg = _deserialize_message_without_registry_reset(stream);
+      _check_deserialized_message_all_fields(msg);
+      assert_log_message_value_by_name(msg, ".normal.dynamic.field31", "value");
+      log_msg_unref(msg);
+    }
+
+  /* a registry reset moves the handles, cached mappings must not be used */
+  LogMessage *msg = _deserialize_message_from_string((const guint8 *) stream->str, stream->len);
+  _check_deserialized_message_all_fields(msg);
+  assert_log_message_value_by_name(msg, ".SDATA.dynamic.field0", "value");
+  assert_log_message_value_by_name(msg, ".normal.dynamic.field31", "value");
+  log_msg_unref(msg);
+
+  g_string_free(stream, TRUE);
+}
+
+/* every entry of the index is set and the handles are in order */
+static void
+_assert_nv_index_is_valid(LogMessage *msg)
+{
+  NVIndexEntry *index_table = nv_table_get_index(msg->payload);
+
+  for (gint i = 0; i < msg->payload->index_size; i++)
+    {
+      cr_assert_neq(index_table[i].ofs, 0, "index entry %d is empty", i);
+      if (i > 0)
+        cr_assert_lt(index_table[i - 1].handle, index_table[i].handle, "index is not sorted at %d", i);
+    }
+}
+
+Test(logmsg_serialize, serialize_with_compaction_leaves_unset_values_out_of_the_index_across_restarts)
+{
+  LogMessage *msg = _create_message_to_be_serialized(RAW_MSG, strlen(RAW_MSG));
+  GString *stream = g_string_new("");
+
+  /* the message already has an unset dynamic value, add one more in the middle of the index */
+  log_msg_set_value_by_name(msg, ".normal.dynamic.unset", "value", -1);
+  log_msg_unset_value_by_name(msg, ".normal.dynamic.unset");
+
+  SerializeArchive *sa = serialize_string_archive_new(stream);
+  log_msg_serialize(msg, sa, LMSF_COMPACTION);
+  log_msg_unref(msg);
+
+  /* the handles of the values are different after the restart, so each of them is remapped */
+  _reset_log_msg_registry();
+
+  msg = log_msg_new_empty();
+  cr_assert(log_msg_deserialize(msg, sa), ERROR_MSG);
+
+  _assert_nv_index_is_valid(msg);
+  _check_deserialized_message_all_fields(msg);
+  assert_log_message_value_by_name(msg, ".SDATA.dynamic.field31", "value");
+  assert_log_message_value_by_name(msg, ".normal.dynamic.field0", "value");
+  assert_log_message_value_unset(msg, log_msg_get_value_handle(".normal.dynamic.unset"));
+
+  log_msg_unref(msg);
+  serialize_archive_free(sa);
+  g_string_free(stream, TRUE);
+}
+
 static LogMessage *
 _create_message_to_be_serialized_with_ts_processed(const gchar *raw_msg, const int raw_msg_len, UnixTime *processed)
 {
@@ -225,6 +225,63 @@ Test(tags, test_filters_false)
   log_msg_unref(msg);
 }
 
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_TAGS 1000
+
+static gpointer
+_resolve_tags(gpointer user_data)
+{
+  LogTagId *ids = g_new(LogTagId, CONCURRENT_TAGS);
+
+  for (gint i = 0; i < CONCURRENT_TAGS; i++)
+    {
+      gchar *name = g_strdup_printf("concurrent%d", i);
+      ids[i] = log_tags_get_by_name(name);
+      g_free(name);
+    }
+  return ids;
+}
+
+Test(tags, test_concurrent_lookups_resolve_to_the_same_id)
+{
+  GThread *threads[CONCURRENT_THREADS];
+  LogTagId *ids[CONCURRENT_THREADS];
+
+  for (gint t = 0; t < CONCURRENT_THREADS; t++)
+    threads[t] = g_thread_new(NULL, _resolve_tags, NULL);
+  for (gint t = 0; t < CONCURRENT_THREADS; t++)
+    ids[t] = g_thread_join(threads[t]);
+
+  for (gint i = 0; i < CONCURRENT_TAGS; i++)
+    {
+      gchar *name = g_strdup_printf("concurrent%d", i);
+
+      cr_assert_str_eq(log_tags_get_by_id(ids[0][i]), name);
+      for (gint t = 1; t < CONCURRENT_THREADS; t++)
+        cr_assert_eq(ids[t][i], ids[0][i], "Tag %s resolved to different ids: %d vs %d", name, ids[t][i], ids[0][i]);
+      g_free(name);
+    }
+
+  for (gint t = 0; t < CONCURRENT_THREADS; t++)
+    g_free(ids[t]);
+}
+
+Test(tags, test_clearing_a_tag_that_is_not_stored_does_not_allocate)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  log_msg_clear_tag_by_id(msg, 1000);
+  cr_assert_eq(msg->num_tags, 0);
+  cr_assert_not(log_msg_is_tag_by_id(msg, 1000));
+
+  log_msg_set_tag_by_id(msg, 1000);
+  cr_assert(log_msg_is_tag_by_id(msg, 1000));
+  log_msg_clear_tag_by_id(msg, 1000);
+  cr_assert_not(log_msg_is_tag_by_id(msg, 1000));
+
+  log_msg_unref(msg);
+}
+
 static void
 setup(void)
 {
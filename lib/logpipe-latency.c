@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logpipe-latency.h"
+#include "cfg-tree.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "tls-support.h"
+
+#include <time.h>
+
+#define LOG_PIPE_LATENCY_METRIC "pipe_latency_seconds"
+#define LOG_PIPE_LATENCY_FIRST_BUCKET_NSEC 1000
+
+enum
+{
+  LPL_LABEL_ID,
+  LPL_LABEL_LOCATION,
+  LPL_LABEL_PLUGIN,
+  LPL_LABEL_LE,
+  LPL_LABEL_MAX
+};
+
+/* upper bounds of the buckets, in seconds, doubling from 1us */
+static const gchar *bucket_upper_bounds[LOG_PIPE_LATENCY_BUCKETS] =
+{
+  "0.000001", "0.000002", "0.000004", "0.000008", "0.000016", "0.000032",
+  "0.000064", "0.000128", "0.000256", "0.000512", "0.001024", "0.002048",
+  "0.004096", "0.008192", "0.016384", "0.032768", "0.065536", "+Inf",
+};
+
+struct _LogPipeLatency
+{
+  gchar *id;
+  gchar *location;
+  gchar *plugin;
+  StatsClusterLabel labels[LOG_PIPE_LATENCY_BUCKETS][LPL_LABEL_MAX];
+
+  StatsCounterItem *sum;
+  StatsCounterItem *count;
+  StatsCounterItem *buckets[LOG_PIPE_LATENCY_BUCKETS];
+};
+
+gint log_pipe_latency_sample_rate;
+
+TLS_BLOCK_START
+{
+  guint32 sample_counter;
+  gint sample_depth;
+  gboolean sampling;
+  guint64 downstream_nsec;
+}
+TLS_BLOCK_END;
+
+#define sample_counter __tls_deref(sample_counter)
+#define sample_depth __tls_deref(sample_depth)
+#define sampling __tls_deref(sampling)
+#define downstream_nsec __tls_deref(downstream_nsec)
+
+static inline guint64
+_monotonic_nsec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+gint
+log_pipe_latency_bucket_index(guint64 nsec)
+{
+  guint64 upper_bound = LOG_PIPE_LATENCY_FIRST_BUCKET_NSEC;
+  gint i = 0;
+
+  while (i < LOG_PIPE_LATENCY_BUCKETS - 1 && nsec > upper_bound)
+    {
+      upper_bound <<= 1;
+      i++;
+    }
+  return i;
+}
+
+void
+log_pipe_latency_record(LogPipeLatency *self, guint64 nsec)
+{
+  /* Prometheus buckets are cumulative, each one counts the samples <= its bound */
+  for (gint i = log_pipe_latency_bucket_index(nsec); i < LOG_PIPE_LATENCY_BUCKETS; i++)
+    stats_counter_inc(self->buckets[i]);
+
+  stats_counter_add(self->sum, nsec);
+  stats_counter_inc(self->count);
+}
+
+static inline void
+_dispatch(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (s->queue)
+    s->queue(s, msg, path_options);
+  else
+    log_pipe_forward_msg(s, msg, path_options);
+}
+
+/*
+ * Called instead of the plain dispatch in log_pipe_queue() while sampling
+ * is enabled.  The sampling decision is made when a message enters the
+ * pipeline on this thread (depth 0) and holds for all the hops the message
+ * takes synchronously.  Downstream time is subtracted so each pipe is
+ * accounted for its own work only.
+ *
+ * @sample_rate is the value log_pipe_queue() has checked, the global may
+ * have been reset to 0 since.
+ */
+void
+log_pipe_queue_sampled(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options, gint sample_rate)
+{
+  if (sample_depth == 0)
+    sampling = (++sample_counter % sample_rate) == 0;
+
+  sample_depth++;
+  LogPipeLatency *latency = s->latency;
+  if (!sampling || !latency)
+    {
+      _dispatch(s, msg, path_options);
+      sample_depth--;
+      return;
+    }
+
+  guint64 saved_downstream_nsec = downstream_nsec;
+  downstream_nsec = 0;
+
+  guint64 start = _monotonic_nsec();
+  _dispatch(s, msg, path_options);
+  guint64 elapsed = _monotonic_nsec() - start;
+
+  log_pipe_latency_record(latency, elapsed > downstream_nsec ? elapsed - downstream_nsec : 0);
+  downstream_nsec = saved_downstream_nsec + elapsed;
+  sample_depth--;
+}
+
+static const gchar *
+_find_id(LogExprNode *node)
+{
+  for (; node; node = node->parent)
+    {
+      if (node->name)
+        return node->name;
+    }
+  return "";
+}
+
+static void
+_setup_keys(LogPipeLatency *self, StatsClusterKey *sc_key_sum, StatsClusterKey *sc_key_count,
+            StatsClusterKey *sc_key_buckets)
+{
+  stats_cluster_single_key_set(sc_key_sum, LOG_PIPE_LATENCY_METRIC "_sum", self->labels[0], LPL_LABEL_LE);
+  stats_cluster_single_key_add_unit(sc_key_sum, SCU_NANOSECONDS);
+  stats_cluster_single_key_set(sc_key_count, LOG_PIPE_LATENCY_METRIC "_count", self->labels[0], LPL_LABEL_LE);
+
+  for (gint i = 0; i < LOG_PIPE_LATENCY_BUCKETS; i++)
+    stats_cluster_single_key_set(&sc_key_buckets[i], LOG_PIPE_LATENCY_METRIC "_bucket", self->labels[i],
+                                 LPL_LABEL_MAX);
+}
+
+static LogPipeLatency *
+log_pipe_latency_new(LogPipe *pipe)
+{
+  LogPipeLatency *self = g_new0(LogPipeLatency, 1);
+  gchar location[128];
+
+  self->id = g_strdup(_find_id(pipe->expr_node));
+  self->location = g_strdup(log_expr_node_format_location(pipe->expr_node, location, sizeof(location)));
+  self->plugin = g_strdup(pipe->plugin_name ? : "");
+
+  for (gint i = 0; i < LOG_PIPE_LATENCY_BUCKETS; i++)
+    {
+      self->labels[i][LPL_LABEL_ID] = stats_cluster_label("id", self->id);
+      self->labels[i][LPL_LABEL_LOCATION] = stats_cluster_label("location", self->location);
+      self->labels[i][LPL_LABEL_PLUGIN] = stats_cluster_label("plugin", self->plugin);
+      self->labels[i][LPL_LABEL_LE] = stats_cluster_label("le", bucket_upper_bounds[i]);
+    }
+
+  StatsClusterKey sc_key_sum, sc_key_count, sc_key_buckets[LOG_PIPE_LATENCY_BUCKETS];
+  _setup_keys(self, &sc_key_sum, &sc_key_count, sc_key_buckets);
+
+  stats_lock();
+  stats_register_counter(STATS_LEVEL0, &sc_key_sum, SC_TYPE_SINGLE_VALUE, &self->sum);
+  stats_register_counter(STATS_LEVEL0, &sc_key_count, SC_TYPE_SINGLE_VALUE, &self->count);
+  for (gint i = 0; i < LOG_PIPE_LATENCY_BUCKETS; i++)
+    stats_register_counter(STATS_LEVEL0, &sc_key_buckets[i], SC_TYPE_SINGLE_VALUE, &self->buckets[i]);
+  stats_unlock();
+
+  return self;
+}
+
+static void
+log_pipe_latency_free(LogPipeLatency *self)
+{
+  StatsClusterKey sc_key_sum, sc_key_count, sc_key_buckets[LOG_PIPE_LATENCY_BUCKETS];
+  _setup_keys(self, &sc_key_sum, &sc_key_count, sc_key_buckets);
+
+  stats_lock();
+  stats_unregister_counter(&sc_key_sum, SC_TYPE_SINGLE_VALUE, &self->sum);
+  stats_unregister_counter(&sc_key_count, SC_TYPE_SINGLE_VALUE, &self->count);
+  for (gint i = 0; i < LOG_PIPE_LATENCY_BUCKETS; i++)
+    stats_unregister_counter(&sc_key_buckets[i], SC_TYPE_SINGLE_VALUE, &self->buckets[i]);
+  stats_unlock();
+
+  g_free(self->id);
+  g_free(self->location);
+  g_free(self->plugin);
+  g_free(self);
+}
+
+void
+log_pipe_latency_register(LogPipe *pipe)
+{
+  if (pipe->latency || !pipe->expr_node)
+    return;
+
+  pipe->latency = log_pipe_latency_new(pipe);
+}
+
+void
+log_pipe_latency_unregister(LogPipe *pipe)
+{
+  if (!pipe->latency)
+    return;
+
+  log_pipe_latency_free(pipe->latency);
+  pipe->latency = NULL;
+}
+
+void
+log_pipe_latency_set_sampling(gint sample_rate)
+{
+  log_pipe_latency_sample_rate = MAX(sample_rate, 0);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGPIPE_LATENCY_H_INCLUDED
+#define LOGPIPE_LATENCY_H_INCLUDED
+
+#include "logpipe.h"
+
+/*
+ * Sampling latency instrumentation of LogPipe instances.
+ *
+ * When enabled with stats(pipe-latency-sampling(N)), every Nth message
+ * entering the pipeline (per thread) is timed at each log_pipe_queue()
+ * hop.  The time spent in a pipe, excluding the time spent in the pipes
+ * it forwarded the message to, is recorded into a per-pipe histogram with
+ * exponentially growing buckets, exposed as the
+ * "pipe_latency_seconds" metric family (_bucket, _sum and _count).
+ */
+
+#define LOG_PIPE_LATENCY_BUCKETS 18
+
+gint log_pipe_latency_bucket_index(guint64 nsec);
+void log_pipe_latency_record(LogPipeLatency *self, guint64 nsec);
+
+void log_pipe_latency_register(LogPipe *pipe);
+void log_pipe_latency_unregister(LogPipe *pipe);
+
+void log_pipe_latency_set_sampling(gint sample_rate);
+
+#endif
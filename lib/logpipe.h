@@ -253,6 +253,7 @@ log_path_options_pop_junction(LogPathOptions *local_path_options)
 }
 
 typedef struct _LogPipeOptions LogPipeOptions;
+typedef struct _LogPipeLatency LogPipeLatency;
 
 struct _LogPipeOptions
 {
@@ -299,6 +300,9 @@ struct _LogPipe
   void (*free_fn)(LogPipe *self);
   void (*notify)(LogPipe *self, gint notify_code, gpointer user_data);
   GList *info;
+
+  /* latency histogram, only set if stats(pipe-latency-sampling()) is enabled */
+  LogPipeLatency *latency;
 };
 
 /*
@@ -312,6 +316,9 @@ struct _LogPipe
 G_STATIC_ASSERT(G_STRUCT_OFFSET(LogPipe, queue) - G_STRUCT_OFFSET(LogPipe, flags) <= 4);
 
 extern gboolean (*pipe_single_step_hook)(LogPipe *pipe, LogMessage *msg, const LogPathOptions *path_options);
+extern gint log_pipe_latency_sample_rate;
+
+void log_pipe_queue_sampled(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options, gint sample_rate);
 
 LogPipe *log_pipe_ref(LogPipe *self);
 gboolean log_pipe_unref(LogPipe *self);
@@ -443,7 +450,13 @@ log_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
       path_options = &local_path_options;
     }
 
-  if (s->queue)
+  /* read only once, sampling may be switched off concurrently */
+  const gint sample_rate = log_pipe_latency_sample_rate;
+  if (G_UNLIKELY(sample_rate))
+    {
+      log_pipe_queue_sampled(s, msg, path_options, sample_rate);
+    }
+  else if (s->queue)
     {
       s->queue(s, msg, path_options);
     }
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logproto/logproto-buffer-pool.h"
+#include "tls-support.h"
+
+/* the number of free buffers kept per buffer size, per thread */
+#define LOG_PROTO_BUFFER_POOL_MAX_FREE 16
+
+typedef struct _LogProtoBufferPoolClass
+{
+  gsize size;
+  GPtrArray *free_buffers;
+} LogProtoBufferPoolClass;
+
+TLS_BLOCK_START
+{
+  /* buffers are bucketed by size, as sources may use different init-buffer-size() values */
+  GArray *buffer_pool;
+}
+TLS_BLOCK_END;
+
+#define buffer_pool __tls_deref(buffer_pool)
+
+static GPtrArray *
+_lookup_free_buffers(gsize size)
+{
+  for (gint i = 0; i < buffer_pool->len; i++)
+    {
+      LogProtoBufferPoolClass *class = &g_array_index(buffer_pool, LogProtoBufferPoolClass, i);
+
+      if (class->size == size)
+        return class->free_buffers;
+    }
+  return NULL;
+}
+
+guchar *
+log_proto_buffer_pool_acquire(gsize size)
+{
+  if (!buffer_pool)
+    return g_malloc(size);
+
+  GPtrArray *free_buffers = _lookup_free_buffers(size);
+  if (!free_buffers || free_buffers->len == 0)
+    return g_malloc(size);
+
+  guchar *buffer = g_ptr_array_index(free_buffers, free_buffers->len - 1);
+  g_ptr_array_set_size(free_buffers, free_buffers->len - 1);
+  return buffer;
+}
+
+void
+log_proto_buffer_pool_release(guchar *buffer, gsize size)
+{
+  if (!buffer_pool)
+    {
+      g_free(buffer);
+      return;
+    }
+
+  GPtrArray *free_buffers = _lookup_free_buffers(size);
+  if (!free_buffers)
+    {
+      LogProtoBufferPoolClass class = { .size = size, .free_buffers = g_ptr_array_new() };
+
+      g_array_append_val(buffer_pool, class);
+      free_buffers = class.free_buffers;
+    }
+
+  if (free_buffers->len >= LOG_PROTO_BUFFER_POOL_MAX_FREE)
+    {
+      g_free(buffer);
+      return;
+    }
+  g_ptr_array_add(free_buffers, buffer);
+}
+
+gsize
+log_proto_buffer_pool_get_local_free_count(void)
+{
+  gsize count = 0;
+
+  if (!buffer_pool)
+    return 0;
+
+  for (gint i = 0; i < buffer_pool->len; i++)
+    count += g_array_index(buffer_pool, LogProtoBufferPoolClass, i).free_buffers->len;
+  return count;
+}
+
+void
+log_proto_buffer_pool_allocator_init(void)
+{
+  buffer_pool = g_array_new(FALSE, FALSE, sizeof(LogProtoBufferPoolClass));
+}
+
+void
+log_proto_buffer_pool_allocator_deinit(void)
+{
+  for (gint i = 0; i < buffer_pool->len; i++)
+    {
+      GPtrArray *free_buffers = g_array_index(buffer_pool, LogProtoBufferPoolClass, i).free_buffers;
+
+      g_ptr_array_foreach(free_buffers, (GFunc) g_free, NULL);
+      g_ptr_array_free(free_buffers, TRUE);
+    }
+  g_array_free(buffer_pool, TRUE);
+  buffer_pool = NULL;
+}
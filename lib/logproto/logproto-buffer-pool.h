@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGPROTO_BUFFER_POOL_H_INCLUDED
+#define LOGPROTO_BUFFER_POOL_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Per-thread pool of receive buffers.
+ *
+ * Stream based LogProtoServer instances borrow their buffer from the pool
+ * of the thread doing the read, and return it once the input is drained,
+ * so that idle connections don't hold on to init-buffer-size() bytes each.
+ * The unprocessed tail of the buffer (a partial message) is kept in a
+ * small spill allocation in the meantime, as long as it is at most
+ * LOG_PROTO_BUFFER_SPILL_MAX bytes, otherwise the connection keeps its
+ * buffer.
+ *
+ * Buffers may be returned to the pool of a different thread than the one
+ * they were acquired from.  Threads without a pool (see
+ * log_proto_buffer_pool_allocator_init()) simply allocate and free.
+ */
+
+#define LOG_PROTO_BUFFER_SPILL_MAX 4096
+
+guchar *log_proto_buffer_pool_acquire(gsize size);
+void log_proto_buffer_pool_release(guchar *buffer, gsize size);
+
+gsize log_proto_buffer_pool_get_local_free_count(void);
+
+void log_proto_buffer_pool_allocator_init(void);
+void log_proto_buffer_pool_allocator_deinit(void);
+
+#endif
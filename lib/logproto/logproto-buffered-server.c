@@ -25,6 +25,7 @@
 #include "logproto.h"
 #include "messages.h"
 #include "serialize.h"
+#include "logproto-buffer-pool.h"
 #include "compat/string.h"
 
 #include <errno.h>
@@ -756,11 +757,69 @@ exit:
   return success;
 }
 
+/* files persist their buffer position, only plain streams share their buffers */
+static inline gboolean
+log_proto_buffered_server_uses_buffer_pool(LogProtoBufferedServer *self)
+{
+  return self->stream_based && !self->pos_tracking;
+}
+
 static inline void
 log_proto_buffered_server_allocate_buffer(LogProtoBufferedServer *self, LogProtoBufferedServerState *state)
 {
   state->buffer_size = self->super.options->init_buffer_size;
-  self->buffer = g_malloc(state->buffer_size);
+  if (!log_proto_buffered_server_uses_buffer_pool(self))
+    {
+      self->buffer = g_malloc(state->buffer_size);
+      return;
+    }
+
+  self->buffer = log_proto_buffer_pool_acquire(state->buffer_size);
+  if (self->spill)
+    {
+      memcpy(self->buffer, self->spill, self->spill_len);
+      state->pending_buffer_pos = 0;
+      state->pending_buffer_end = self->spill_len;
+      g_free(self->spill);
+      self->spill = NULL;
+      self->spill_len = 0;
+    }
+}
+
+/*
+ * Called when the input would block: give the buffer back to the pool,
+ * keeping only the partial message at its end.  Connections with a
+ * partial message too large to spill keep their buffer.
+ */
+static void
+log_proto_buffered_server_release_buffer(LogProtoBufferedServer *self)
+{
+  if (!self->buffer || !log_proto_buffered_server_uses_buffer_pool(self))
+    return;
+
+  LogProtoBufferedServerState *state = log_proto_buffered_server_get_state(self);
+  gsize buffer_bytes = state->pending_buffer_end - state->pending_buffer_pos;
+
+  if (buffer_bytes > LOG_PROTO_BUFFER_SPILL_MAX || buffer_bytes > self->super.options->init_buffer_size)
+    goto exit;
+
+  if (buffer_bytes)
+    {
+      self->spill = g_malloc(buffer_bytes);
+      memcpy(self->spill, self->buffer + state->pending_buffer_pos, buffer_bytes);
+      self->spill_len = buffer_bytes;
+    }
+
+  /* the buffer might have been grown by the character set conversion */
+  if (state->buffer_size == self->super.options->init_buffer_size)
+    log_proto_buffer_pool_release(self->buffer, state->buffer_size);
+  else
+    g_free(self->buffer);
+  self->buffer = NULL;
+  state->pending_buffer_pos = state->pending_buffer_end = 0;
+
+exit:
+  log_proto_buffered_server_put_state(self);
 }
 
 static inline gint
@@ -934,6 +993,9 @@ log_proto_buffered_server_flush(LogProtoBufferedServer *self, const guchar **msg
 {
   LogProtoBufferedServerState *state = log_proto_buffered_server_get_state(self);
 
+  if (G_UNLIKELY(!self->buffer && self->spill))
+    log_proto_buffered_server_allocate_buffer(self, state);
+
   const guchar *buffer_start = self->buffer + state->pending_buffer_pos;
   gsize buffer_bytes = state->pending_buffer_end - state->pending_buffer_pos;
 
@@ -1006,6 +1068,7 @@ log_proto_buffered_server_fetch(LogProtoServer *s, const guchar **msg, gsize *ms
               break;
 
             case G_IO_STATUS_AGAIN:
+              log_proto_buffered_server_release_buffer(self);
               result = LPS_AGAIN;
               goto exit;
 
@@ -1063,6 +1126,7 @@ log_proto_buffered_server_free_method(LogProtoServer *s)
   log_transport_aux_data_destroy(&self->buffer_aux);
 
   g_free(self->buffer);
+  g_free(self->spill);
   if (self->state1)
     {
       g_free(self->state1);
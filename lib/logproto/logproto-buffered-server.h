@@ -92,6 +92,10 @@ struct _LogProtoBufferedServer
   GIConv convert;
   guchar *buffer;
 
+  /* partial message kept while the buffer is returned to the buffer pool */
+  guchar *spill;
+  gsize spill_len;
+
   GIConv reverse_convert;
   gchar *reverse_buffer;
   gsize reverse_buffer_len;
@@ -22,6 +22,7 @@
  *
  */
 #include "logproto-framed-server.h"
+#include "logproto-buffer-pool.h"
 #include "messages.h"
 
 #include <errno.h>
@@ -58,7 +59,12 @@ typedef struct _LogProtoFramedServer
   guint32 buffer_size, buffer_pos, buffer_end;
   guint32 frame_len;
   gboolean half_message_in_buffer;
+  gboolean would_block;
   guint32 fetch_counter;
+
+  /* partial frame kept while the buffer is returned to the buffer pool */
+  guchar *spill;
+  gsize spill_len;
 } LogProtoFramedServer;
 
 static LogProtoPrepareAction
@@ -121,6 +127,7 @@ log_proto_framed_server_fetch_data(LogProtoFramedServer *self, gboolean *may_rea
         {
           /* we need more data to parse this message but the data is not available yet */
           self->half_message_in_buffer = TRUE;
+          self->would_block = TRUE;
         }
       return FALSE;
     }
@@ -221,7 +228,41 @@ _ensure_buffer(LogProtoFramedServer *self)
     return;
 
   self->buffer_size = self->super.options->init_buffer_size;
-  self->buffer = g_malloc(self->buffer_size);
+  self->buffer = log_proto_buffer_pool_acquire(self->buffer_size);
+  if (self->spill)
+    {
+      memcpy(self->buffer, self->spill, self->spill_len);
+      self->buffer_pos = 0;
+      self->buffer_end = self->spill_len;
+      g_free(self->spill);
+      self->spill = NULL;
+      self->spill_len = 0;
+    }
+}
+
+/* the input would block: give the buffer back to the pool, keeping only the partial frame */
+static void
+_release_buffer(LogProtoFramedServer *self)
+{
+  gsize buffer_bytes = self->buffer_end - self->buffer_pos;
+
+  /* trimming relies on the buffer being full, keep it */
+  if (self->state != LPFSS_FRAME_READ && self->state != LPFSS_MESSAGE_READ)
+    return;
+
+  if (buffer_bytes > LOG_PROTO_BUFFER_SPILL_MAX)
+    return;
+
+  if (buffer_bytes)
+    {
+      self->spill = g_malloc(buffer_bytes);
+      memcpy(self->spill, &self->buffer[self->buffer_pos], buffer_bytes);
+      self->spill_len = buffer_bytes;
+    }
+
+  log_proto_buffer_pool_release(self->buffer, self->buffer_size);
+  self->buffer = NULL;
+  self->buffer_pos = self->buffer_end = 0;
 }
 
 static LogProtoFramedServerStateControl
@@ -404,8 +445,12 @@ log_proto_framed_server_fetch(LogProtoServer *s, const guchar **msg, gsize *msg_
   _ensure_buffer(self);
 
   self->fetch_counter = 0;
+  self->would_block = FALSE;
   while (_step_state_machine(self, msg, msg_len, may_read, aux, &status) != LPFSSCTRL_RETURN_WITH_STATUS) ;
 
+  if (self->would_block)
+    _release_buffer(self);
+
   return status;
 }
 
@@ -414,6 +459,7 @@ log_proto_framed_server_free(LogProtoServer *s)
 {
   LogProtoFramedServer *self = (LogProtoFramedServer *) s;
   g_free(self->buffer);
+  g_free(self->spill);
 
   log_proto_server_free_method(s);
 }
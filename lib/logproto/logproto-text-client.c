@@ -38,7 +38,7 @@ log_proto_text_client_prepare(LogProtoClient *s, gint *fd, GIOCondition *cond, g
   if (*cond == 0)
     *cond = G_IO_OUT;
 
-  const gboolean pending_write = self->partial != NULL;
+  const gboolean pending_write = self->partial != NULL || self->transport_flush_pending;
 
   if (!pending_write && s->options->timeout > 0)
     *timeout = s->options->timeout;
@@ -73,8 +73,25 @@ log_proto_text_client_drop_input(LogProtoClient *s)
   return LPS_SUCCESS;
 }
 
+/* transports with a flush() method may keep the data in their own buffer
+ * after write() returned (e.g. TLS record coalescing), messages written
+ * that way are only acked once log_transport_flush() succeeded, otherwise
+ * a crash or a connection error would lose messages that are already
+ * acked in a reliable disk-buffer */
+static void
+log_proto_text_client_ack(LogProtoTextClient *self)
+{
+  if (self->super.transport->flush)
+    {
+      self->pending_acks++;
+      return;
+    }
+
+  log_proto_client_msg_ack(&self->super, 1);
+}
+
 static LogProtoStatus
-log_proto_text_client_flush(LogProtoClient *s)
+log_proto_text_client_flush_partial(LogProtoClient *s)
 {
   LogProtoTextClient *self = (LogProtoTextClient *) s;
   gint rc;
@@ -115,12 +132,52 @@ log_proto_text_client_flush(LogProtoClient *s)
       self->next_state = -1;
     }
 
-  log_proto_client_msg_ack(&self->super, 1);
+  log_proto_text_client_ack(self);
 
   /* NOTE: we return here to give a chance to the framed protocol to send the frame header. */
   return LPS_SUCCESS;
 }
 
+/* push out whatever the transport has buffered from the writes above (e.g.
+ * TLS record coalescing), this only happens at the end of a batch, so that
+ * subsequent messages can be sent in the same chunk */
+static LogProtoStatus
+log_proto_text_client_flush_transport(LogProtoTextClient *self)
+{
+  if (log_transport_flush(self->super.transport) < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+        {
+          msg_error("I/O error occurred while writing",
+                    evt_tag_int("fd", self->super.transport->fd),
+                    evt_tag_error(EVT_TAG_OSERROR));
+          return LPS_ERROR;
+        }
+      self->transport_flush_pending = TRUE;
+      return LPS_PARTIAL;
+    }
+
+  self->transport_flush_pending = FALSE;
+  if (self->pending_acks > 0)
+    {
+      log_proto_client_msg_ack(&self->super, self->pending_acks);
+      self->pending_acks = 0;
+    }
+  return LPS_SUCCESS;
+}
+
+static LogProtoStatus
+log_proto_text_client_flush(LogProtoClient *s)
+{
+  LogProtoTextClient *self = (LogProtoTextClient *) s;
+
+  LogProtoStatus status = log_proto_text_client_flush_partial(s);
+  if (status != LPS_SUCCESS || self->partial)
+    return status;
+
+  return log_proto_text_client_flush_transport(self);
+}
+
 LogProtoStatus
 log_proto_text_client_submit_write(LogProtoClient *s, guchar *msg, gsize msg_len, GDestroyNotify msg_free,
                                    gint next_state)
@@ -133,7 +190,7 @@ log_proto_text_client_submit_write(LogProtoClient *s, guchar *msg, gsize msg_len
   self->partial_pos = 0;
   self->partial_free = msg_free;
   self->next_state = next_state;
-  return log_proto_text_client_flush(s);
+  return log_proto_text_client_flush_partial(s);
 }
 
 
@@ -155,7 +212,7 @@ log_proto_text_client_post(LogProtoClient *s, LogMessage *logmsg, guchar *msg, g
 
   /* try to flush already buffered data */
   *consumed = FALSE;
-  const LogProtoStatus status = log_proto_text_client_flush(s);
+  const LogProtoStatus status = log_proto_text_client_flush_partial(s);
   if (status == LPS_ERROR)
     {
       /* log_proto_flush() already logs in the case of an error */
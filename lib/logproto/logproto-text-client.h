@@ -33,6 +33,9 @@ typedef struct _LogProtoTextClient
   guchar *partial;
   GDestroyNotify partial_free;
   gsize partial_len, partial_pos;
+  gboolean transport_flush_pending;
+  /* messages written into the transport's buffer, acked on flush */
+  gint pending_acks;
 } LogProtoTextClient;
 
 LogProtoStatus log_proto_text_client_submit_write(LogProtoClient *s, guchar *msg, gsize msg_len,
@@ -28,6 +28,7 @@
 #include "libtest/msg_parse_lib.h"
 
 #include "logproto/logproto-framed-server.h"
+#include "logproto/logproto-buffer-pool.h"
 
 #include <errno.h>
 
@@ -281,3 +282,31 @@ Test(log_proto, test_log_proto_framed_server_multi_read)
 
   /* NOTE: LPBS_NOMREAD is not implemented for framed protocol */
 }
+
+Test(log_proto, test_log_proto_framed_server_returns_buffer_to_pool_on_eagain)
+{
+  LogProtoServer *proto;
+
+  proto_server_options.max_msg_size = 32;
+  proto = log_proto_framed_server_new(
+            log_transport_mock_stream_new(
+              "8 01234567", -1,
+              "6 abc", -1,
+              LTM_INJECT_ERROR(EAGAIN),
+              "def", -1,
+              LTM_EOF),
+            get_inited_proto_server_options());
+
+  gsize free_count = log_proto_buffer_pool_get_local_free_count();
+
+  assert_proto_server_fetch(proto, "01234567", -1);
+  assert_proto_server_fetch_single_read(proto, NULL, -1);
+  cr_assert_eq(log_proto_buffer_pool_get_local_free_count(), free_count + 1);
+
+  /* the pooled buffer is taken again, the partial frame is carried over into it */
+  assert_proto_server_fetch(proto, "abcdef", -1);
+  cr_assert_eq(log_proto_buffer_pool_get_local_free_count(), free_count);
+  assert_proto_server_fetch_failure(proto, LPS_EOF, NULL);
+
+  log_proto_server_free(proto);
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "logproto/logproto-text-client.h"
+#include "logproto/logproto-framed-client.h"
+#include <errno.h>
+#include <string.h>
+
+/* a transport that collects writes in a buffer and only sends them on
+ * flush(), the same way LogTransportTLS does with record-coalescing(yes) */
+typedef struct
+{
+  LogTransport super;
+  GString *buffered;
+  GString *sent;
+  gint write_calls;
+  gint flush_errno;
+} CoalescingTransport;
+
+static gssize
+_coalescing_transport_write(LogTransport *s, const gpointer buf, gsize count)
+{
+  CoalescingTransport *self = (CoalescingTransport *) s;
+
+  self->write_calls++;
+  g_string_append_len(self->buffered, buf, count);
+  return count;
+}
+
+static gssize
+_coalescing_transport_flush(LogTransport *s)
+{
+  CoalescingTransport *self = (CoalescingTransport *) s;
+
+  if (self->flush_errno)
+    {
+      errno = self->flush_errno;
+      return -1;
+    }
+
+  g_string_append_len(self->sent, self->buffered->str, self->buffered->len);
+  g_string_truncate(self->buffered, 0);
+  return 0;
+}
+
+static void
+_coalescing_transport_free(LogTransport *s)
+{
+  CoalescingTransport *self = (CoalescingTransport *) s;
+
+  g_string_free(self->buffered, TRUE);
+  g_string_free(self->sent, TRUE);
+  log_transport_free_method(s);
+}
+
+static CoalescingTransport *
+_coalescing_transport_new(void)
+{
+  CoalescingTransport *self = g_new0(CoalescingTransport, 1);
+
+  log_transport_init_instance(&self->super, -1);
+  self->super.write = _coalescing_transport_write;
+  self->super.flush = _coalescing_transport_flush;
+  self->super.free_fn = _coalescing_transport_free;
+  self->buffered = g_string_new("");
+  self->sent = g_string_new("");
+  return self;
+}
+
+static gint acked_messages;
+
+static void
+_count_acks(gint num_msg_acked, gpointer user_data)
+{
+  acked_messages += num_msg_acked;
+}
+
+static LogProtoClientOptionsStorage client_options;
+
+static LogProtoClient *
+_construct_client(LogProtoClient *(*constructor)(LogTransport *, const LogProtoClientOptions *),
+                  CoalescingTransport *transport)
+{
+  LogProtoClient *proto = constructor(&transport->super, &client_options.super);
+  LogProtoClientFlowControlFuncs flow_control_funcs =
+  {
+    .ack_callback = _count_acks,
+  };
+
+  log_proto_client_set_client_flow_control(proto, &flow_control_funcs);
+  return proto;
+}
+
+static void
+_post(LogProtoClient *proto, const gchar *msg)
+{
+  gboolean consumed = FALSE;
+
+  cr_assert_eq(log_proto_client_post(proto, NULL, (guchar *) g_strdup(msg), strlen(msg), &consumed), LPS_SUCCESS);
+  cr_assert(consumed);
+}
+
+static void
+setup_text_client(void)
+{
+  log_proto_client_options_defaults(&client_options.super);
+  acked_messages = 0;
+}
+
+Test(log_proto_text_client, coalesced_writes_are_sent_in_a_single_flush, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  LogProtoClient *proto = _construct_client(log_proto_text_client_new, transport);
+
+  _post(proto, "message1\n");
+  _post(proto, "message2\n");
+  _post(proto, "message3\n");
+  cr_assert_eq(transport->write_calls, 3);
+  cr_assert_str_empty(transport->sent->str);
+
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_str_eq(transport->sent->str, "message1\nmessage2\nmessage3\n");
+  cr_assert_str_empty(transport->buffered->str);
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto_text_client, acks_are_held_back_until_the_transport_is_flushed, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  LogProtoClient *proto = _construct_client(log_proto_text_client_new, transport);
+
+  _post(proto, "message1\n");
+  _post(proto, "message2\n");
+  cr_assert_eq(acked_messages, 0, "messages still in the transport buffer must not be acked");
+
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_eq(acked_messages, 2);
+
+  /* nothing is acked twice */
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_eq(acked_messages, 2);
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto_text_client, framed_client_acks_after_flush, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  LogProtoClient *proto = _construct_client(log_proto_framed_client_new, transport);
+
+  _post(proto, "message1");
+  cr_assert_eq(acked_messages, 0);
+
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_str_eq(transport->sent->str, "8 message1");
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto_text_client, flush_returning_eagain_keeps_acks_pending, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  LogProtoClient *proto = _construct_client(log_proto_text_client_new, transport);
+  gint fd, timeout = -1;
+  GIOCondition cond;
+
+  _post(proto, "message1\n");
+  cr_assert_not(log_proto_client_prepare(proto, &fd, &cond, &timeout));
+
+  transport->flush_errno = EAGAIN;
+  cr_assert_eq(log_proto_client_flush(proto), LPS_PARTIAL);
+  cr_assert_eq(acked_messages, 0);
+  cr_assert(log_proto_client_prepare(proto, &fd, &cond, &timeout),
+            "a pending transport flush has to be reported as pending write");
+
+  /* messages posted while the flush is pending are acked with the rest */
+  _post(proto, "message2\n");
+  cr_assert_eq(acked_messages, 0);
+
+  transport->flush_errno = 0;
+  cr_assert_eq(log_proto_client_flush(proto), LPS_SUCCESS);
+  cr_assert_eq(acked_messages, 2);
+  cr_assert_str_eq(transport->sent->str, "message1\nmessage2\n");
+  cr_assert_not(log_proto_client_prepare(proto, &fd, &cond, &timeout));
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto_text_client, flush_error_does_not_ack, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  LogProtoClient *proto = _construct_client(log_proto_text_client_new, transport);
+
+  _post(proto, "message1\n");
+
+  transport->flush_errno = ECONNRESET;
+  cr_assert_eq(log_proto_client_flush(proto), LPS_ERROR);
+  cr_assert_eq(acked_messages, 0, "messages lost with the connection must be rewound, not acked");
+
+  log_proto_client_free(proto);
+}
+
+Test(log_proto_text_client, transports_without_flush_ack_immediately, .init = setup_text_client)
+{
+  CoalescingTransport *transport = _coalescing_transport_new();
+  transport->super.flush = NULL;
+  LogProtoClient *proto = _construct_client(log_proto_text_client_new, transport);
+
+  _post(proto, "message1\n");
+  cr_assert_eq(acked_messages, 1);
+
+  log_proto_client_free(proto);
+}
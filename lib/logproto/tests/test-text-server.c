@@ -29,6 +29,7 @@
 #include "libtest/grab-logging.h"
 
 #include "logproto/logproto-text-server.h"
+#include "logproto/logproto-buffer-pool.h"
 #include "ack-tracker/ack_tracker_factory.h"
 
 #include <errno.h>
@@ -645,6 +646,37 @@ Test(log_proto, test_log_proto_text_server_io_eagain)
   log_proto_server_free(proto);
 }
 
+Test(log_proto, test_log_proto_text_server_returns_buffer_to_pool_on_eagain)
+{
+  LogProtoServer *proto;
+
+  proto = construct_test_proto(
+            log_transport_mock_stream_new(
+              "01234567\nabc", -1,
+              LTM_INJECT_ERROR(EAGAIN),
+              "def\n", -1,
+              LTM_EOF));
+
+  Bookmark bookmark;
+  LogTransportAuxData aux;
+  gboolean may_read = TRUE;
+  const guchar *msg = NULL;
+  gsize msg_len;
+  gsize free_count = log_proto_buffer_pool_get_local_free_count();
+
+  log_transport_aux_data_init(&aux);
+  assert_proto_server_fetch(proto, "01234567", -1);
+  cr_assert_eq(log_proto_server_fetch(proto, &msg, &msg_len, &may_read, &aux, &bookmark), LPS_AGAIN);
+  cr_assert_eq(log_proto_buffer_pool_get_local_free_count(), free_count + 1);
+
+  /* the partial line is carried over into the next buffer */
+  assert_proto_server_fetch(proto, "abcdef", -1);
+  cr_assert_eq(log_proto_buffer_pool_get_local_free_count(), free_count);
+  assert_proto_server_fetch_failure(proto, LPS_EOF, NULL);
+
+  log_proto_server_free(proto);
+}
+
 Test(log_proto, buffer_split_with_encoding_and_position_tracking)
 {
   GString *data = g_string_new("Lorem ipsum\xe2\x98\x83lor sit amet, consectetur adipiscing elit\n");
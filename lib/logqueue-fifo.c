@@ -69,11 +69,28 @@ QueueType log_queue_fifo_type = "FIFO";
  *   - the head of the queue is only manipulated from the output thread
  *   - the tail of the queue is only manipulated from the input threads
  *
+ * LogMessageQueueNodes (except the ones embedded into the LogMessage, as
+ * many as the widest fan-out seen so far, up to 32) are recycled through
+ * node pools that follow the same pattern: each input queue has its own
+ * unlocked pool, refilled from the locked shared pool whenever the input
+ * queue is moved to the wait queue, while the output thread collects acked
+ * nodes in an unlocked pool of its own, which is handed over to the shared
+ * pool when the wait queue is taken over.
  */
 
+#define LOG_QUEUE_FIFO_NODE_POOL_MAX 1024
+#define LOG_QUEUE_FIFO_INPUT_NODE_POOL_MAX 128
+
+typedef struct _QueueNodePool
+{
+  struct iv_list_head nodes;
+  gint len;
+} QueueNodePool;
+
 typedef struct _InputQueue
 {
   struct iv_list_head items;
+  QueueNodePool free_nodes;
   WorkerBatchCallback cb;
   guint32 len;
   guint32 non_flow_controlled_len;
@@ -96,6 +113,9 @@ typedef struct _LogQueueFifo
   OverflowQueue wait_queue;
   OverflowQueue backlog_queue; /* entries that were sent but not acked yet */
 
+  QueueNodePool free_nodes; /* protected by super.lock */
+  QueueNodePool released_nodes; /* only touched by the output thread */
+
   gint log_fifo_size;
 
   /* legacy: flow-controlled messages are included in the log_fifo_size limit */
@@ -105,6 +125,72 @@ typedef struct _LogQueueFifo
   InputQueue input_queues[0];
 } LogQueueFifo;
 
+static void
+queue_node_pool_init(QueueNodePool *self)
+{
+  INIT_IV_LIST_HEAD(&self->nodes);
+  self->len = 0;
+}
+
+static LogMessageQueueNode *
+queue_node_pool_alloc(QueueNodePool *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  LogMessageQueueNode *node = log_msg_alloc_embedded_queue_node(msg, path_options);
+
+  if (node)
+    return node;
+
+  if (iv_list_empty(&self->nodes))
+    return log_msg_alloc_dynamic_queue_node(msg, path_options);
+
+  node = iv_list_entry(self->nodes.next, LogMessageQueueNode, list);
+  iv_list_del(&node->list);
+  self->len--;
+  log_msg_init_queue_node(msg, node, path_options);
+  return node;
+}
+
+static void
+queue_node_pool_release(QueueNodePool *self, LogMessageQueueNode *node)
+{
+  if (node->embedded || self->len >= LOG_QUEUE_FIFO_NODE_POOL_MAX)
+    {
+      log_msg_free_queue_node(node);
+      return;
+    }
+
+  iv_list_add(&node->list, &self->nodes);
+  self->len++;
+}
+
+/* moves nodes from @src to @dst, until @dst reaches @limit */
+static void
+queue_node_pool_move(QueueNodePool *dst, QueueNodePool *src, gint limit)
+{
+  while (dst->len < limit && !iv_list_empty(&src->nodes))
+    {
+      struct iv_list_head *ilh = src->nodes.next;
+
+      iv_list_del(ilh);
+      iv_list_add(ilh, &dst->nodes);
+      src->len--;
+      dst->len++;
+    }
+}
+
+static void
+queue_node_pool_free(QueueNodePool *self)
+{
+  while (!iv_list_empty(&self->nodes))
+    {
+      LogMessageQueueNode *node = iv_list_entry(self->nodes.next, LogMessageQueueNode, list);
+
+      iv_list_del(&node->list);
+      log_msg_free_queue_node(node);
+    }
+  self->len = 0;
+}
+
 /* NOTE: this is inherently racy. If the LogQueue->lock is taken, then the
  * race is limited to the changes in output_queue queue changes.
  *
@@ -188,12 +274,13 @@ log_queue_fifo_drop_messages_from_input_queue(LogQueueFifo *self, InputQueue *in
       if (!self->use_legacy_fifo_size && path_options.flow_control_requested)
         continue;
 
+      LogMessage *msg = node->msg;
+
       iv_list_del(&node->list);
       input_queue->len--;
       log_queue_dropped_messages_inc(&self->super);
-      log_msg_free_queue_node(node);
+      queue_node_pool_release(&self->free_nodes, node);
 
-      LogMessage *msg = node->msg;
       if (path_options.flow_control_requested)
         log_msg_drop(msg, &path_options, AT_SUSPENDED);
       else
@@ -275,6 +362,9 @@ log_queue_fifo_move_input_unlocked(LogQueueFifo *self, gint thread_index)
   self->wait_queue.non_flow_controlled_len += self->input_queues[thread_index].non_flow_controlled_len;
   self->input_queues[thread_index].len = 0;
   self->input_queues[thread_index].non_flow_controlled_len = 0;
+
+  queue_node_pool_move(&self->input_queues[thread_index].free_nodes, &self->free_nodes,
+                       LOG_QUEUE_FIFO_INPUT_NODE_POOL_MAX);
 }
 
 /* move items from the per-thread input queue to the lock-protected
@@ -378,7 +468,7 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
         }
 
       log_msg_write_protect(msg);
-      node = log_msg_alloc_queue_node(msg, path_options);
+      node = queue_node_pool_alloc(&self->input_queues[thread_index].free_nodes, msg, path_options);
       iv_list_add_tail(&node->list, &self->input_queues[thread_index].items);
       self->input_queues[thread_index].len++;
 
@@ -408,7 +498,7 @@ log_queue_fifo_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *pat
     }
 
   log_msg_write_protect(msg);
-  node = log_msg_alloc_queue_node(msg, path_options);
+  node = queue_node_pool_alloc(&self->free_nodes, msg, path_options);
 
   iv_list_add_tail(&node->list, &self->wait_queue.items);
   self->wait_queue.len++;
@@ -438,6 +528,7 @@ _move_items_from_wait_queue_to_output_queue(LogQueueFifo *self)
   self->output_queue.non_flow_controlled_len = self->wait_queue.non_flow_controlled_len;
   self->wait_queue.len = 0;
   self->wait_queue.non_flow_controlled_len = 0;
+  queue_node_pool_move(&self->free_nodes, &self->released_nodes, LOG_QUEUE_FIFO_NODE_POOL_MAX);
   g_mutex_unlock(&self->super.lock);
 }
 
@@ -542,7 +633,7 @@ log_queue_fifo_ack_backlog(LogQueue *s, gint rewind_count)
 
       path_options.ack_needed = node->ack_needed;
       log_msg_ack(msg, &path_options, AT_PROCESSED);
-      log_msg_free_queue_node(node);
+      queue_node_pool_release(&self->released_nodes, node);
       log_msg_unref(msg);
     }
 }
@@ -637,11 +728,14 @@ log_queue_fifo_free(LogQueue *s)
     {
       g_assert(self->input_queues[i].finish_cb_registered == FALSE);
       log_queue_fifo_free_queue(&self->input_queues[i].items);
+      queue_node_pool_free(&self->input_queues[i].free_nodes);
     }
 
   log_queue_fifo_free_queue(&self->wait_queue.items);
   log_queue_fifo_free_queue(&self->output_queue.items);
   log_queue_fifo_free_queue(&self->backlog_queue.items);
+  queue_node_pool_free(&self->free_nodes);
+  queue_node_pool_free(&self->released_nodes);
   log_queue_free_method(s);
 }
 
@@ -678,6 +772,7 @@ log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_lev
   for (gint i = 0; i < self->num_input_queues; i++)
     {
       INIT_IV_LIST_HEAD(&self->input_queues[i].items);
+      queue_node_pool_init(&self->input_queues[i].free_nodes);
       worker_batch_callback_init(&self->input_queues[i].cb);
       self->input_queues[i].cb.func = log_queue_fifo_move_input;
       self->input_queues[i].cb.user_data = self;
@@ -685,6 +780,8 @@ log_queue_fifo_new(gint log_fifo_size, const gchar *persist_name, gint stats_lev
   INIT_IV_LIST_HEAD(&self->wait_queue.items);
   INIT_IV_LIST_HEAD(&self->output_queue.items);
   INIT_IV_LIST_HEAD(&self->backlog_queue.items);
+  queue_node_pool_init(&self->free_nodes);
+  queue_node_pool_init(&self->released_nodes);
 
   self->log_fifo_size = log_fifo_size;
 
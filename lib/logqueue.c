@@ -27,6 +27,7 @@
 #include "stats/stats-cluster-single.h"
 #include "messages.h"
 #include "timeutils/misc.h"
+#include "timeutils/cache.h"
 
 void
 log_queue_memory_usage_add(LogQueue *self, gsize value)
@@ -87,6 +88,104 @@ log_queue_dropped_messages_inc(LogQueue *self)
   stats_counter_inc(self->metrics.shared.dropped_messages);
 }
 
+/*
+ * Queue introspection: the age of dequeued messages (measured from their
+ * receipt, so time spent in a disk-buffer before a restart is included,
+ * each message is counted once, popping it again after a rewind is not),
+ * the number of messages waiting for an ack and the number of rewound and
+ * acked messages.  These are maintained by the log_queue_*() wrappers, so
+ * every queue implementation gets them.  The backlog is tracked on the
+ * consumer side only, which is a single thread per queue.
+ */
+static const struct
+{
+  gint64 max_age;
+  const gchar *label;
+} message_age_buckets[LOG_QUEUE_MESSAGE_AGE_BUCKETS] =
+{
+  { 1, "1" },
+  { 10, "10" },
+  { 60, "60" },
+  { 600, "600" },
+  { G_MAXINT64, "+Inf" },
+};
+
+void
+log_queue_message_dequeued(LogQueue *self, LogMessage *msg)
+{
+  if (!self->metrics.owned.backlog)
+    return;
+
+  stats_counter_inc(self->metrics.owned.backlog);
+
+  /* rewinds put the messages back to the head of the queue */
+  if (self->metrics.owned.repops_pending > 0)
+    {
+      self->metrics.owned.repops_pending--;
+      return;
+    }
+
+  gint64 age = MAX(get_cached_realtime_sec() - msg->timestamps[LM_TS_RECVD].ut_sec, 0);
+  for (gint i = 0; i < LOG_QUEUE_MESSAGE_AGE_BUCKETS; i++)
+    {
+      if (age <= message_age_buckets[i].max_age)
+        stats_counter_inc(self->metrics.owned.message_age[i]);
+    }
+  stats_counter_inc(self->metrics.owned.message_age_count);
+  stats_counter_add(self->metrics.owned.message_age_sum, age);
+}
+
+static gsize
+_take_from_backlog(LogQueue *self, gsize n)
+{
+  gsize backlog = stats_counter_get(self->metrics.owned.backlog);
+
+  n = MIN(n, backlog);
+  stats_counter_sub(self->metrics.owned.backlog, n);
+  return n;
+}
+
+void
+log_queue_backlog_acked(LogQueue *self, gint n)
+{
+  if (!self->metrics.owned.backlog || n <= 0)
+    return;
+
+  stats_counter_add(self->metrics.owned.acked, _take_from_backlog(self, n));
+  stats_counter_inc(self->metrics.owned.ack_batches);
+}
+
+void
+log_queue_backlog_rewound(LogQueue *self, guint n)
+{
+  if (!self->metrics.owned.backlog)
+    return;
+
+  gsize rewound = _take_from_backlog(self, n);
+  stats_counter_add(self->metrics.owned.rewound, rewound);
+  self->metrics.owned.repops_pending += rewound;
+}
+
+void
+log_queue_backlog_rewound_all(LogQueue *self)
+{
+  if (!self->metrics.owned.backlog)
+    return;
+
+  gsize rewound = _take_from_backlog(self, G_MAXSIZE);
+  stats_counter_add(self->metrics.owned.rewound, rewound);
+  self->metrics.owned.repops_pending += rewound;
+}
+
+/* the backlog and the rewound messages have left the queue without being
+ * popped (again), e.g. the queue was stopped, restarted or freed */
+void
+log_queue_backlog_reset(LogQueue *self)
+{
+  stats_counter_set(self->metrics.owned.backlog, 0);
+  self->metrics.owned.repops_pending = 0;
+}
+
 /*
  * When this is called, it is assumed that the output thread is currently
  * not running (since this is the function that wakes it up), thus we can
@@ -289,6 +388,69 @@ _register_owned_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilde
   stats_unlock();
 }
 
+static void
+_register_introspection_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilder *builder)
+{
+  if (!builder)
+    return;
+
+  stats_level = MAX(stats_level, STATS_LEVEL1);
+
+  for (gint i = 0; i < LOG_QUEUE_MESSAGE_AGE_BUCKETS; i++)
+    {
+      stats_cluster_key_builder_push(builder);
+      {
+        stats_cluster_key_builder_set_name(builder, "dequeued_event_age_seconds_bucket");
+        stats_cluster_key_builder_add_label(builder, stats_cluster_label("le", message_age_buckets[i].label));
+        self->metrics.owned.message_age_sc_keys[i] = stats_cluster_key_builder_build_single(builder);
+      }
+      stats_cluster_key_builder_pop(builder);
+    }
+
+  /* together with the buckets these make a Prometheus histogram */
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_name(builder, "dequeued_event_age_seconds_count");
+    self->metrics.owned.message_age_count_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "dequeued_event_age_seconds_sum");
+    self->metrics.owned.message_age_sum_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "backlog_events");
+    self->metrics.owned.backlog_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "rewound_events_total");
+    self->metrics.owned.rewound_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "ack_batches_total");
+    self->metrics.owned.ack_batches_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "acked_events_total");
+    self->metrics.owned.acked_sc_key = stats_cluster_key_builder_build_single(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_lock();
+  {
+    for (gint i = 0; i < LOG_QUEUE_MESSAGE_AGE_BUCKETS; i++)
+      stats_register_counter(stats_level, self->metrics.owned.message_age_sc_keys[i], SC_TYPE_SINGLE_VALUE,
+                             &self->metrics.owned.message_age[i]);
+    stats_register_counter(stats_level, self->metrics.owned.message_age_count_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.message_age_count);
+    stats_register_counter(stats_level, self->metrics.owned.message_age_sum_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.message_age_sum);
+    stats_register_counter(stats_level, self->metrics.owned.backlog_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.backlog);
+    stats_register_counter(stats_level, self->metrics.owned.rewound_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.rewound);
+    stats_register_counter(stats_level, self->metrics.owned.ack_batches_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.ack_batches);
+    stats_register_counter(stats_level, self->metrics.owned.acked_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.owned.acked);
+  }
+  stats_unlock();
+}
+
 static void
 _register_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilder *driver_sck_builder,
                    StatsClusterKeyBuilder *queue_sck_builder)
@@ -297,6 +459,7 @@ _register_counters(LogQueue *self, gint stats_level, StatsClusterKeyBuilder *dri
 
   _register_shared_counters(self, stats_level, driver_sck_builder);
   _register_owned_counters(self, stats_level, queue_sck_builder);
+  _register_introspection_counters(self, stats_level, queue_sck_builder);
 }
 
 static void
@@ -351,11 +514,43 @@ _unregister_owned_counters(LogQueue *self)
   stats_unlock();
 }
 
+static void
+_unregister_counter(StatsClusterKey *sc_key, StatsCounterItem **counter)
+{
+  if (!sc_key)
+    return;
+
+  stats_unregister_counter(sc_key, SC_TYPE_SINGLE_VALUE, counter);
+  stats_cluster_key_free(sc_key);
+}
+
+static void
+_unregister_introspection_counters(LogQueue *self)
+{
+  /* the counters outlive the queue, the next instance (e.g. after a
+   * reload) must not inherit its backlog */
+  log_queue_backlog_reset(self);
+
+  stats_lock();
+  {
+    for (gint i = 0; i < LOG_QUEUE_MESSAGE_AGE_BUCKETS; i++)
+      _unregister_counter(self->metrics.owned.message_age_sc_keys[i], &self->metrics.owned.message_age[i]);
+    _unregister_counter(self->metrics.owned.message_age_count_sc_key, &self->metrics.owned.message_age_count);
+    _unregister_counter(self->metrics.owned.message_age_sum_sc_key, &self->metrics.owned.message_age_sum);
+    _unregister_counter(self->metrics.owned.backlog_sc_key, &self->metrics.owned.backlog);
+    _unregister_counter(self->metrics.owned.rewound_sc_key, &self->metrics.owned.rewound);
+    _unregister_counter(self->metrics.owned.ack_batches_sc_key, &self->metrics.owned.ack_batches);
+    _unregister_counter(self->metrics.owned.acked_sc_key, &self->metrics.owned.acked);
+  }
+  stats_unlock();
+}
+
 static void
 _unregister_counters(LogQueue *self)
 {
   _unregister_shared_counters(self);
   _unregister_owned_counters(self);
+  _unregister_introspection_counters(self);
 }
 
 void
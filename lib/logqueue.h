@@ -35,6 +35,9 @@ typedef struct _LogQueue LogQueue;
 
 typedef const char *QueueType;
 
+/* buckets of the dequeued message age histogram, the last one is +Inf */
+#define LOG_QUEUE_MESSAGE_AGE_BUCKETS 5
+
 typedef struct _LogQueueMetrics
 {
   struct
@@ -54,6 +57,26 @@ typedef struct _LogQueueMetrics
 
     StatsCounterItem *memory_usage;
     StatsCounterItem *queued_messages;
+
+    StatsClusterKey *message_age_sc_keys[LOG_QUEUE_MESSAGE_AGE_BUCKETS];
+    StatsClusterKey *message_age_count_sc_key;
+    StatsClusterKey *message_age_sum_sc_key;
+    StatsClusterKey *backlog_sc_key;
+    StatsClusterKey *rewound_sc_key;
+    StatsClusterKey *ack_batches_sc_key;
+    StatsClusterKey *acked_sc_key;
+
+    StatsCounterItem *message_age[LOG_QUEUE_MESSAGE_AGE_BUCKETS];
+    StatsCounterItem *message_age_count;
+    StatsCounterItem *message_age_sum;
+    StatsCounterItem *backlog;
+    StatsCounterItem *rewound;
+    StatsCounterItem *ack_batches;
+    StatsCounterItem *acked;
+
+    /* rewound messages that have not been popped again yet, they are at
+     * the head of the queue, and are left out of the age histogram */
+    gsize repops_pending;
   } owned;
 } LogQueueMetrics;
 
@@ -89,6 +112,12 @@ struct _LogQueue
   void (*free_fn)(LogQueue *self);
 };
 
+void log_queue_message_dequeued(LogQueue *self, LogMessage *msg);
+void log_queue_backlog_acked(LogQueue *self, gint n);
+void log_queue_backlog_rewound(LogQueue *self, guint n);
+void log_queue_backlog_rewound_all(LogQueue *self);
+void log_queue_backlog_reset(LogQueue *self);
+
 static inline gboolean
 log_queue_keep_on_reload(LogQueue *self)
 {
@@ -127,10 +156,13 @@ log_queue_pop_head(LogQueue *self, LogPathOptions *path_options)
     return NULL;
 
   msg = self->pop_head(self, path_options);
+  if (!msg)
+    return NULL;
 
-  if (msg && self->throttle_buckets > 0)
+  if (self->throttle_buckets > 0)
     self->throttle_buckets--;
 
+  log_queue_message_dequeued(self, msg);
   return msg;
 }
 
@@ -143,24 +175,31 @@ log_queue_peek_head(LogQueue *self)
 static inline LogMessage *
 log_queue_pop_head_ignore_throttle(LogQueue *self, LogPathOptions *path_options)
 {
-  return self->pop_head(self, path_options);
+  LogMessage *msg = self->pop_head(self, path_options);
+
+  if (msg)
+    log_queue_message_dequeued(self, msg);
+  return msg;
 }
 
 static inline void
 log_queue_rewind_backlog(LogQueue *self, guint rewind_count)
 {
+  log_queue_backlog_rewound(self, rewind_count);
   self->rewind_backlog(self, rewind_count);
 }
 
 static inline void
 log_queue_rewind_backlog_all(LogQueue *self)
 {
+  log_queue_backlog_rewound_all(self);
   self->rewind_backlog_all(self);
 }
 
 static inline void
 log_queue_ack_backlog(LogQueue *self, guint rewind_count)
 {
+  log_queue_backlog_acked(self, rewind_count);
   self->ack_backlog(self, rewind_count);
 }
 
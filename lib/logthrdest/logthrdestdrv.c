@@ -30,12 +30,34 @@
 #include "scratch-buffers.h"
 #include "template/eval.h"
 #include "mainloop-threaded-worker.h"
+#include "tls-support.h"
 
 #include <string.h>
 
 #define MAX_RETRIES_ON_ERROR_DEFAULT 3
 #define MAX_RETRIES_BEFORE_SUSPEND_DEFAULT 3
 
+/* queues shorter than this never spill, reordering a key is not worth it
+ * for a backlog that a worker clears in a single batch or two */
+#define WORKER_PARTITION_SPILL_THRESHOLD_MIN 100
+
+/* messages of the queue of a removed worker are moved over to the running
+ * workers in chunks of this size, so that a large disk-buffer does not hold
+ * up the deliveries of the worker doing the move */
+#define ADOPTED_QUEUE_MOVE_CHUNK 1000
+
+/* retry interval when the queues of the running workers have no room for
+ * the messages of an adopted queue */
+#define ADOPTED_QUEUE_RETRY_MSEC 1000
+
+TLS_BLOCK_START
+{
+  gboolean adopted_message_dropped;
+}
+TLS_BLOCK_END;
+
+#define adopted_message_dropped __tls_deref(adopted_message_dropped)
+
 const gchar *
 log_threaded_result_to_str(LogThreadedResult self)
 {
@@ -71,6 +93,30 @@ log_threaded_dest_driver_set_batch_timeout(LogDriver *s, gint batch_timeout)
   self->batch_timeout = batch_timeout;
 }
 
+void
+log_threaded_dest_driver_set_adaptive_batching(LogDriver *s, gboolean enabled)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  self->adaptive_batching.enabled = enabled;
+}
+
+void
+log_threaded_dest_driver_set_batch_lines_min(LogDriver *s, gint batch_lines_min)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  self->adaptive_batching.batch_lines_min = batch_lines_min;
+}
+
+void
+log_threaded_dest_driver_set_batch_latency_target(LogDriver *s, gint latency_target)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  self->adaptive_batching.latency_target = latency_target;
+}
+
 void
 log_threaded_dest_driver_set_time_reopen(LogDriver *s, time_t time_reopen)
 {
@@ -126,24 +172,52 @@ log_threaded_dest_worker_rewind_messages(LogThreadedDestWorker *self, gint batch
 }
 
 static gchar *
-_format_queue_persist_name(LogThreadedDestWorker *self)
+_format_worker_queue_persist_name(LogThreadedDestDriver *owner, gint worker_index)
 {
-  LogPipe *owner = &self->owner->super.super.super;
+  LogPipe *s = &owner->super.super.super;
 
-  if (self->worker_index == 0)
+  if (worker_index == 0)
     {
       /* the first worker uses the legacy persist name, e.g.  to be able to
        * recover the queue previously used.  */
-      return g_strdup(log_pipe_get_persist_name(owner));
+      return g_strdup(log_pipe_get_persist_name(s));
     }
   else
     {
       return g_strdup_printf("%s.%d.queue",
-                             log_pipe_get_persist_name(owner),
-                             self->worker_index);
+                             log_pipe_get_persist_name(s),
+                             worker_index);
     }
 }
 
+static gchar *
+_format_queue_persist_name(LogThreadedDestWorker *self)
+{
+  return _format_worker_queue_persist_name(self->owner, self->worker_index);
+}
+
+
+static inline gboolean
+_adaptive_batching_enabled(LogThreadedDestWorker *self)
+{
+  return self->owner->adaptive_batching.enabled && self->owner->batch_lines > 1;
+}
+
+static inline gint
+_batch_lines(LogThreadedDestWorker *self)
+{
+  if (_adaptive_batching_enabled(self))
+    return self->batching.batch_lines;
+  return self->owner->batch_lines;
+}
+
+static inline gint
+_batch_timeout(LogThreadedDestWorker *self)
+{
+  if (_adaptive_batching_enabled(self))
+    return self->batching.batch_timeout;
+  return self->owner->batch_timeout;
+}
 
 static gboolean
 _should_flush_now(LogThreadedDestWorker *self)
@@ -151,8 +225,8 @@ _should_flush_now(LogThreadedDestWorker *self)
   struct timespec now;
   glong diff;
 
-  if (self->owner->batch_timeout <= 0 ||
-      self->owner->batch_lines <= 1 ||
+  if (_batch_timeout(self) <= 0 ||
+      _batch_lines(self) <= 1 ||
       !self->enable_batching)
     return TRUE;
 
@@ -160,7 +234,83 @@ _should_flush_now(LogThreadedDestWorker *self)
   now = iv_now;
   diff = timespec_diff_msec(&now, &self->last_flush_time);
 
-  return (diff >= self->owner->batch_timeout);
+  return (diff >= _batch_timeout(self));
+}
+
+static void
+_init_batching(LogThreadedDestWorker *self)
+{
+  self->batching.batch_lines = self->owner->batch_lines;
+  self->batching.batch_timeout = self->owner->batch_timeout;
+
+  stats_counter_set(self->metrics.adaptive_batch_size, MAX(self->batching.batch_lines, 0));
+  stats_counter_set(self->metrics.adaptive_batch_timeout, MAX(self->batching.batch_timeout, 0));
+}
+
+/*
+ * AIMD controller of the batch size and the flush deadline, run after each
+ * flush:
+ *
+ *   - a failed flush or one slower than batch-latency-target() halves the
+ *     batch size (down to batch-lines-min())
+ *
+ *   - a full batch while the queue still holds at least another batch worth
+ *     of messages grows the batch size by 1/16th of batch-lines(), and the
+ *     deadline by 1/16th of batch-timeout()
+ *
+ *   - a partial batch with an empty queue means that waiting for the
+ *     deadline did not help amortizing the flush, the deadline is halved
+ *     (down to 1/16th of batch-timeout()) to cut latency
+ *
+ * batch-lines() and batch-timeout() remain the upper bounds.
+ */
+static void
+_adapt_batching(LogThreadedDestWorker *self, LogThreadedResult result, gint batch_size, gint64 flush_usec)
+{
+  LogThreadedDestDriver *owner = self->owner;
+
+  if (!_adaptive_batching_enabled(self) || batch_size == 0)
+    return;
+
+  gint batch_lines = self->batching.batch_lines;
+  gint batch_timeout = self->batching.batch_timeout;
+  gint queue_length = log_queue_get_length(self->queue);
+  gboolean failed = result != LTR_SUCCESS && result != LTR_EXPLICIT_ACK_MGMT && result != LTR_QUEUED;
+  gboolean too_slow = owner->adaptive_batching.latency_target > 0 &&
+                      flush_usec / 1000 > owner->adaptive_batching.latency_target;
+
+  if (failed || too_slow)
+    {
+      batch_lines = MAX(batch_lines / 2, MIN(owner->adaptive_batching.batch_lines_min, owner->batch_lines));
+    }
+  else if (batch_size >= batch_lines && queue_length >= batch_lines)
+    {
+      batch_lines = MIN(batch_lines + MAX(owner->batch_lines / 16, 1), owner->batch_lines);
+      if (owner->batch_timeout > 0)
+        batch_timeout = MIN(batch_timeout + MAX(owner->batch_timeout / 16, 1), owner->batch_timeout);
+    }
+  else if (batch_size < batch_lines && queue_length == 0 && owner->batch_timeout > 0)
+    {
+      batch_timeout = MAX(batch_timeout / 2, MAX(owner->batch_timeout / 16, 1));
+    }
+
+  if (batch_lines != self->batching.batch_lines || batch_timeout != self->batching.batch_timeout)
+    {
+      msg_trace("Adjusting batch parameters",
+                evt_tag_str("driver", owner->super.super.id),
+                evt_tag_int("worker_index", self->worker_index),
+                evt_tag_int("batch_lines", batch_lines),
+                evt_tag_int("batch_timeout", batch_timeout),
+                evt_tag_int("flushed_batch_size", batch_size),
+                evt_tag_int("flush_latency_msec", (gint)(flush_usec / 1000)),
+                evt_tag_int("queue_length", queue_length),
+                evt_tag_str("result", log_threaded_result_to_str(result)));
+
+      self->batching.batch_lines = batch_lines;
+      self->batching.batch_timeout = batch_timeout;
+      stats_counter_set(self->metrics.adaptive_batch_size, batch_lines);
+      stats_counter_set(self->metrics.adaptive_batch_timeout, batch_timeout);
+    }
 }
 
 static void
@@ -208,6 +358,8 @@ _shutdown_event_callback(gpointer data)
 
   log_queue_reset_parallel_push(self->queue);
   _stop_watches(self);
+  if (iv_timer_registered(&self->timer_adopted_queues))
+    iv_timer_unregister(&self->timer_adopted_queues);
   iv_quit();
 }
 
@@ -407,8 +559,12 @@ _perform_flush(LogThreadedDestWorker *self)
                 evt_tag_int("worker_index", self->worker_index),
                 evt_tag_int("batch_size", self->batch_size));
 
+      gint batch_size = self->batch_size;
+      gint64 flush_start = g_get_monotonic_time();
+
       result = log_threaded_dest_worker_flush(self, LTF_FLUSH_NORMAL);
       _process_result(self, result);
+      _adapt_batching(self, result, batch_size, g_get_monotonic_time() - flush_start);
     }
 
   iv_invalidate_now();
@@ -492,7 +648,7 @@ _perform_inserts(LogThreadedDestWorker *self)
 
       _process_result(self, result);
 
-      if (self->enable_batching && self->batch_size >= self->owner->batch_lines)
+      if (self->enable_batching && self->batch_size >= _batch_lines(self))
         _perform_flush(self);
 
       log_msg_unref(msg);
@@ -542,7 +698,7 @@ static void
 _schedule_restart_on_batch_timeout(LogThreadedDestWorker *self)
 {
   self->timer_flush.expires = self->last_flush_time;
-  timespec_add_msec(&self->timer_flush.expires, self->owner->batch_timeout);
+  timespec_add_msec(&self->timer_flush.expires, _batch_timeout(self));
   iv_timer_register(&self->timer_flush);
 }
 
@@ -694,6 +850,109 @@ _flush_timer_cb(gpointer data)
  *      - if there's an error, disconnect go back to the #1 state above.
  *
  */
+LogThreadedDestWorker *_lookup_worker(LogThreadedDestDriver *self, LogMessage *msg);
+
+static void
+_adopted_message_ack(LogMessage *msg, AckType ack_type)
+{
+  if (ack_type == AT_SUSPENDED)
+    adopted_message_dropped = TRUE;
+}
+
+/* Pushes @msg, popped from an adopted queue, to the queue of @target.
+ *
+ * The message is pushed with flow control and a private ack callback: a
+ * disk-buffer without room for it drops it and acks it with AT_SUSPENDED
+ * right away, see log_queue_disk_drop_message().  In that case FALSE is
+ * returned, and the message is kept in the adopted queue.  */
+static gboolean
+_push_adopted_message(LogThreadedDestWorker *target, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (path_options->ack_needed)
+    {
+      /* still in memory with the ack chain of its source, that goes along */
+      log_queue_push_tail(target->queue, msg, path_options);
+      return TRUE;
+    }
+
+  LogPathOptions local_options = LOG_PATH_OPTIONS_INIT;
+  local_options.flow_control_requested = TRUE;
+
+  msg->ack_func = _adopted_message_ack;
+  log_msg_add_ack(msg, &local_options);
+
+  adopted_message_dropped = FALSE;
+  log_queue_push_tail(target->queue, msg, &local_options);
+  return !adopted_message_dropped;
+}
+
+/* Moves at most ADOPTED_QUEUE_MOVE_CHUNK messages of @queue to the running
+ * workers, using the same worker selection as
+ * log_threaded_dest_driver_queue(), so partitioned messages end up on their
+ * current home worker.  Only the worker that adopted @queue reads it, its
+ * backlog is acked or rewound before returning.  */
+static gboolean
+_move_adopted_messages(LogThreadedDestWorker *self, LogQueue *queue, gboolean *target_full)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg;
+  guint moved = 0;
+
+  while (moved < ADOPTED_QUEUE_MOVE_CHUNK && !self->owner->under_termination
+         && (msg = log_queue_pop_head_ignore_throttle(queue, &path_options)))
+    {
+      LogThreadedDestWorker *target = _lookup_worker(self->owner, msg);
+
+      if (!_push_adopted_message(target, msg, &path_options))
+        {
+          *target_full = TRUE;
+          break;
+        }
+      moved++;
+    }
+
+  /* the moved messages are owned by their new queue, the one that did not
+   * fit is put back */
+  log_queue_ack_backlog(queue, moved);
+  log_queue_rewind_backlog_all(queue);
+
+  return log_queue_get_length(queue) == 0;
+}
+
+static void
+_schedule_adopted_queues_move(LogThreadedDestWorker *self, gint delay_msec)
+{
+  iv_validate_now();
+  self->timer_adopted_queues.expires = iv_now;
+  timespec_add_msec(&self->timer_adopted_queues.expires, delay_msec);
+  iv_timer_register(&self->timer_adopted_queues);
+}
+
+/* moves one chunk per invocation, so the worker's own deliveries are
+ * interleaved with the move */
+static void
+_adopted_queues_timer_cb(gpointer data)
+{
+  LogThreadedDestWorker *self = (LogThreadedDestWorker *) data;
+  gboolean target_full = FALSE;
+
+  if (!self->adopted_queues || self->owner->under_termination)
+    return;
+
+  LogQueue *queue = (LogQueue *) self->adopted_queues->data;
+  if (_move_adopted_messages(self, queue, &target_full))
+    {
+      msg_debug("Messages of an adopted queue moved to the running workers",
+                evt_tag_str("persist_name", queue->persist_name),
+                evt_tag_int("worker_index", self->worker_index),
+                evt_tag_str("driver", self->owner->super.super.id));
+      self->adopted_queues = g_list_delete_link(self->adopted_queues, self->adopted_queues);
+    }
+
+  if (self->adopted_queues)
+    _schedule_adopted_queues_move(self, target_full ? ADOPTED_QUEUE_RETRY_MSEC : 0);
+}
+
 static void
 _init_watches(LogThreadedDestWorker *self)
 {
@@ -717,6 +976,10 @@ _init_watches(LogThreadedDestWorker *self)
   self->timer_flush.cookie = self;
   self->timer_flush.handler = _flush_timer_cb;
 
+  IV_TIMER_INIT(&self->timer_adopted_queues);
+  self->timer_adopted_queues.cookie = self;
+  self->timer_adopted_queues.handler = _adopted_queues_timer_cb;
+
   IV_TASK_INIT(&self->do_work);
   self->do_work.cookie = self;
   self->do_work.handler = _perform_work;
@@ -745,6 +1008,7 @@ _worker_thread_init(MainLoopThreadedWorker *s)
   iv_event_register(&self->wake_up_event);
   iv_event_register(&self->shutdown_event);
 
+  _init_batching(self);
   return log_threaded_dest_worker_init(self);
 }
 
@@ -774,6 +1038,8 @@ _worker_thread(MainLoopThreadedWorker *s)
 
   log_queue_rewind_backlog_all(self->queue);
 
+  if (self->adopted_queues)
+    _schedule_adopted_queues_move(self, 0);
   _schedule_restart(self);
   iv_main();
 
@@ -831,16 +1097,22 @@ _format_legacy_stats_instance(LogThreadedDestDriver *self, StatsClusterKeyBuilde
 }
 
 static void
-_init_worker_sck_builder(LogThreadedDestWorker *self, StatsClusterKeyBuilder *builder)
+_init_queue_sck_builder(LogThreadedDestDriver *owner, gint worker_index, StatsClusterKeyBuilder *builder)
 {
-  stats_cluster_key_builder_add_label(builder, stats_cluster_label("id", self->owner->super.super.id ? : ""));
-  _format_stats_key(self->owner, builder);
+  stats_cluster_key_builder_add_label(builder, stats_cluster_label("id", owner->super.super.id ? : ""));
+  _format_stats_key(owner, builder);
 
   gchar worker_index_str[8];
-  g_snprintf(worker_index_str, sizeof(worker_index_str), "%d", self->worker_index);
+  g_snprintf(worker_index_str, sizeof(worker_index_str), "%d", worker_index);
   stats_cluster_key_builder_add_label(builder, stats_cluster_label("worker", worker_index_str));
 }
 
+static void
+_init_worker_sck_builder(LogThreadedDestWorker *self, StatsClusterKeyBuilder *builder)
+{
+  _init_queue_sck_builder(self->owner, self->worker_index, builder);
+}
+
 static gboolean
 _acquire_worker_queue(LogThreadedDestWorker *self, gint stats_level, StatsClusterKeyBuilder *driver_sck_builder)
 {
@@ -899,6 +1171,37 @@ _register_worker_stats(LogThreadedDestWorker *self)
       self->metrics.message_delay_sample_age_key = stats_cluster_key_builder_build_single(kb);
       stats_register_counter(level, self->metrics.message_delay_sample_age_key, SC_TYPE_SINGLE_VALUE,
                              &self->metrics.message_delay_sample_age);
+
+      if (self->owner->adaptive_batching.enabled)
+        {
+          stats_cluster_key_builder_set_name(kb, "output_adaptive_batch_size");
+          stats_cluster_key_builder_set_unit(kb, SCU_NONE);
+          stats_cluster_key_builder_set_frame_of_reference(kb, SCFOR_NONE);
+          self->metrics.adaptive_batch_size_key = stats_cluster_key_builder_build_single(kb);
+          stats_register_counter(level, self->metrics.adaptive_batch_size_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.adaptive_batch_size);
+
+          stats_cluster_key_builder_set_name(kb, "output_adaptive_batch_timeout_seconds");
+          stats_cluster_key_builder_set_unit(kb, SCU_MILLISECONDS);
+          self->metrics.adaptive_batch_timeout_key = stats_cluster_key_builder_build_single(kb);
+          stats_register_counter(level, self->metrics.adaptive_batch_timeout_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.adaptive_batch_timeout);
+        }
+
+      if (self->owner->worker_partition_key)
+        {
+          stats_cluster_key_builder_set_name(kb, "output_partition_messages_total");
+          stats_cluster_key_builder_set_unit(kb, SCU_NONE);
+          stats_cluster_key_builder_set_frame_of_reference(kb, SCFOR_NONE);
+          self->metrics.partition_messages_key = stats_cluster_key_builder_build_single(kb);
+          stats_register_counter(level, self->metrics.partition_messages_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.partition_messages);
+
+          stats_cluster_key_builder_set_name(kb, "output_partition_spilled_messages_total");
+          self->metrics.partition_spilled_messages_key = stats_cluster_key_builder_build_single(kb);
+          stats_register_counter(level, self->metrics.partition_spilled_messages_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.partition_spilled_messages);
+        }
     }
     stats_unlock();
   }
@@ -939,6 +1242,38 @@ _unregister_worker_stats(LogThreadedDestWorker *self)
         stats_cluster_key_free(self->metrics.message_delay_sample_age_key);
         self->metrics.message_delay_sample_age_key = NULL;
       }
+
+    if (self->metrics.adaptive_batch_size_key)
+      {
+        stats_unregister_counter(self->metrics.adaptive_batch_size_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.adaptive_batch_size);
+        stats_cluster_key_free(self->metrics.adaptive_batch_size_key);
+        self->metrics.adaptive_batch_size_key = NULL;
+      }
+
+    if (self->metrics.adaptive_batch_timeout_key)
+      {
+        stats_unregister_counter(self->metrics.adaptive_batch_timeout_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.adaptive_batch_timeout);
+        stats_cluster_key_free(self->metrics.adaptive_batch_timeout_key);
+        self->metrics.adaptive_batch_timeout_key = NULL;
+      }
+
+    if (self->metrics.partition_messages_key)
+      {
+        stats_unregister_counter(self->metrics.partition_messages_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.partition_messages);
+        stats_cluster_key_free(self->metrics.partition_messages_key);
+        self->metrics.partition_messages_key = NULL;
+      }
+
+    if (self->metrics.partition_spilled_messages_key)
+      {
+        stats_unregister_counter(self->metrics.partition_spilled_messages_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.partition_spilled_messages);
+        stats_cluster_key_free(self->metrics.partition_spilled_messages_key);
+        self->metrics.partition_spilled_messages_key = NULL;
+      }
   }
   stats_unlock();
 
@@ -966,6 +1301,9 @@ log_threaded_dest_worker_deinit_method(LogThreadedDestWorker *self)
 void
 log_threaded_dest_worker_free_method(LogThreadedDestWorker *self)
 {
+  /* the adopted queues themselves are released by the driver */
+  g_list_free(self->adopted_queues);
+  self->adopted_queues = NULL;
   _unregister_worker_stats(self);
 
   main_loop_threaded_worker_clear(&self->thread);
@@ -1029,6 +1367,29 @@ log_threaded_dest_driver_set_flush_on_worker_key_change(LogDriver *s, gboolean f
   self->flush_on_key_change = f;
 }
 
+gboolean
+log_threaded_dest_driver_set_worker_partition_strategy(LogDriver *s, const gchar *strategy)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  if (strcmp(strategy, "modulo") == 0)
+    self->worker_partitioning.strategy = LTPS_MODULO;
+  else if (strcmp(strategy, "consistent-hash") == 0 || strcmp(strategy, "consistent_hash") == 0)
+    self->worker_partitioning.strategy = LTPS_CONSISTENT_HASH;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+log_threaded_dest_driver_set_worker_partition_max_load(LogDriver *s, gint max_load)
+{
+  LogThreadedDestDriver *self = (LogThreadedDestDriver *) s;
+
+  self->worker_partitioning.max_load = max_load;
+}
+
 /* compatibility bridge between LogThreadedDestWorker */
 
 static gboolean
@@ -1125,14 +1486,75 @@ log_threaded_dest_driver_set_max_retries_on_error(LogDriver *s, gint max_retries
   self->retries_on_error_max = max_retries;
 }
 
+/* Lamping, Veach: A Fast, Minimal Memory, Consistent Hash Algorithm */
+static gint
+_jump_consistent_hash(guint64 key, gint num_buckets)
+{
+  gint64 b = -1, j = 0;
+
+  while (j < num_buckets)
+    {
+      b = j;
+      key = key * G_GUINT64_CONSTANT(2862933555777941757) + 1;
+      j = (b + 1) * ((gdouble) (G_GINT64_CONSTANT(1) << 31) / (gdouble) ((key >> 33) + 1));
+    }
+  return b;
+}
+
+static gint
+_lookup_partition_home_worker(LogThreadedDestDriver *self, guint hash)
+{
+  if (self->worker_partitioning.strategy == LTPS_CONSISTENT_HASH)
+    return _jump_consistent_hash(hash, self->num_workers);
+
+  return hash % self->num_workers;
+}
+
+/* Bounded load: a worker takes new messages as long as its queue is not
+ * longer than max-load() percent of the average queue length, otherwise
+ * the message goes to the next worker that is below the bound.  Queue
+ * lengths are sampled without locking, which is fine as this is a
+ * heuristic anyway. */
+static gint
+_spill_partition(LogThreadedDestDriver *self, gint home_index)
+{
+  gint64 total_length = 0;
+
+  for (gint i = 0; i < self->num_workers; i++)
+    total_length += log_queue_get_length(self->workers[i]->queue);
+
+  gint64 max_length = MAX(total_length * self->worker_partitioning.max_load / (100 * self->num_workers),
+                          WORKER_PARTITION_SPILL_THRESHOLD_MIN);
+
+  for (gint i = 0; i < self->num_workers; i++)
+    {
+      gint worker_index = (home_index + i) % self->num_workers;
+
+      if (log_queue_get_length(self->workers[worker_index]->queue) < max_length)
+        return worker_index;
+    }
+
+  return home_index;
+}
+
 LogThreadedDestWorker *
 _lookup_worker(LogThreadedDestDriver *self, LogMessage *msg)
 {
   if (self->worker_partition_key)
     {
       LogTemplateEvalOptions options = DEFAULT_TEMPLATE_EVAL_OPTIONS;
-      guint worker_index = log_template_hash(self->worker_partition_key, msg, &options) % self->num_workers;
-      return self->workers[worker_index];
+      guint hash = log_template_hash(self->worker_partition_key, msg, &options);
+      gint home_index = _lookup_partition_home_worker(self, hash);
+      gint worker_index = home_index;
+
+      if (self->worker_partitioning.max_load > 0 && self->num_workers > 1)
+        worker_index = _spill_partition(self, home_index);
+
+      LogThreadedDestWorker *dw = self->workers[worker_index];
+      stats_counter_inc(dw->metrics.partition_messages);
+      if (worker_index != home_index)
+        stats_counter_inc(self->workers[home_index]->metrics.partition_spilled_messages);
+      return dw;
     }
 
   guint worker_index = self->last_worker;
@@ -1140,6 +1562,66 @@ _lookup_worker(LogThreadedDestDriver *self, LogMessage *msg)
   return self->workers[worker_index];
 }
 
+static gboolean
+_has_persisted_queue(LogThreadedDestDriver *self, const gchar *persist_name)
+{
+  GlobalConfig *cfg = log_pipe_get_config(&self->super.super.super);
+  gsize size;
+  guint8 version;
+
+  return cfg->state && persist_state_lookup_entry(cfg->state, persist_name, &size, &version);
+}
+
+/* When workers() is decreased, the queues of the workers that no longer
+ * exist would keep their messages until the worker count is raised again.
+ * Pick them up and hand them over to the remaining workers, which move
+ * their contents in the background, see _move_adopted_messages().  Only
+ * queues tracked in the persist file (e.g. disk-buffers) are considered,
+ * the queue files themselves are kept, so they are reused when the worker
+ * count is increased again.  */
+static gboolean
+_adopt_queues_of_removed_workers(LogThreadedDestDriver *self, gint stats_level,
+                                 StatsClusterKeyBuilder *driver_sck_builder)
+{
+  for (gint worker_index = self->num_workers; ; worker_index++)
+    {
+      gchar *persist_name = _format_worker_queue_persist_name(self, worker_index);
+
+      if (!_has_persisted_queue(self, persist_name))
+        {
+          g_free(persist_name);
+          return TRUE;
+        }
+
+      StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+      _init_queue_sck_builder(self, worker_index, queue_sck_builder);
+
+      LogQueue *queue = log_dest_driver_acquire_queue(&self->super, persist_name, stats_level, driver_sck_builder,
+                                                      queue_sck_builder);
+      stats_cluster_key_builder_free(queue_sck_builder);
+      g_free(persist_name);
+
+      if (!queue)
+        return FALSE;
+
+      /* the queue stays acquired by the driver, and is released with the
+       * rest of its queues in log_dest_driver_deinit_method() */
+      gint64 queued = log_queue_get_length(queue);
+      if (queued == 0)
+        continue;
+
+      LogThreadedDestWorker *dw = self->workers[worker_index % self->num_workers];
+      dw->adopted_queues = g_list_append(dw->adopted_queues, queue);
+
+      msg_warning("Moving messages of a queue that belonged to a worker no longer configured",
+                  evt_tag_int("worker_index", worker_index),
+                  evt_tag_long("messages", queued),
+                  evt_tag_int("workers", self->num_workers),
+                  evt_tag_str("driver", self->super.super.id),
+                  log_expr_node_location_tag(self->super.super.super.expr_node));
+    }
+}
+
 /* the feeding side of the driver, runs in the source thread and puts an
  * incoming message to the associated queue.
  */
@@ -1381,11 +1863,21 @@ log_threaded_dest_driver_init_method(LogPipe *s)
       return FALSE;
     }
 
+  if (self->worker_partitioning.max_load > 0 && self->worker_partitioning.max_load <= 100)
+    {
+      msg_error("worker-partition-max-load() is a percentage of the average worker queue length, "
+                "it should be larger than 100",
+                evt_tag_int("worker_partition_max_load", self->worker_partitioning.max_load),
+                log_expr_node_location_tag(self->super.super.super.expr_node));
+      return FALSE;
+    }
+
   StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
   _init_driver_sck_builder(self, driver_sck_builder);
 
   gint stats_level = log_pipe_is_internal(&self->super.super.super) ? STATS_LEVEL3 : STATS_LEVEL0;
-  if (!_create_workers(self, stats_level, driver_sck_builder))
+  if (!_create_workers(self, stats_level, driver_sck_builder)
+      || !_adopt_queues_of_removed_workers(self, stats_level, driver_sck_builder))
     {
       stats_cluster_key_builder_free(driver_sck_builder);
       return FALSE;
@@ -1481,4 +1973,10 @@ log_threaded_dest_driver_init_instance(LogThreadedDestDriver *self, GlobalConfig
   self->retries_max = MAX_RETRIES_BEFORE_SUSPEND_DEFAULT;
 
   self->flush_on_key_change = FALSE;
+  self->worker_partitioning.strategy = LTPS_MODULO;
+  self->worker_partitioning.max_load = 0;
+
+  self->adaptive_batching.enabled = FALSE;
+  self->adaptive_batching.batch_lines_min = 1;
+  self->adaptive_batching.latency_target = 0;
 }
@@ -71,6 +71,14 @@ enum
   /* NOTE: everything >= 0x1000 is driver specific */
 };
 
+typedef enum
+{
+  /* hash(worker-partition-key()) % workers() */
+  LTPS_MODULO,
+  /* jump consistent hash, changing workers() only moves 1/workers() of the keys */
+  LTPS_CONSISTENT_HASH,
+} LogThreadedPartitionStrategy;
+
 typedef struct _LogThreadedDestDriver LogThreadedDestDriver;
 typedef struct _LogThreadedDestWorker LogThreadedDestWorker;
 
@@ -85,6 +93,11 @@ struct _LogThreadedDestWorker
   struct iv_timer timer_throttle;
   struct iv_timer timer_flush;
 
+  /* queues of removed workers (workers() was lowered) whose messages this
+   * worker moves over to the running workers */
+  GList *adopted_queues;
+  struct iv_timer timer_adopted_queues;
+
   LogThreadedDestDriver *owner;
 
   gint worker_index;
@@ -104,6 +117,14 @@ struct _LogThreadedDestWorker
     GString *last_key;
   } partitioning;
 
+  /* effective batch_lines/batch_timeout of this worker, tuned at runtime
+   * if adaptive-batching() is enabled */
+  struct
+  {
+    gint batch_lines;
+    gint batch_timeout;
+  } batching;
+
   struct
   {
     StatsClusterKey *output_event_bytes_sc_key;
@@ -114,6 +135,16 @@ struct _LogThreadedDestWorker
     StatsCounterItem *message_delay_sample;
     StatsCounterItem *message_delay_sample_age;
 
+    StatsClusterKey *adaptive_batch_size_key;
+    StatsClusterKey *adaptive_batch_timeout_key;
+    StatsCounterItem *adaptive_batch_size;
+    StatsCounterItem *adaptive_batch_timeout;
+
+    StatsClusterKey *partition_messages_key;
+    StatsClusterKey *partition_spilled_messages_key;
+    StatsCounterItem *partition_messages;
+    StatsCounterItem *partition_spilled_messages;
+
     gint64 last_delay_update;
   } metrics;
 
@@ -154,6 +185,15 @@ struct _LogThreadedDestDriver
 
   gint batch_lines;
   gint batch_timeout;
+
+  /* batch_lines() and batch_timeout() act as upper bounds when enabled */
+  struct
+  {
+    gboolean enabled;
+    gint batch_lines_min;
+    gint latency_target;
+  } adaptive_batching;
+
   gboolean under_termination;
   time_t time_reopen;
   gint retries_on_error_max;
@@ -183,6 +223,15 @@ struct _LogThreadedDestDriver
 
   gboolean flush_on_key_change;
   LogTemplate *worker_partition_key;
+
+  struct
+  {
+    LogThreadedPartitionStrategy strategy;
+    /* percentage of the average worker queue length a worker may have
+     * before the keys hashed to it spill over to the next worker, 0 means
+     * the key -> worker mapping is strict, preserving per-key ordering */
+    gint max_load;
+  } worker_partitioning;
   gint stats_source;
 
   /* this counter is not thread safe if there are multiple worker threads,
@@ -313,8 +362,13 @@ void log_threaded_dest_driver_set_max_retries_on_error(LogDriver *s, gint max_re
 void log_threaded_dest_driver_set_num_workers(LogDriver *s, gint num_workers);
 void log_threaded_dest_driver_set_worker_partition_key_ref(LogDriver *s, LogTemplate *key);
 void log_threaded_dest_driver_set_flush_on_worker_key_change(LogDriver *s, gboolean f);
+gboolean log_threaded_dest_driver_set_worker_partition_strategy(LogDriver *s, const gchar *strategy);
+void log_threaded_dest_driver_set_worker_partition_max_load(LogDriver *s, gint max_load);
 void log_threaded_dest_driver_set_batch_lines(LogDriver *s, gint batch_lines);
 void log_threaded_dest_driver_set_batch_timeout(LogDriver *s, gint batch_timeout);
+void log_threaded_dest_driver_set_adaptive_batching(LogDriver *s, gboolean enabled);
+void log_threaded_dest_driver_set_batch_lines_min(LogDriver *s, gint batch_lines_min);
+void log_threaded_dest_driver_set_batch_latency_target(LogDriver *s, gint latency_target);
 void log_threaded_dest_driver_set_time_reopen(LogDriver *s, time_t time_reopen);
 gboolean log_threaded_dest_driver_process_flag(LogDriver *driver, const gchar *flag);
 
@@ -30,6 +30,8 @@
 #include "mainloop-worker.h"
 #include "apphook.h"
 
+#include <stdlib.h>
+
 typedef struct TestThreadedDestDriver
 {
   LogThreadedDestDriver super;
@@ -806,6 +808,168 @@ Test(logthrdestdrv, test_explicit_ack_accept)
   cr_assert(dd->super.shared_seq_num == 11, "%d", dd->super.shared_seq_num);
 }
 
+static LogThreadedResult
+_insert_batched_message_queued(LogThreadedDestDriver *s, LogMessage *msg)
+{
+  TestThreadedDestDriver *self = (TestThreadedDestDriver *) s;
+
+  self->insert_counter++;
+  return LTR_QUEUED;
+}
+
+static LogThreadedResult
+_flush_batched_message_slowly(LogThreadedDestDriver *s)
+{
+  TestThreadedDestDriver *self = (TestThreadedDestDriver *) s;
+
+  self->flush_counter++;
+  self->flush_size += self->super.worker.instance.batch_size;
+  _sleep_msec(20);
+  return LTR_SUCCESS;
+}
+
+Test(logthrdestdrv, adaptive_batching_shrinks_batches_when_flush_is_slower_than_latency_target)
+{
+  /* adaptive-batching() needs to be configured before the workers start */
+  _teardown_dd();
+  dd = test_threaded_dd_new(main_loop_get_current_config(main_loop));
+
+  dd->super.worker.insert = _insert_batched_message_queued;
+  dd->super.worker.flush = _flush_batched_message_slowly;
+  dd->super.batch_lines = 16;
+  log_threaded_dest_driver_set_adaptive_batching(&dd->super.super.super, TRUE);
+  log_threaded_dest_driver_set_batch_lines_min(&dd->super.super.super, 2);
+  log_threaded_dest_driver_set_batch_latency_target(&dd->super.super.super, 5);
+  cr_assert(log_pipe_init(&dd->super.super.super.super));
+  cr_assert(log_pipe_post_config_init(&dd->super.super.super.super));
+
+  _generate_messages_and_wait_for_processing(dd, 64, dd->super.metrics.written_messages);
+  _spin_for_counter_value(dd->super.worker.instance.metrics.adaptive_batch_size, 2);
+
+  cr_assert(dd->flush_size == 64, "%d", dd->flush_size);
+  cr_assert(dd->super.worker.instance.batching.batch_lines == 2);
+  cr_assert(dd->super.batch_lines == 16, "the configured upper bound must not change");
+}
+
+static LogThreadedDestWorker *
+_construct_idle_worker(LogThreadedDestDriver *s, gint worker_index)
+{
+  LogThreadedDestWorker *self = g_new0(LogThreadedDestWorker, 1);
+
+  log_threaded_dest_worker_init_instance(self, s, worker_index);
+  return self;
+}
+
+/* workers are not started, so messages stay in the queue of the worker they were routed to */
+static void
+_setup_partitioned_dd(gint num_workers, const gchar *key, const gchar *strategy, gint max_load)
+{
+  _teardown_dd();
+  dd = test_threaded_dd_new(main_loop_get_current_config(main_loop));
+
+  dd->super.worker.construct = _construct_idle_worker;
+  log_threaded_dest_driver_set_num_workers(&dd->super.super.super, num_workers);
+  LogTemplate *template = log_template_new(main_loop_get_current_config(main_loop), NULL);
+  cr_assert(log_template_compile(template, key, NULL));
+  log_threaded_dest_driver_set_worker_partition_key_ref(&dd->super.super.super, template);
+  cr_assert(log_threaded_dest_driver_set_worker_partition_strategy(&dd->super.super.super, strategy));
+  log_threaded_dest_driver_set_worker_partition_max_load(&dd->super.super.super, max_load);
+  cr_assert(log_pipe_init(&dd->super.super.super.super));
+}
+
+static gint64
+_worker_queue_length(gint worker_index)
+{
+  return log_queue_get_length(dd->super.workers[worker_index]->queue);
+}
+
+static void
+_map_keys_to_workers(gint num_workers, gint num_keys, gint *worker_of_key)
+{
+  _setup_partitioned_dd(num_workers, "$PID", "consistent-hash", 0);
+  _generate_messages(dd, num_keys, TRUE);
+
+  for (gint i = 0; i < num_workers; i++)
+    {
+      LogQueue *queue = dd->super.workers[i]->queue;
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      LogMessage *msg;
+      guint popped = 0;
+
+      while ((msg = log_queue_pop_head(queue, &path_options)))
+        {
+          worker_of_key[atoi(log_msg_get_value(msg, LM_V_PID, NULL))] = i;
+          log_msg_unref(msg);
+          popped++;
+        }
+      log_queue_ack_backlog(queue, popped);
+    }
+}
+
+Test(logthrdestdrv, consistent_hash_partitioning_only_moves_keys_to_the_new_worker)
+{
+  const gint num_keys = 1000;
+  gint before[1000], after[1000];
+  gint moved = 0;
+
+  _map_keys_to_workers(4, num_keys, before);
+  _map_keys_to_workers(5, num_keys, after);
+
+  for (gint i = 0; i < num_keys; i++)
+    {
+      if (before[i] == after[i])
+        continue;
+
+      cr_assert(after[i] == 4, "key %d moved between existing workers: %d -> %d", i, before[i], after[i]);
+      moved++;
+    }
+
+  /* ideally 1/5 of the keys */
+  cr_assert(moved > num_keys / 10 && moved < num_keys * 3 / 10, "moved=%d", moved);
+}
+
+Test(logthrdestdrv, hot_partition_key_stays_on_its_worker_without_max_load)
+{
+  _setup_partitioned_dd(4, "${APP.VALUE}", "modulo", 0);
+  _generate_messages(dd, 300, TRUE);
+
+  gint home_index = -1;
+  for (gint i = 0; i < 4; i++)
+    {
+      if (_worker_queue_length(i) == 0)
+        continue;
+
+      cr_assert(home_index == -1, "the same key was routed to multiple workers");
+      home_index = i;
+    }
+
+  cr_assert(_worker_queue_length(home_index) == 300);
+  cr_assert(stats_counter_get(dd->super.workers[home_index]->metrics.partition_messages) == 300);
+  cr_assert(stats_counter_get(dd->super.workers[home_index]->metrics.partition_spilled_messages) == 0);
+}
+
+Test(logthrdestdrv, hot_partition_key_spills_to_other_workers_with_max_load)
+{
+  _setup_partitioned_dd(4, "${APP.VALUE}", "consistent-hash", 150);
+  _generate_messages(dd, 300, TRUE);
+
+  gint64 total_length = 0;
+  gsize total_spilled = 0;
+  for (gint i = 0; i < 4; i++)
+    {
+      LogThreadedDestWorker *dw = dd->super.workers[i];
+
+      cr_assert(_worker_queue_length(i) <= 150, "worker %d exceeded the load bound: %" G_GINT64_FORMAT,
+                i, _worker_queue_length(i));
+      cr_assert(stats_counter_get(dw->metrics.partition_messages) == _worker_queue_length(i));
+      total_length += _worker_queue_length(i);
+      total_spilled += stats_counter_get(dw->metrics.partition_spilled_messages);
+    }
+
+  cr_assert(total_length == 300);
+  cr_assert(total_spilled > 0);
+}
+
 MainLoopOptions main_loop_options = {0};
 
 static void
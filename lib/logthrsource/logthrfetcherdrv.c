@@ -42,6 +42,13 @@ log_threaded_fetcher_driver_set_time_reopen(LogDriver *s, time_t time_reopen)
   self->time_reopen = time_reopen;
 }
 
+void
+log_threaded_fetcher_driver_set_fetch_batch_size(LogDriver *s, gint fetch_batch_size)
+{
+  LogThreadedFetcherDriver *self = (LogThreadedFetcherDriver *) s;
+  self->fetch_batch_size = fetch_batch_size;
+}
+
 static EVTTAG *
 _tag_driver(LogThreadedFetcherDriver *f)
 {
@@ -197,9 +204,8 @@ _on_not_connected(LogThreadedFetcherDriver *self)
 }
 
 static void
-_on_fetch_success(LogThreadedFetcherDriver *self, LogMessage *msg)
+_on_fetch_success(LogThreadedFetcherDriver *self)
 {
-  log_threaded_source_worker_post(self->super.workers[0], msg);
   _schedule_next_fetch_if_free_to_send(self);
 }
 
@@ -216,18 +222,58 @@ _on_fetch_no_data(LogThreadedFetcherDriver *self)
   msg_debug("No data during fetching messages", _tag_driver(self));
   _start_no_data_timer(self);
 }
+static ThreadedFetchResult
+_fetch_batch_with_single_fetches(LogThreadedFetcherDriver *self, LogMessage **msgs, gsize max_msgs,
+                                 gsize *num_msgs)
+{
+  *num_msgs = 0;
+  while (*num_msgs < max_msgs && !self->under_termination)
+    {
+      LogThreadedFetchResult fetch_result = self->fetch(self);
+
+      if (fetch_result.result != THREADED_FETCH_SUCCESS)
+        return fetch_result.result;
+
+      msgs[(*num_msgs)++] = fetch_result.msg;
+    }
 
+  return THREADED_FETCH_SUCCESS;
+}
+
+static inline ThreadedFetchResult
+_invoke_fetch_batch(LogThreadedFetcherDriver *self, LogMessage **msgs, gsize max_msgs, gsize *num_msgs)
+{
+  if (self->fetch_batch)
+    return self->fetch_batch(self, msgs, max_msgs, num_msgs);
+
+  return _fetch_batch_with_single_fetches(self, msgs, max_msgs, num_msgs);
+}
+
+/* never fetch more than what the flow-control window can take in */
+static gsize
+_get_fetch_batch_capacity(LogThreadedFetcherDriver *self)
+{
+  LogSource *worker = &self->super.workers[0]->super;
+  gsize window = window_size_counter_get(&worker->window_size, NULL);
+
+  return CLAMP(window, 1, (gsize) self->fetch_batch_size);
+}
 
 static void
 _fetch(gpointer data)
 {
   LogThreadedFetcherDriver *self = (LogThreadedFetcherDriver *) data;
+  gsize num_msgs = 0;
 
   msg_trace("Fetcher fetch()", _tag_driver(self));
 
-  LogThreadedFetchResult fetch_result = self->fetch(self);
+  ThreadedFetchResult result = _invoke_fetch_batch(self, self->fetched_msgs, _get_fetch_batch_capacity(self),
+                                                   &num_msgs);
+
+  if (num_msgs > 0)
+    log_threaded_source_worker_post_batch(self->super.workers[0], self->fetched_msgs, num_msgs);
 
-  switch (fetch_result.result)
+  switch (result)
     {
     case THREADED_FETCH_ERROR:
       _on_fetch_error(self);
@@ -238,7 +284,7 @@ _fetch(gpointer data)
       break;
 
     case THREADED_FETCH_SUCCESS:
-      _on_fetch_success(self, fetch_result.msg);
+      _on_fetch_success(self);
       break;
 
     case THREADED_FETCH_TRY_AGAIN:
@@ -347,7 +393,7 @@ log_threaded_fetcher_driver_init_method(LogPipe *s)
     return FALSE;
 
 
-  g_assert(self->fetch);
+  g_assert(self->fetch || self->fetch_batch);
 
   if (self->time_reopen == -1)
     self->time_reopen = cfg->time_reopen;
@@ -355,6 +401,9 @@ log_threaded_fetcher_driver_init_method(LogPipe *s)
   if (self->no_data_delay == -1)
     log_threaded_fetcher_driver_set_fetch_no_data_delay(&self->super.super.super, cfg->time_reopen);
 
+  g_free(self->fetched_msgs);
+  self->fetched_msgs = g_new0(LogMessage *, self->fetch_batch_size);
+
   return TRUE;
 }
 
@@ -367,6 +416,9 @@ log_threaded_fetcher_driver_deinit_method(LogPipe *s)
 void
 log_threaded_fetcher_driver_free_method(LogPipe *s)
 {
+  LogThreadedFetcherDriver *self = (LogThreadedFetcherDriver *) s;
+
+  g_free(self->fetched_msgs);
   log_threaded_source_driver_free_method(s);
 }
 
@@ -377,6 +429,7 @@ log_threaded_fetcher_driver_init_instance(LogThreadedFetcherDriver *self, Global
 
   self->time_reopen = -1;
   self->no_data_delay = -1;
+  self->fetch_batch_size = 1;
 
   _init_watches(self);
 
@@ -62,6 +62,8 @@ struct _LogThreadedFetcherDriver
   struct iv_timer no_data_timer;
   gboolean suspended;
   gboolean under_termination;
+  gint fetch_batch_size;
+  LogMessage **fetched_msgs;
 
   void (*thread_init)(LogThreadedFetcherDriver *self);
   void (*thread_deinit)(LogThreadedFetcherDriver *self);
@@ -69,6 +71,16 @@ struct _LogThreadedFetcherDriver
   void (*disconnect)(LogThreadedFetcherDriver *self);
   LogThreadedFetchResult (*fetch)(LogThreadedFetcherDriver *self);
 
+  /*
+   * Batched variant of fetch(): stores at most max_msgs messages into
+   * msgs and their count into num_msgs.  Messages returned alongside a
+   * result other than THREADED_FETCH_SUCCESS are posted before the result
+   * is handled.  Drivers implementing only fetch() are driven through a
+   * compatibility loop that calls fetch() repeatedly.
+   */
+  ThreadedFetchResult (*fetch_batch)(LogThreadedFetcherDriver *self, LogMessage **msgs, gsize max_msgs,
+                                     gsize *num_msgs);
+
   void (*request_exit)(LogThreadedFetcherDriver *self);
 };
 
@@ -79,5 +91,6 @@ void log_threaded_fetcher_driver_free_method(LogPipe *s);
 
 void log_threaded_fetcher_driver_set_fetch_no_data_delay(LogDriver *self, gdouble no_data_delay);
 void log_threaded_fetcher_driver_set_time_reopen(LogDriver *s, time_t time_reopen);
+void log_threaded_fetcher_driver_set_fetch_batch_size(LogDriver *s, gint fetch_batch_size);
 
 #endif
@@ -398,8 +398,8 @@ log_threaded_source_worker_close_batch(LogThreadedSourceWorker *self)
   main_loop_worker_invoke_batch_callbacks();
 }
 
-void
-log_threaded_source_worker_post(LogThreadedSourceWorker *self, LogMessage *msg)
+static void
+_post_message(LogThreadedSourceWorker *self, LogMessage *msg)
 {
   msg_debug("Incoming log message",
             evt_tag_str("input", log_msg_get_value(msg, LM_V_MESSAGE, NULL)),
@@ -408,6 +408,27 @@ log_threaded_source_worker_post(LogThreadedSourceWorker *self, LogMessage *msg)
             evt_tag_msg_reference(msg));
   _apply_message_attributes(self->control, msg);
   log_source_post(&self->super, msg);
+}
+
+void
+log_threaded_source_worker_post(LogThreadedSourceWorker *self, LogMessage *msg)
+{
+  _post_message(self, msg);
+
+  if (self->control->auto_close_batches)
+    log_threaded_source_worker_close_batch(self);
+}
+
+/*
+ * Posts messages that were received together, closing the batch only once
+ * at the end.  The caller is responsible for not exceeding the free
+ * flow-control window, just like with log_threaded_source_worker_post().
+ */
+void
+log_threaded_source_worker_post_batch(LogThreadedSourceWorker *self, LogMessage **msgs, gsize num_msgs)
+{
+  for (gsize i = 0; i < num_msgs; i++)
+    _post_message(self, msgs[i]);
 
   if (self->control->auto_close_batches)
     log_threaded_source_worker_close_batch(self);
@@ -129,6 +129,7 @@ void log_threaded_source_worker_blocking_post(LogThreadedSourceWorker *self, Log
 
 /* non-blocking API, use it wisely (thread boundaries) */
 void log_threaded_source_worker_post(LogThreadedSourceWorker *self, LogMessage *msg);
+void log_threaded_source_worker_post_batch(LogThreadedSourceWorker *self, LogMessage **msgs, gsize num_msgs);
 gboolean log_threaded_source_worker_free_to_send(LogThreadedSourceWorker *self);
 
 #endif
@@ -382,3 +382,65 @@ Test(logthrfetcherdrv, test_no_data)
 
   destroy_test_threaded_fetcher(s);
 }
+
+Test(logthrfetcherdrv, test_single_fetches_are_batched_by_the_compat_layer)
+{
+  TestThreadedFetcherDriver *s = create_threaded_fetcher();
+
+  s->num_of_messages_to_generate = 10;
+  log_threaded_fetcher_driver_set_fetch_batch_size(&s->super.super.super.super, 4);
+  s->super.fetch = _fetch;
+
+  start_test_threaded_fetcher(s);
+  wait_for_messages(s);
+  stop_test_threaded_fetcher(s);
+
+  StatsCounterItem *recvd_messages = _get_source(s)->metrics.recvd_messages;
+  cr_assert(stats_counter_get(recvd_messages) == 10);
+
+  destroy_test_threaded_fetcher(s);
+}
+
+static ThreadedFetchResult
+_fetch_batch(LogThreadedFetcherDriver *s, LogMessage **msgs, gsize max_msgs, gsize *num_msgs)
+{
+  TestThreadedFetcherDriver *self = (TestThreadedFetcherDriver *) s;
+
+  cr_assert_leq(max_msgs, 3);
+
+  g_mutex_lock(&self->lock);
+  for (*num_msgs = 0; *num_msgs < max_msgs && self->num_of_messages_to_generate > 0; (*num_msgs)++)
+    {
+      msgs[*num_msgs] = create_sample_message();
+      self->num_of_messages_to_generate--;
+    }
+
+  if (self->num_of_messages_to_generate <= 0)
+    {
+      g_cond_signal(&self->cond);
+      g_mutex_unlock(&self->lock);
+      return THREADED_FETCH_ERROR;
+    }
+  g_mutex_unlock(&self->lock);
+
+  return THREADED_FETCH_SUCCESS;
+}
+
+Test(logthrfetcherdrv, test_fetch_batch)
+{
+  TestThreadedFetcherDriver *s = create_threaded_fetcher();
+
+  s->num_of_messages_to_generate = 10;
+  log_threaded_fetcher_driver_set_fetch_batch_size(&s->super.super.super.super, 3);
+  s->super.fetch_batch = _fetch_batch;
+
+  start_test_threaded_fetcher(s);
+  wait_for_messages(s);
+  stop_test_threaded_fetcher(s);
+
+  /* the last batch is returned together with the error, it is still posted */
+  StatsCounterItem *recvd_messages = _get_source(s)->metrics.recvd_messages;
+  cr_assert(stats_counter_get(recvd_messages) == 10);
+
+  destroy_test_threaded_fetcher(s);
+}
@@ -965,6 +965,27 @@ _get_seq_num(LogWriter *self, LogMessage  *lm)
     }
 }
 
+/*
+ * flags(raw-relay): messages received with flags(raw-relay) or
+ * flags(store-raw-message) are forwarded byte-by-byte as they were
+ * received, without reformatting the syslog header or evaluating the
+ * template.  Returns FALSE if there's no raw message to send, in which
+ * case the usual formatting applies.
+ */
+static gboolean
+log_writer_format_raw_message(LogMessage *lm, GString *result)
+{
+  gssize len;
+  const gchar *raw = log_msg_get_value(lm, LM_V_RAWMSG, &len);
+
+  if (len == 0)
+    return FALSE;
+
+  g_string_append_len(result, raw, len);
+  g_string_append_c(result, '\n');
+  return TRUE;
+}
+
 void
 log_writer_format_log(LogWriter *self, LogMessage *lm, GString *result)
 {
@@ -978,7 +999,11 @@ log_writer_format_log(LogWriter *self, LogMessage *lm, GString *result)
 
   g_string_truncate(result, 0);
 
-  if ((self->flags & LW_SYSLOG_PROTOCOL) || (self->options->options & LWO_SYSLOG_PROTOCOL))
+  if ((self->options->options & LWO_RAW_RELAY) && log_writer_format_raw_message(lm, result))
+    {
+      /* relayed as received, framing is up to LogProto */
+    }
+  else if ((self->flags & LW_SYSLOG_PROTOCOL) || (self->options->options & LWO_SYSLOG_PROTOCOL))
     {
       gssize len;
 
@@ -2037,6 +2062,7 @@ CfgFlagHandler log_writer_flag_handlers[] =
   { "no-seqnum-all",   CFH_CLEAR, offsetof(LogWriterOptions, options), LWO_SEQNUM_ALL },
   { "seqnum",          CFH_SET, offsetof(LogWriterOptions, options),   LWO_SEQNUM },
   { "no-seqnum",       CFH_CLEAR, offsetof(LogWriterOptions, options), LWO_SEQNUM },
+  { "raw-relay",       CFH_SET, offsetof(LogWriterOptions, options), LWO_RAW_RELAY },
   { NULL },
 };
 
@@ -47,6 +47,8 @@
 #define LWO_IGNORE_ERRORS   0x0020
 #define LWO_SEQNUM_ALL      0x0040
 #define LWO_SEQNUM          0x0080
+/* send $RAWMSG verbatim if the message has it, skipping formatting */
+#define LWO_RAW_RELAY       0x0100
 
 typedef struct _LogWriterOptions
 {
@@ -155,6 +155,12 @@ control_connection_config(ControlConnection *cc, GString *command, gpointer user
       goto exit;
     }
 
+  if (g_str_equal(arguments[1], "TIMINGS"))
+    {
+      main_loop_format_reload_timings(main_loop, result);
+      goto exit;
+    }
+
   g_string_assign(result, "FAIL Invalid arguments received");
 
 exit:
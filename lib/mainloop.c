@@ -169,6 +169,17 @@ struct _MainLoop
   ControlServer *control_server;
   CfgMonitor *cfg_monitor;
 
+  /* durations of the phases of the last startup or reload in usec,
+   * reported by "syslog-ng-ctl config --timings" */
+  struct
+  {
+    gint64 started;
+    gint64 parse;
+    gint64 deinit;
+    gint64 init;
+    gint64 total;
+  } reload_timings;
+
   struct
   {
     StatsCounterItem *last_reload;
@@ -284,9 +295,12 @@ main_loop_reload_config_apply(gpointer user_data)
       return;
     }
 
+  gint64 phase_start = g_get_monotonic_time();
+
   self->old_config->persist = persist_config_new();
   cfg_deinit(self->old_config);
   cfg_persist_config_move(self->old_config, self->new_config);
+  self->reload_timings.deinit = g_get_monotonic_time() - phase_start;
 
   /* The threads have stopped, deinit methods were called, but
    * self->current_configuration still points to the old config.  We either
@@ -296,7 +310,11 @@ main_loop_reload_config_apply(gpointer user_data)
 
   app_config_stopped();
 
+  phase_start = g_get_monotonic_time();
   self->last_config_reload_successful = cfg_init(self->new_config);
+  self->reload_timings.init = g_get_monotonic_time() - phase_start;
+  self->reload_timings.total = g_get_monotonic_time() - self->reload_timings.started;
+
   if (!self->last_config_reload_successful)
     {
       msg_error("Error initializing new configuration, reverting to old config");
@@ -305,7 +323,10 @@ main_loop_reload_config_apply(gpointer user_data)
       return;
     }
 
-  msg_verbose("New configuration initialized");
+  msg_verbose("New configuration initialized",
+              evt_tag_long("parse_usec", self->reload_timings.parse),
+              evt_tag_long("init_usec", self->reload_timings.init),
+              evt_tag_long("total_usec", self->reload_timings.total));
   persist_config_free(self->new_config->persist);
   self->new_config->persist = NULL;
   cfg_free(self->old_config);
@@ -345,9 +366,14 @@ main_loop_reload_config_prepare(MainLoop *self, GError **error)
   service_management_publish_status("Reloading configuration");
   stats_counter_set(self->metrics.last_reload, (gsize) self->last_config_reload_time);
 
+  memset(&self->reload_timings, 0, sizeof(self->reload_timings));
+  self->reload_timings.started = g_get_monotonic_time();
+
   self->old_config = self->current_configuration;
   self->new_config = cfg_new(0);
-  if (!cfg_read_config(self->new_config, resolved_configurable_paths.cfgfilename, NULL))
+  gboolean parsed = cfg_read_config(self->new_config, resolved_configurable_paths.cfgfilename, NULL);
+  self->reload_timings.parse = g_get_monotonic_time() - self->reload_timings.started;
+  if (!parsed)
     {
       cfg_free(self->new_config);
       self->new_config = NULL;
@@ -415,6 +441,20 @@ main_loop_get_pending_new_config(MainLoop *self)
   return self->new_config;
 }
 
+void
+main_loop_format_reload_timings(MainLoop *self, GString *result)
+{
+  g_string_printf(result,
+                  "parse %.3f\n"
+                  "deinit %.3f\n"
+                  "init %.3f\n"
+                  "total %.3f",
+                  self->reload_timings.parse / 1e6,
+                  self->reload_timings.deinit / 1e6,
+                  self->reload_timings.init / 1e6,
+                  self->reload_timings.total / 1e6);
+}
+
 /* main_loop_verify_config
  * compares active configuration versus config file */
 
@@ -689,10 +729,12 @@ main_loop_read_and_init_config(MainLoop *self)
 
   _init_reload_metrics(self);
 
+  self->reload_timings.started = g_get_monotonic_time();
   if (!cfg_read_config(self->current_configuration, resolved_configurable_paths.cfgfilename, options->preprocess_into))
     {
       return 1;
     }
+  self->reload_timings.parse = g_get_monotonic_time() - self->reload_timings.started;
 
   if (options->config_id)
     {
@@ -709,10 +751,14 @@ main_loop_read_and_init_config(MainLoop *self)
     }
 
   app_config_stopped();
+
+  gint64 init_start = g_get_monotonic_time();
   if (!main_loop_initialize_state(self->current_configuration, resolved_configurable_paths.persist_file))
     {
       return 2;
     }
+  self->reload_timings.init = g_get_monotonic_time() - init_start;
+  self->reload_timings.total = g_get_monotonic_time() - self->reload_timings.started;
 
   self->control_server = control_init(resolved_configurable_paths.ctlfilename);
 
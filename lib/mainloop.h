@@ -66,6 +66,7 @@ gboolean main_loop_reload_config_prepare(MainLoop *self, GError **error);
 void main_loop_reload_config_commence(MainLoop *self);
 void main_loop_reload_config(MainLoop *self);
 void main_loop_verify_config(GString *result, MainLoop *self);
+void main_loop_format_reload_timings(MainLoop *self, GString *result);
 gboolean main_loop_is_terminating(MainLoop *self);
 void main_loop_exit(MainLoop *self);
 
@@ -67,7 +67,7 @@ static void
 msg_format_preprocess_message(MsgFormatOptions *options, LogMessage *msg,
                               const guchar *data, gsize length)
 {
-  if (options->flags & LP_STORE_RAW_MESSAGE)
+  if ((options->flags & LP_STORE_RAW_MESSAGE) && !(options->flags & LP_RAW_RELAY))
     {
       log_msg_set_value(msg, LM_V_RAWMSG,
                         (gchar *) data, _rstripped_message_length(data, length));
@@ -104,11 +104,32 @@ msg_format_postprocess_message(MsgFormatOptions *options, LogMessage *msg,
     msg->flags |= LF_UTF8;
 }
 
+/* the bytes are stored only once, $RAWMSG refers to $MSG */
+static void
+msg_format_process_raw_relay(MsgFormatOptions *options, LogMessage *msg, const guchar *data, gsize length)
+{
+  gsize raw_length = _rstripped_message_length(data, length);
+
+  msg->pri = options->default_pri;
+  log_msg_set_value(msg, LM_V_MESSAGE, (gchar *) data, raw_length);
+
+  if (raw_length <= G_MAXUINT16)
+    log_msg_set_value_indirect(msg, LM_V_RAWMSG, LM_V_MESSAGE, 0, raw_length);
+  else
+    log_msg_set_value(msg, LM_V_RAWMSG, (gchar *) data, raw_length);
+}
+
 static gboolean
 msg_format_process_message(MsgFormatOptions *options, LogMessage *msg,
                            const guchar *data, gsize length,
                            gsize *problem_position)
 {
+  if (options->flags & LP_RAW_RELAY)
+    {
+      msg_format_process_raw_relay(options, msg, data, length);
+      return TRUE;
+    }
+
   if ((options->flags & LP_NOPARSE) == 0)
     {
       return options->format_handler->parse(options, msg, data, length, problem_position);
@@ -228,7 +249,7 @@ msg_format_options_defaults(MsgFormatOptions *options)
   options->recv_time_zone_info = NULL;
   options->bad_hostname = NULL;
   options->default_pri = 0xFFFF;
-  options->sdata_param_value_max = 65535;
+  options->sdata_param_value_max = MSG_FORMAT_SDATA_PARAM_VALUE_MAX_DEFAULT;
   options->sdata_prefix = NULL;
   options->sdata_prefix_len = 0;
 }
@@ -259,6 +280,16 @@ msg_format_options_init(MsgFormatOptions *options, GlobalConfig *cfg)
   if (!options->sdata_prefix)
     options->sdata_prefix = g_strdup(logmsg_sd_prefix);
   options->sdata_prefix_len = strlen(options->sdata_prefix);
+
+  /* lazy SDATA is decoded independently of the source, using the defaults */
+  if ((options->flags & LP_LAZY_SDATA) &&
+      (strcmp(options->sdata_prefix, logmsg_sd_prefix) != 0 ||
+       options->sdata_param_value_max != MSG_FORMAT_SDATA_PARAM_VALUE_MAX_DEFAULT))
+    {
+      msg_warning("WARNING: flags(lazy-sdata) is ignored when sdata-prefix() is set, SDATA is parsed eagerly instead",
+                  evt_tag_str("sdata_prefix", options->sdata_prefix));
+      options->flags &= ~LP_LAZY_SDATA;
+    }
   options->initialized = TRUE;
 }
 
@@ -314,6 +345,8 @@ CfgFlagHandler msg_format_flag_handlers[] =
   { "guess-timezone",             CFH_SET, offsetof(MsgFormatOptions, flags), LP_GUESS_TIMEZONE },
   { "no-header",                  CFH_SET, offsetof(MsgFormatOptions, flags), LP_NO_HEADER },
   { "no-rfc3164-fallback",        CFH_SET, offsetof(MsgFormatOptions, flags), LP_NO_RFC3164_FALLBACK },
+  { "raw-relay",                  CFH_SET, offsetof(MsgFormatOptions, flags), LP_RAW_RELAY },
+  { "lazy-sdata",                 CFH_SET, offsetof(MsgFormatOptions, flags), LP_LAZY_SDATA },
   { NULL },
 };
 
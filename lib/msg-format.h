@@ -59,8 +59,14 @@ enum
   LP_GUESS_TIMEZONE = 0x1000,
   LP_NO_HEADER = 0x2000,
   LP_NO_RFC3164_FALLBACK = 0x4000,
+  /* don't parse the message, keep it as $RAWMSG (aliased as $MSG) for flags(raw-relay) destinations */
+  LP_RAW_RELAY = 0x8000,
+  /* validate SDATA while parsing, but only decode it when first accessed */
+  LP_LAZY_SDATA = 0x10000,
 };
 
+#define MSG_FORMAT_SDATA_PARAM_VALUE_MAX_DEFAULT 65535
+
 typedef struct _MsgFormatHandler MsgFormatHandler;
 
 typedef struct _MsgFormatOptions
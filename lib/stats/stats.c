@@ -261,6 +261,7 @@ stats_options_defaults(StatsOptions *options)
   options->lifetime = 600;
   options->max_dynamic = -1;
   options->syslog_stats = CYNA_AUTO;
+  options->pipe_latency_sampling = 0;
 }
 
 gboolean
@@ -36,6 +36,7 @@ typedef struct _StatsOptions
   gint lifetime;
   gint max_dynamic;
   CfgYesNoAuto syslog_stats;
+  gint pipe_latency_sampling;
 } StatsOptions;
 
 enum
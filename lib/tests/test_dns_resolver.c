@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+
+#include <criterion/criterion.h>
+
+#include "dns-resolver.h"
+#include "apphook.h"
+
+#include <string.h>
+
+static GMutex stub_lock;
+static GCond stub_cond;
+static gboolean stub_released;
+static gint stub_calls;
+
+/* local stub resolver: 10.0.0.x resolves to host-x, everything else fails */
+static const gchar *
+_stub_resolve(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+  gchar address[64];
+
+  g_mutex_lock(&stub_lock);
+  stub_calls++;
+  while (!stub_released)
+    g_cond_wait(&stub_cond, &stub_lock);
+  g_mutex_unlock(&stub_lock);
+
+  g_sockaddr_format(saddr, address, sizeof(address), GSA_ADDRESS_ONLY);
+  if (!g_str_has_prefix(address, "10.0.0."))
+    return NULL;
+
+  g_snprintf(buf, buf_len, "host-%s", address + strlen("10.0.0."));
+  return buf;
+}
+
+static void
+_release_stub_resolver(void)
+{
+  g_mutex_lock(&stub_lock);
+  stub_released = TRUE;
+  g_cond_broadcast(&stub_cond);
+  g_mutex_unlock(&stub_lock);
+}
+
+static gint
+_get_stub_calls(void)
+{
+  g_mutex_lock(&stub_lock);
+  gint calls = stub_calls;
+  g_mutex_unlock(&stub_lock);
+
+  return calls;
+}
+
+static void
+_configure_resolver_with_cache_size(gint threads, gint wait_msec, gint cache_size)
+{
+  DNSCacheOptions options;
+
+  dns_cache_options_defaults(&options);
+  options.resolver_threads = threads;
+  options.resolver_wait = wait_msec;
+  if (cache_size > 0)
+    options.cache_size = cache_size;
+  dns_resolver_update_options(&options);
+  dns_cache_options_destroy(&options);
+}
+
+static void
+_configure_resolver(gint threads, gint wait_msec)
+{
+  _configure_resolver_with_cache_size(threads, wait_msec, 0);
+}
+
+static DNSResolverResult
+_lookup(const gchar *ip, gchar *hostname, gsize hostname_len, gboolean *positive)
+{
+  GSockAddr *saddr = g_sockaddr_inet_new(ip, 0);
+  DNSResolverResult result = dns_resolver_lookup(saddr, hostname, hostname_len, positive);
+  g_sockaddr_unref(saddr);
+  return result;
+}
+
+static void
+_assert_resolved_eventually(const gchar *ip, const gchar *expected, gboolean expected_positive)
+{
+  gchar hostname[256];
+  gboolean positive = !expected_positive;
+
+  for (gint i = 0; i < 1000; i++)
+    {
+      if (_lookup(ip, hostname, sizeof(hostname), &positive) == DNS_RESOLVER_RESOLVED)
+        {
+          cr_assert_str_eq(hostname, expected);
+          cr_assert_eq(positive, expected_positive);
+          return;
+        }
+      g_usleep(1000);
+    }
+  cr_assert_fail("lookup was not resolved in time, ip=%s", ip);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  g_mutex_init(&stub_lock);
+  g_cond_init(&stub_cond);
+  stub_released = FALSE;
+  stub_calls = 0;
+  dns_resolver_set_resolve_func(_stub_resolve);
+}
+
+static void
+teardown(void)
+{
+  _release_stub_resolver();
+  dns_resolver_set_resolve_func(NULL);
+  app_shutdown();
+  g_cond_clear(&stub_cond);
+  g_mutex_clear(&stub_lock);
+}
+
+TestSuite(dns_resolver, .init = setup, .fini = teardown, .timeout = 10);
+
+Test(dns_resolver, disabled_by_default)
+{
+  cr_assert_not(dns_resolver_is_enabled());
+}
+
+Test(dns_resolver, lookup_does_not_block_and_is_filled_later)
+{
+  gchar hostname[256];
+  gboolean positive;
+
+  _configure_resolver(2, 0);
+  cr_assert(dns_resolver_is_enabled());
+
+  cr_assert_eq(_lookup("10.0.0.1", hostname, sizeof(hostname), &positive), DNS_RESOLVER_PENDING);
+  cr_assert_eq(_lookup("10.0.0.1", hostname, sizeof(hostname), &positive), DNS_RESOLVER_PENDING);
+
+  _release_stub_resolver();
+  _assert_resolved_eventually("10.0.0.1", "host-1", TRUE);
+
+  /* the pending lookup was shared, the name server was asked only once */
+  cr_assert_eq(_get_stub_calls(), 1);
+}
+
+Test(dns_resolver, failed_lookups_are_cached_negatively)
+{
+  _configure_resolver(1, 0);
+  _release_stub_resolver();
+
+  _assert_resolved_eventually("192.168.1.1", "192.168.1.1", FALSE);
+  _assert_resolved_eventually("192.168.1.1", "192.168.1.1", FALSE);
+  cr_assert_eq(_get_stub_calls(), 1);
+}
+
+Test(dns_resolver, lookup_waits_for_the_result_when_configured)
+{
+  gchar hostname[256];
+  gboolean positive = FALSE;
+
+  _configure_resolver(1, 5000);
+  _release_stub_resolver();
+
+  cr_assert_eq(_lookup("10.0.0.2", hostname, sizeof(hostname), &positive), DNS_RESOLVER_RESOLVED);
+  cr_assert_str_eq(hostname, "host-2");
+  cr_assert(positive);
+}
+
+Test(dns_resolver, wait_is_bounded)
+{
+  gchar hostname[256];
+  gboolean positive;
+
+  _configure_resolver(1, 10);
+
+  cr_assert_eq(_lookup("10.0.0.3", hostname, sizeof(hostname), &positive), DNS_RESOLVER_PENDING);
+}
+
+static gpointer
+_waiting_lookup_thread(gpointer user_data)
+{
+  gchar hostname[256];
+  gboolean positive;
+
+  DNSResolverResult result = _lookup((const gchar *) user_data, hostname, sizeof(hostname), &positive);
+  if (result == DNS_RESOLVER_RESOLVED && (!positive || strcmp(hostname, "host-1") != 0))
+    return GINT_TO_POINTER(FALSE);
+  return GINT_TO_POINTER(TRUE);
+}
+
+Test(dns_resolver, waiting_lookup_survives_eviction_of_its_entry)
+{
+  gchar hostname[256];
+  gboolean positive;
+
+  /* a single entry fits in the cache, so any new lookup evicts the
+   * resolved entry the waiter is sleeping on */
+  _configure_resolver_with_cache_size(2, 5000, 1);
+
+  GThread *waiter = g_thread_new("dns-waiter", _waiting_lookup_thread, "10.0.0.1");
+  while (_get_stub_calls() < 1)
+    g_usleep(100);
+
+  _release_stub_resolver();
+  for (gint i = 2; i < 50; i++)
+    {
+      gchar ip[32];
+
+      g_snprintf(ip, sizeof(ip), "10.0.0.%d", i);
+      _lookup(ip, hostname, sizeof(hostname), &positive);
+    }
+
+  cr_assert(GPOINTER_TO_INT(g_thread_join(waiter)), "waiter returned a wrong result");
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+
+#include <criterion/criterion.h>
+
+#include "logpipe-latency.h"
+#include "cfg-tree.h"
+#include "apphook.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+
+#define SLOW_PIPE_NSEC 200000
+
+static void
+_busy_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  gint64 start = g_get_monotonic_time();
+
+  while (g_get_monotonic_time() - start < SLOW_PIPE_NSEC / 1000)
+    ;
+  log_pipe_forward_msg(s, msg, path_options);
+}
+
+static LogPipe *
+_create_pipe(const gchar *name)
+{
+  LogPipe *pipe = log_pipe_new(NULL);
+  LogExprNode *node = log_expr_node_new(ENL_SINGLE, ENC_PIPE, name, NULL, 0, NULL);
+
+  log_pipe_attach_expr_node(pipe, node);
+  log_expr_node_unref(node);
+  cr_assert(log_pipe_init(pipe));
+  return pipe;
+}
+
+static void
+_destroy_pipe(LogPipe *pipe)
+{
+  log_pipe_deinit(pipe);
+  log_pipe_latency_unregister(pipe);
+  log_pipe_detach_expr_node(pipe);
+  log_pipe_unref(pipe);
+}
+
+static gsize
+_get_counter(const gchar *metric, const gchar *id, const gchar *le)
+{
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("id", id),
+    stats_cluster_label("location", "#unknown"),
+    stats_cluster_label("plugin", ""),
+    stats_cluster_label("le", le),
+  };
+  StatsClusterKey sc_key;
+
+  stats_cluster_single_key_set(&sc_key, metric, labels, le ? G_N_ELEMENTS(labels) : G_N_ELEMENTS(labels) - 1);
+
+  stats_lock();
+  StatsCounterItem *counter = stats_get_counter(&sc_key, SC_TYPE_SINGLE_VALUE);
+  stats_unlock();
+
+  cr_assert(counter, "counter not registered: %s, id=%s, le=%s", metric, id, le);
+  return stats_counter_get(counter);
+}
+
+static void
+_send_messages(LogPipe *head, gint count)
+{
+  for (gint i = 0; i < count; i++)
+    {
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+      log_pipe_queue(head, log_msg_new_empty(), &path_options);
+    }
+}
+
+Test(logpipe_latency, bucket_index)
+{
+  cr_assert_eq(log_pipe_latency_bucket_index(0), 0);
+  cr_assert_eq(log_pipe_latency_bucket_index(1000), 0);
+  cr_assert_eq(log_pipe_latency_bucket_index(1001), 1);
+  cr_assert_eq(log_pipe_latency_bucket_index(2000), 1);
+  cr_assert_eq(log_pipe_latency_bucket_index(1024000), 10);
+  cr_assert_eq(log_pipe_latency_bucket_index(65536000), LOG_PIPE_LATENCY_BUCKETS - 2);
+  cr_assert_eq(log_pipe_latency_bucket_index(65536001), LOG_PIPE_LATENCY_BUCKETS - 1);
+  cr_assert_eq(log_pipe_latency_bucket_index(G_MAXUINT64), LOG_PIPE_LATENCY_BUCKETS - 1);
+}
+
+Test(logpipe_latency, downstream_time_is_not_accounted_to_upstream_pipes)
+{
+  LogPipe *fast = _create_pipe("fast");
+  LogPipe *slow = _create_pipe("slow");
+
+  slow->queue = _busy_queue;
+  log_pipe_append(fast, slow);
+
+  log_pipe_latency_register(fast);
+  log_pipe_latency_register(slow);
+  log_pipe_latency_set_sampling(1);
+
+  _send_messages(fast, 10);
+
+  log_pipe_latency_set_sampling(0);
+
+  cr_assert_eq(_get_counter("pipe_latency_seconds_count", "fast", NULL), 10);
+  cr_assert_eq(_get_counter("pipe_latency_seconds_count", "slow", NULL), 10);
+  cr_assert_geq(_get_counter("pipe_latency_seconds_sum", "slow", NULL), 10 * SLOW_PIPE_NSEC);
+  cr_assert_lt(_get_counter("pipe_latency_seconds_sum", "fast", NULL), 10 * SLOW_PIPE_NSEC);
+
+  /* buckets are cumulative, 200us is above the 128us bound */
+  cr_assert_eq(_get_counter("pipe_latency_seconds_bucket", "slow", "0.000128"), 0);
+  cr_assert_eq(_get_counter("pipe_latency_seconds_bucket", "slow", "+Inf"), 10);
+
+  _destroy_pipe(slow);
+  _destroy_pipe(fast);
+}
+
+Test(logpipe_latency, only_every_nth_message_is_sampled)
+{
+  LogPipe *pipe = _create_pipe("sampled");
+
+  log_pipe_latency_register(pipe);
+  log_pipe_latency_set_sampling(4);
+
+  _send_messages(pipe, 100);
+
+  log_pipe_latency_set_sampling(0);
+  _send_messages(pipe, 100);
+
+  cr_assert_eq(_get_counter("pipe_latency_seconds_count", "sampled", NULL), 25);
+
+  _destroy_pipe(pipe);
+}
+
+Test(logpipe_latency, sampling_switched_off_while_a_message_is_queued)
+{
+  LogPipe *pipe = _create_pipe("switched-off");
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  log_pipe_latency_register(pipe);
+
+  /* log_pipe_queue() saw a non-zero rate, then cfg_tree_stop() reset it */
+  log_pipe_latency_set_sampling(0);
+  log_pipe_queue_sampled(pipe, log_msg_new_empty(), &path_options, 1);
+
+  cr_assert_eq(_get_counter("pipe_latency_seconds_count", "switched-off", NULL), 1);
+
+  _destroy_pipe(pipe);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  app_shutdown();
+}
+
+TestSuite(logpipe_latency, .init = setup, .fini = teardown);
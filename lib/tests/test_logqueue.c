@@ -284,6 +284,46 @@ Test(logqueue, log_queue_fifo_rewind_all_and_memory_usage)
   log_queue_unref(q);
 }
 
+Test(logqueue, log_queue_introspection_counters_follow_the_backlog)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_fifo_new(OVERFLOW_SIZE, NULL, STATS_LEVEL0, driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  feed_some_messages(q, 10);
+  send_some_messages(q, 10, FALSE);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 10);
+
+  log_queue_ack_backlog(q, 3);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 7);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.acked), 3);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.ack_batches), 1);
+
+  log_queue_rewind_backlog(q, 2);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 5);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.rewound), 2);
+
+  log_queue_rewind_backlog_all(q);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.rewound), 7);
+
+  send_some_messages(q, 7, TRUE);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.acked), 10);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.ack_batches), 8);
+
+  /* the messages were created just now, all of them fall into the first
+   * bucket, the ones popped again after the rewinds are not counted twice */
+  cr_assert_eq(stats_counter_get(q->metrics.owned.message_age[0]), 10);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.message_age[LOG_QUEUE_MESSAGE_AGE_BUCKETS - 1]), 10);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.message_age_count), 10);
+  cr_assert_leq(stats_counter_get(q->metrics.owned.message_age_sum), 10);
+
+  log_queue_unref(q);
+}
+
 Test(logqueue, log_queue_fifo_should_drop_only_non_flow_controlled_messages,
      .description = "Flow-controlled messages should never be dropped")
 {
@@ -232,3 +232,52 @@ Test(logwriter, test_logwriter)
   iv_deinit();
   cfg_free(configuration);
 }
+
+Test(logwriter, test_raw_relay_sends_the_message_as_received)
+{
+  const gchar *raw = "<155>2006-02-11T10:34:56+01:00 bzorp syslog-ng[23323]: raw message";
+  LogWriterOptions opt = {0};
+  GString *result_msg = g_string_sized_new(128);
+  GError *error = NULL;
+
+  configuration = cfg_new_snippet();
+  app_startup();
+  cfg_load_module(configuration, "syslogformat");
+  msg_format_options_defaults(&parse_options);
+  msg_format_options_init(&parse_options, configuration);
+  parse_options.flags |= LP_RAW_RELAY;
+
+  LogMessage *msg = msg_format_parse(&parse_options, (const guchar *) raw, strlen(raw));
+  cr_assert_str_eq(log_msg_get_value(msg, LM_V_RAWMSG, NULL), raw);
+  cr_assert_str_eq(log_msg_get_value(msg, LM_V_MESSAGE, NULL), raw);
+
+  log_writer_options_defaults(&opt);
+  opt.template = log_template_new(configuration, "dummy");
+  cr_assert(log_template_compile(opt.template, "$PRI $MSG", &error));
+  log_writer_options_init(&opt, configuration, LWO_RAW_RELAY | LWO_NO_STATS);
+
+  LogQueue *queue = log_queue_fifo_new(1000, NULL, STATS_LEVEL0, NULL, NULL);
+  LogWriter *writer = log_writer_new(LW_FORMAT_PROTO, configuration);
+  log_writer_set_options(writer, NULL, &opt, NULL, NULL);
+  log_writer_set_queue(writer, queue);
+  cr_assert(log_pipe_init((LogPipe *)writer));
+
+  log_writer_format_log(writer, msg, result_msg);
+  cr_assert_str_eq(result_msg->str, "<155>2006-02-11T10:34:56+01:00 bzorp syslog-ng[23323]: raw message\n");
+
+  /* $RAWMSG survives a rewrite of $MSG */
+  log_msg_set_value(msg, LM_V_MESSAGE, "rewritten", -1);
+  log_writer_format_log(writer, msg, result_msg);
+  cr_assert_str_eq(result_msg->str, "<155>2006-02-11T10:34:56+01:00 bzorp syslog-ng[23323]: raw message\n");
+
+  /* without a raw message, the template is used */
+  log_msg_unset_value(msg, LM_V_RAWMSG);
+  log_writer_format_log(writer, msg, result_msg);
+  cr_assert_str_eq(result_msg->str, "13 rewritten");
+
+  _tear_down(writer, msg, queue, result_msg, &opt);
+  msg_format_options_destroy(&parse_options);
+  app_shutdown();
+  iv_deinit();
+  cfg_free(configuration);
+}
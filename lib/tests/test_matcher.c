@@ -193,6 +193,44 @@ Test(matcher, disable_jit)
                    "favíz", "favíztűrőtükörfúrógép", _construct_matcher(LMF_DISABLE_JIT, log_matcher_pcre_re_new));
 }
 
+Test(matcher, pcre_patterns_are_shared_between_matchers)
+{
+  LogMatcher *first = _construct_matcher(LMF_ICASE, log_matcher_pcre_re_new);
+  LogMatcher *second = _construct_matcher(LMF_ICASE, log_matcher_pcre_re_new);
+  LogMatcher *different_flags = _construct_matcher(0, log_matcher_pcre_re_new);
+
+  cr_assert(log_matcher_compile(first, "wiki", NULL));
+  cr_assert(log_matcher_compile(second, "wiki", NULL));
+  cr_assert(log_matcher_compile(different_flags, "wiki", NULL));
+
+  gconstpointer shared_pattern = log_matcher_pcre_get_compiled_pattern(first);
+  cr_assert_not_null(shared_pattern);
+  cr_assert_eq(log_matcher_pcre_get_compiled_pattern(second), shared_pattern,
+               "the same pattern with the same flags was compiled twice");
+  cr_assert_neq(log_matcher_pcre_get_compiled_pattern(different_flags), shared_pattern,
+                "patterns compiled with different flags must not be shared");
+
+  /* the shared pattern must survive its first user */
+  log_matcher_unref(first);
+  cr_assert_eq(log_matcher_pcre_get_compiled_pattern(second), shared_pattern);
+
+  LogMessage *msg = _create_log_message("WIKIwiki");
+  gssize msglen;
+  const gchar *value = log_msg_get_value(msg, LM_V_MESSAGE, &msglen);
+
+  cr_assert(log_matcher_match(second, msg, LM_V_MESSAGE, value, msglen));
+  log_msg_unref(msg);
+
+  msg = _create_log_message("WIKI");
+  value = log_msg_get_value(msg, LM_V_MESSAGE, &msglen);
+  cr_assert(log_matcher_match(second, msg, LM_V_MESSAGE, value, msglen));
+  cr_assert_not(log_matcher_match(different_flags, msg, LM_V_MESSAGE, value, msglen));
+  log_msg_unref(msg);
+
+  log_matcher_unref(second);
+  log_matcher_unref(different_flags);
+}
+
 Test(matcher, string_match)
 {
   testcase_replace("árvíztűrőtükörfúrógép", "árvíz",
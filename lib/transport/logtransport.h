@@ -38,6 +38,9 @@ struct _LogTransport
   gssize (*read)(LogTransport *self, gpointer buf, gsize count, LogTransportAuxData *aux);
   gssize (*write)(LogTransport *self, const gpointer buf, gsize count);
   gssize (*writev)(LogTransport *self, struct iovec *iov, gint iov_count);
+  /* transports that buffer data in write() push it out here, returns 0 if
+   * everything has been written, -1 with errno set otherwise */
+  gssize (*flush)(LogTransport *self);
   void (*free_fn)(LogTransport *self);
 };
 
@@ -53,6 +56,14 @@ log_transport_writev(LogTransport *self, struct iovec *iov, gint iov_count)
   return self->writev(self, iov, iov_count);
 }
 
+static inline gssize
+log_transport_flush(LogTransport *self)
+{
+  if (self->flush)
+    return self->flush(self);
+  return 0;
+}
+
 static inline gssize
 log_transport_read(LogTransport *self, gpointer buf, gsize count, LogTransportAuxData *aux)
 {
@@ -31,6 +31,16 @@ void multitransport_add_factory(MultiTransport *self, TransportFactory *transpor
   transport_factory_registry_add(self->registry, transport_factory);
 }
 
+static gssize _multitransport_flush(LogTransport *s);
+
+/* only expose flush() if the active transport buffers data, as
+ * LogProtoTextClient defers acks for transports that do */
+static void
+_update_flush_method(MultiTransport *self)
+{
+  self->super.flush = self->active_transport->flush ? _multitransport_flush : NULL;
+}
+
 static void
 _do_transport_switch(MultiTransport *self, LogTransport *new_transport, const TransportFactory *new_transport_factory)
 {
@@ -39,6 +49,7 @@ _do_transport_switch(MultiTransport *self, LogTransport *new_transport, const Tr
   log_transport_free(self->active_transport);
   self->active_transport = new_transport;
   self->active_transport_factory = new_transport_factory;
+  _update_flush_method(self);
 }
 
 static const TransportFactory *
@@ -112,6 +123,16 @@ _multitransport_write(LogTransport *s, gpointer buf, gsize count)
   return r;
 }
 
+static gssize
+_multitransport_flush(LogTransport *s)
+{
+  MultiTransport *self = (MultiTransport *)s;
+  gssize r = log_transport_flush(self->active_transport);
+  self->super.cond = self->active_transport->cond;
+
+  return r;
+}
+
 static gssize
 _multitransport_read(LogTransport *s, gpointer buf, gsize count, LogTransportAuxData *aux)
 {
@@ -145,6 +166,7 @@ multitransport_new(TransportFactory *default_transport_factory, gint fd)
   self->super.free_fn = _multitransport_free;
   self->active_transport = transport_factory_construct_transport(default_transport_factory, fd);
   self->active_transport_factory = default_transport_factory;
+  _update_flush_method(self);
 
   return &self->super;
 }
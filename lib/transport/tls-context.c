@@ -249,6 +249,25 @@ tls_context_setup_ssl_options(TLSContext *self)
     }
 }
 
+/* kernel TLS: once the handshake is done, OpenSSL hands the session keys
+ * over to the kernel and SSL_read()/SSL_write() become plain socket I/O on
+ * a kTLS socket.  OpenSSL silently stays in userspace if either the kernel
+ * or the negotiated cipher does not support it. */
+static void
+tls_context_setup_ktls(TLSContext *self)
+{
+  if (!self->ktls)
+    return;
+
+#ifdef SSL_OP_ENABLE_KTLS
+  SSL_CTX_set_options(self->ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+  msg_warning("WARNING: ktls() is not supported by the OpenSSL library syslog-ng was compiled with, "
+              "falling back to userspace TLS",
+              tls_context_format_location_tag(self));
+#endif
+}
+
 static gboolean
 _set_optional_ecdh_curve_list(SSL_CTX *ctx, const gchar *ecdh_curve_list)
 {
@@ -599,6 +618,7 @@ tls_context_setup_context(TLSContext *self)
 
   tls_context_setup_ssl_version(self);
   tls_context_setup_ssl_options(self);
+  tls_context_setup_ktls(self);
   if (!tls_context_setup_ecdh(self))
     goto error_no_print;
 
@@ -938,6 +958,18 @@ tls_context_set_ocsp_stapling_verify(TLSContext *self, gboolean ocsp_stapling_ve
   self->ocsp_stapling_verify = ocsp_stapling_verify;
 }
 
+void
+tls_context_set_ktls(TLSContext *self, gboolean ktls)
+{
+  self->ktls = ktls;
+}
+
+void
+tls_context_set_record_coalescing(TLSContext *self, gboolean record_coalescing)
+{
+  self->record_coalescing = record_coalescing;
+}
+
 /* NOTE: location is a string description where this tls context was defined, e.g. the location in the config */
 TLSContext *
 tls_context_new(TLSMode mode, const gchar *location)
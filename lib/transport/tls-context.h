@@ -90,6 +90,8 @@ struct _TLSContext
   gchar *ecdh_curve_list;
   gchar *sni;
   gboolean ocsp_stapling_verify;
+  gboolean ktls;
+  gboolean record_coalescing;
 
   SSL_CTX *ssl_ctx;
   GList *conf_cmds_list;
@@ -138,6 +140,8 @@ void tls_context_set_ecdh_curve_list(TLSContext *self, const gchar *ecdh_curve_l
 void tls_context_set_dhparam_file(TLSContext *self, const gchar *dhparam_file);
 void tls_context_set_sni(TLSContext *self, const gchar *sni);
 void tls_context_set_ocsp_stapling_verify(TLSContext *self, gboolean ocsp_stapling_verify);
+void tls_context_set_ktls(TLSContext *self, gboolean ktls);
+void tls_context_set_record_coalescing(TLSContext *self, gboolean record_coalescing);
 const gchar *tls_context_get_key_file(TLSContext *self);
 EVTTAG *tls_context_format_tls_error_tag(TLSContext *self);
 EVTTAG *tls_context_format_location_tag(TLSContext *self);
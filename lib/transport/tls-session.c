@@ -519,6 +519,17 @@ tls_session_set_verifier(TLSSession *self, TLSVerifier *verifier)
   self->verifier = verifier ? tls_verifier_ref(verifier) : NULL;
 }
 
+static void
+_log_ktls_status(TLSSession *self)
+{
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  msg_debug("TLS handshake finished, kernel TLS offload status",
+            evt_tag_int("ktls_send", BIO_get_ktls_send(SSL_get_wbio(self->ssl))),
+            evt_tag_int("ktls_recv", BIO_get_ktls_recv(SSL_get_rbio(self->ssl))),
+            tls_context_format_location_tag(self->ctx));
+#endif
+}
+
 void
 tls_session_info_callback(const SSL *ssl, int where, int ret)
 {
@@ -539,6 +550,9 @@ tls_session_info_callback(const SSL *ssl, int where, int ret)
           X509_free(cert);
         }
     }
+
+  if ((where & SSL_CB_HANDSHAKE_DONE) && self->ctx->ktls)
+    _log_ktls_status(self);
 }
 
 static gboolean
@@ -29,12 +29,26 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <errno.h>
+#include <string.h>
+
+/* maximum plaintext size of a single TLS record */
+#define TLS_RECORD_SIZE 16384
 
 typedef struct _LogTransportTLS
 {
   LogTransportSocket super;
   TLSSession *tls_session;
   gboolean sending_shutdown;
+
+  /* with record-coalescing(yes), small writes are collected here and sent
+   * as a full sized record when the buffer fills up or on flush() */
+  struct
+  {
+    guchar *buffer;
+    gsize len;
+    /* SSL_write() has to be retried with the same arguments */
+    gboolean retry;
+  } record;
 } LogTransportTLS;
 
 static inline gboolean
@@ -173,9 +187,8 @@ tls_error:
 }
 
 static gssize
-log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen)
+_ssl_write(LogTransportTLS *self, const gpointer buf, gsize buflen)
 {
-  LogTransportTLS *self = (LogTransportTLS *) s;
   gint ssl_error;
   gint rc;
 
@@ -235,6 +248,59 @@ tls_error:
   return -1;
 }
 
+static gssize
+_flush_record(LogTransportTLS *self)
+{
+  while (self->record.len > 0)
+    {
+      gssize rc = _ssl_write(self, self->record.buffer, self->record.len);
+
+      if (rc <= 0)
+        {
+          if (rc == 0)
+            errno = EAGAIN;
+          self->record.retry = (errno == EAGAIN);
+          return -1;
+        }
+
+      self->record.retry = FALSE;
+      self->record.len -= rc;
+      memmove(self->record.buffer, self->record.buffer + rc, self->record.len);
+    }
+  return 0;
+}
+
+static gssize
+log_transport_tls_write_method(LogTransport *s, const gpointer buf, gsize buflen)
+{
+  LogTransportTLS *self = (LogTransportTLS *) s;
+
+  if (!self->record.buffer)
+    return _ssl_write(self, buf, buflen);
+
+  if (self->record.retry || self->record.len + buflen > TLS_RECORD_SIZE)
+    {
+      if (_flush_record(self) < 0)
+        return -1;
+    }
+
+  if (buflen >= TLS_RECORD_SIZE)
+    return _ssl_write(self, buf, buflen);
+
+  memcpy(self->record.buffer + self->record.len, buf, buflen);
+  self->record.len += buflen;
+  self->super.super.cond = 0;
+  return buflen;
+}
+
+static gssize
+log_transport_tls_flush_method(LogTransport *s)
+{
+  LogTransportTLS *self = (LogTransportTLS *) s;
+
+  return _flush_record(self);
+}
+
 
 static void log_transport_tls_free_method(LogTransport *s);
 
@@ -250,6 +316,12 @@ log_transport_tls_new(TLSSession *tls_session, gint fd)
   self->super.super.free_fn = log_transport_tls_free_method;
   self->tls_session = tls_session;
 
+  if (tls_session->ctx->record_coalescing)
+    {
+      self->record.buffer = g_malloc(TLS_RECORD_SIZE);
+      self->super.super.flush = log_transport_tls_flush_method;
+    }
+
   SSL_set_fd(self->tls_session->ssl, fd);
   return &self->super.super;
 }
@@ -259,6 +331,7 @@ log_transport_tls_free_method(LogTransport *s)
 {
   LogTransportTLS *self = (LogTransportTLS *) s;
 
+  g_free(self->record.buffer);
   tls_session_free(self->tls_session);
   log_transport_stream_socket_free_method(s);
 }
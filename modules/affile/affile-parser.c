@@ -51,6 +51,8 @@ static CfgLexerKeyword affile_keywords[] =
   { "symlink_as",         KW_SYMLINK_AS },
   { "follow_freq",        KW_FOLLOW_FREQ },
   { "multi_line_timeout", KW_MULTI_LINE_TIMEOUT },
+  { "bookmark_save_batch_size", KW_BOOKMARK_SAVE_BATCH_SIZE },
+  { "bookmark_save_interval", KW_BOOKMARK_SAVE_INTERVAL },
   { "time_reap",          KW_TIME_REAP },
   { NULL }
 };
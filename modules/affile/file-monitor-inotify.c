@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include "file-monitor-inotify.h"
+#include "messages.h"
+
+struct _FileMonitorInotify
+{
+  struct iv_inotify inotify;
+};
+
+static void
+_handle_event(gpointer s, struct inotify_event *event)
+{
+  FileMonitorInotifyWatch *self = (FileMonitorInotifyWatch *) s;
+
+  /* ivykis drops the watch on its own once the kernel removed it */
+  if (event->mask & IN_IGNORED)
+    self->registered = FALSE;
+
+  self->callback(self->cookie, event->mask);
+}
+
+void
+file_monitor_inotify_watch_init(FileMonitorInotifyWatch *self, FileMonitorInotify *monitor,
+                                FileMonitorInotifyCallback callback, gpointer cookie)
+{
+  IV_INOTIFY_WATCH_INIT(&self->watch);
+  self->watch.inotify = &monitor->inotify;
+  self->watch.pathname = self->pathname;
+  self->watch.mask = IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF;
+  self->watch.cookie = self;
+  self->watch.handler = _handle_event;
+  self->registered = FALSE;
+
+  self->callback = callback;
+  self->cookie = cookie;
+}
+
+gboolean
+file_monitor_inotify_watch_start(FileMonitorInotifyWatch *self, gint fd)
+{
+  if (self->registered)
+    return TRUE;
+
+  /* inotify follows the magic symlink, so we watch the inode we have open,
+   * not the one currently having the followed name */
+  g_snprintf(self->pathname, sizeof(self->pathname), "/proc/self/fd/%d", fd);
+  if (iv_inotify_watch_register(&self->watch) < 0)
+    {
+      msg_debug("file-monitor-inotify: unable to watch followed file, falling back to polling",
+                evt_tag_int("fd", fd),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  self->registered = TRUE;
+  return TRUE;
+}
+
+void
+file_monitor_inotify_watch_stop(FileMonitorInotifyWatch *self)
+{
+  if (!self->registered)
+    return;
+
+  iv_inotify_watch_unregister(&self->watch);
+  self->registered = FALSE;
+}
+
+FileMonitorInotify *
+file_monitor_inotify_new(void)
+{
+  FileMonitorInotify *self = g_new0(FileMonitorInotify, 1);
+
+  IV_INOTIFY_INIT(&self->inotify);
+  if (iv_inotify_register(&self->inotify))
+    {
+      msg_warning("file-monitor-inotify: could not create inotify object, following files by polling",
+                  evt_tag_error("errno"));
+      g_free(self);
+      return NULL;
+    }
+
+  return self;
+}
+
+void
+file_monitor_inotify_free(FileMonitorInotify *self)
+{
+  iv_inotify_unregister(&self->inotify);
+  g_free(self);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#ifndef MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_
+#define MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_
+
+#include "syslog-ng.h"
+#include <iv_inotify.h>
+
+/*
+ * A single inotify instance, shared by all the files followed by a source
+ * driver, so that following a large number of files only costs a single
+ * fd and no timers.  Files are watched through their open fd, so the watch
+ * stays with the file we are reading even if it gets renamed.
+ */
+typedef struct _FileMonitorInotify FileMonitorInotify;
+
+typedef void (*FileMonitorInotifyCallback)(gpointer cookie, guint32 event_mask);
+
+typedef struct _FileMonitorInotifyWatch
+{
+  struct iv_inotify_watch watch;
+  gchar pathname[32];
+  gboolean registered;
+
+  FileMonitorInotifyCallback callback;
+  gpointer cookie;
+} FileMonitorInotifyWatch;
+
+FileMonitorInotify *file_monitor_inotify_new(void);
+void file_monitor_inotify_free(FileMonitorInotify *self);
+
+void file_monitor_inotify_watch_init(FileMonitorInotifyWatch *self, FileMonitorInotify *monitor,
+                                     FileMonitorInotifyCallback callback, gpointer cookie);
+gboolean file_monitor_inotify_watch_start(FileMonitorInotifyWatch *self, gint fd);
+void file_monitor_inotify_watch_stop(FileMonitorInotifyWatch *self);
+
+static inline gboolean
+file_monitor_inotify_watch_is_registered(FileMonitorInotifyWatch *self)
+{
+  return self->registered;
+}
+
+#endif /* MODULES_AFFILE_FILE_MONITOR_INOTIFY_H_ */
@@ -100,11 +100,20 @@ _construct_poll_events(FileReader *self, gint fd)
     {
       LogProtoFileReaderOptions *proto_opts = file_reader_options_get_log_proto_options(self->options);
 
+      PollEvents *poll_events;
+
       if (proto_opts->multi_line_options.mode == MLM_NONE)
-        return poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
+        poll_events = poll_file_changes_new(fd, self->filename->str, self->options->follow_freq, &self->super);
       else
-        return poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
-                                               self->options->multi_line_timeout, self);
+        poll_events = poll_multiline_file_changes_new(fd, self->filename->str, self->options->follow_freq,
+                                                      self->options->multi_line_timeout, self);
+
+#if SYSLOG_NG_HAVE_INOTIFY
+      /* the multi-line timeout is evaluated on each poll, so it needs polling */
+      if (self->options->file_monitor && !self->options->multi_line_timeout)
+        poll_file_changes_follow_with_inotify((PollFileChanges *) poll_events, self->options->file_monitor);
+#endif
+      return poll_events;
     }
   else if (fd >= 0 && _is_fd_pollable(fd))
     return poll_fd_events_new(fd);
@@ -139,7 +148,7 @@ _construct_proto(FileReader *self, gint fd)
   if ((format_handler && format_handler->construct_proto))
     {
       log_proto_server_options_set_ack_tracker_factory(&proto_options->super,
-                                                       consecutive_ack_tracker_factory_new());
+                                                       log_proto_file_reader_options_new_ack_tracker_factory(proto_options));
       return format_handler->construct_proto(&reader_options->parse_options, transport, &proto_options->super);
     }
 
@@ -33,6 +33,8 @@ typedef struct _FileReaderOptions
   gboolean restore_state;
   LogReaderOptions reader_options;
   gboolean exit_on_eof;
+  /* shared by the readers of a driver to follow files via inotify, NULL to poll them */
+  struct _FileMonitorInotify *file_monitor;
 } FileReaderOptions;
 
 typedef struct _FileReader
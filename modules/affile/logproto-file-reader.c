@@ -24,6 +24,7 @@
 #include "logproto-file-reader.h"
 #include "logproto/logproto-record-server.h"
 #include "logproto/logproto-multiline-server.h"
+#include "ack-tracker/ack_tracker_factory.h"
 #include "messages.h"
 
 LogProtoServer *
@@ -36,6 +37,16 @@ log_proto_file_reader_new(LogTransport *transport, const LogProtoFileReaderOptio
                                           multi_line_factory_construct(&options->multi_line_options));
 }
 
+AckTrackerFactory *
+log_proto_file_reader_options_new_ack_tracker_factory(const LogProtoFileReaderOptions *options)
+{
+  AckTrackerFactory *factory = consecutive_ack_tracker_factory_new();
+
+  consecutive_ack_tracker_factory_set_bookmark_save_limits(factory, options->bookmark_save_batch_size,
+                                                           options->bookmark_save_interval);
+  return factory;
+}
+
 /* these functions only initialize the fields added on top of
  * LogProtoServerOptions, the rest is the responsibility of the LogReader.
  * This whole Options structure has become very messy. There are a lot of them.
@@ -74,6 +85,8 @@ log_proto_file_reader_options_defaults(LogProtoFileReaderOptions *options)
   options->super.destroy = _destroy_callback;
   multi_line_options_defaults(&options->multi_line_options);
   options->pad_size = 0;
+  options->bookmark_save_batch_size = 1;
+  options->bookmark_save_interval = 0;
 }
 
 static gboolean
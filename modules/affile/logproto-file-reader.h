@@ -32,10 +32,14 @@ typedef struct _LogProtoFileReaderOptions
   LogProtoServerOptions super;
   MultiLineOptions multi_line_options;
   gint pad_size;
+  gint bookmark_save_batch_size;
+  gint bookmark_save_interval;
 } LogProtoFileReaderOptions;
 
 LogProtoServer *log_proto_file_reader_new(LogTransport *transport, const LogProtoFileReaderOptions *options);
 
+AckTrackerFactory *log_proto_file_reader_options_new_ack_tracker_factory(const LogProtoFileReaderOptions *options);
+
 void log_proto_file_reader_options_defaults(LogProtoFileReaderOptions *options);
 gboolean log_proto_file_reader_options_init(LogProtoFileReaderOptions *options, GlobalConfig *cfg);
 void log_proto_file_reader_options_destroy(LogProtoFileReaderOptions *options);
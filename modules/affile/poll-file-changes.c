@@ -153,24 +153,92 @@ reschedule:
   poll_events_update_watches(s, G_IO_IN);
 }
 
+/* keeps the inotify watch registered, but events are ignored until the
+ * next update_watches() */
 void
-poll_file_changes_stop_watches(PollEvents *s)
+poll_file_changes_suspend_watches(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
   if (iv_timer_registered(&self->follow_timer))
     iv_timer_unregister(&self->follow_timer);
+#if SYSLOG_NG_HAVE_INOTIFY
+  self->file_watch_active = FALSE;
+#endif
+}
+
+void
+poll_file_changes_stop_watches(PollEvents *s)
+{
+  poll_file_changes_suspend_watches(s);
+#if SYSLOG_NG_HAVE_INOTIFY
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  if (self->file_watch_enabled)
+    file_monitor_inotify_watch_stop(&self->file_watch);
+#endif
 }
 
 static void
-poll_file_changes_rearm_timer(PollFileChanges *self)
+poll_file_changes_rearm_timer(PollFileChanges *self, gint timeout_msec)
 {
   iv_validate_now();
   self->follow_timer.expires = iv_now;
-  timespec_add_msec(&self->follow_timer.expires, self->follow_freq);
+  timespec_add_msec(&self->follow_timer.expires, timeout_msec);
   iv_timer_register(&self->follow_timer);
 }
 
+#if SYSLOG_NG_HAVE_INOTIFY
+
+static void
+poll_file_changes_on_file_event(gpointer s, guint32 event_mask)
+{
+  PollFileChanges *self = (PollFileChanges *) s;
+
+  if (event_mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))
+    self->follow_by_polling = TRUE;
+
+  if (!self->file_watch_active)
+    return;
+
+  poll_file_changes_suspend_watches(&self->super);
+  poll_file_changes_check_file(self);
+}
+
+static gboolean
+poll_file_changes_start_file_watch(PollFileChanges *self)
+{
+  if (!self->file_watch_enabled || self->follow_by_polling || self->fd < 0)
+    return FALSE;
+
+  if (!file_monitor_inotify_watch_start(&self->file_watch, self->fd))
+    {
+      self->follow_by_polling = TRUE;
+      return FALSE;
+    }
+
+  self->file_watch_active = TRUE;
+  return TRUE;
+}
+
+/*
+ * Instead of checking the file every follow_freq, wait for inotify to tell
+ * us that it changed, while we are at EOF.  Polling is used as a fallback
+ * when the file can't be watched, or when it got renamed or deleted, as
+ * its successor can only be found by checking its name periodically.
+ */
+void
+poll_file_changes_follow_with_inotify(PollFileChanges *self, FileMonitorInotify *monitor)
+{
+  file_monitor_inotify_watch_init(&self->file_watch, monitor, poll_file_changes_on_file_event, self);
+  self->file_watch_enabled = TRUE;
+
+  /* don't drop the watch each time the reader pauses to process a batch */
+  self->super.suspend_watches = poll_file_changes_suspend_watches;
+}
+
+#endif
+
 static gboolean
 poll_file_changes_check_eof(PollFileChanges *self)
 {
@@ -201,17 +269,40 @@ poll_file_changes_update_watches(PollEvents *s, GIOCondition cond)
   /* we can only provide input events */
   g_assert((cond & ~G_IO_IN) == 0);
 
-  poll_file_changes_stop_watches(s);
+  poll_file_changes_suspend_watches(s);
 
-  if (poll_file_changes_check_eof(self))
+#if SYSLOG_NG_HAVE_INOTIFY
+  /* start watching before checking for EOF, so that no change slips in between */
+  gboolean file_watched = poll_file_changes_start_file_watch(self);
+#endif
+
+  gboolean end_of_file = poll_file_changes_check_eof(self);
+  if (end_of_file)
     {
       msg_trace("End of file, following file",
                 evt_tag_str("follow_filename", self->follow_filename));
       check_again = poll_file_changes_on_eof(self);
     }
 
-  if (check_again)
-    poll_file_changes_rearm_timer(self);
+  if (!check_again)
+    {
+#if SYSLOG_NG_HAVE_INOTIFY
+      self->file_watch_active = FALSE;
+#endif
+      return;
+    }
+
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (file_watched)
+    {
+      /* inotify tells us about new data, unless it is already there */
+      if (!end_of_file)
+        poll_file_changes_rearm_timer(self, 0);
+      return;
+    }
+#endif
+
+  poll_file_changes_rearm_timer(self, self->follow_freq);
 }
 
 void
@@ -219,6 +310,10 @@ poll_file_changes_free(PollEvents *s)
 {
   PollFileChanges *self = (PollFileChanges *) s;
 
+#if SYSLOG_NG_HAVE_INOTIFY
+  if (self->file_watch_enabled)
+    file_monitor_inotify_watch_stop(&self->file_watch);
+#endif
   log_pipe_unref(self->control);
   g_free(self->follow_filename);
 }
@@ -28,6 +28,10 @@
 
 #include <iv.h>
 
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "file-monitor-inotify.h"
+#endif
+
 typedef struct _PollFileChanges PollFileChanges;
 
 struct _PollFileChanges
@@ -38,6 +42,13 @@ struct _PollFileChanges
   gint follow_freq;
   struct iv_timer follow_timer;
   LogPipe *control;
+#if SYSLOG_NG_HAVE_INOTIFY
+  FileMonitorInotifyWatch file_watch;
+  gboolean file_watch_enabled;
+  gboolean file_watch_active;
+  /* the file was renamed or deleted, look for its successor by polling */
+  gboolean follow_by_polling;
+#endif
 
   void (*on_read)(PollFileChanges *);
   gboolean (*on_eof)(PollFileChanges *);
@@ -49,7 +60,12 @@ PollEvents *poll_file_changes_new(gint fd, const gchar *follow_filename, gint fo
 void poll_file_changes_init_instance(PollFileChanges *self, gint fd, const gchar *follow_filename, gint follow_freq,
                                      LogPipe *control);
 void poll_file_changes_update_watches(PollEvents *s, GIOCondition cond);
+void poll_file_changes_suspend_watches(PollEvents *s);
 void poll_file_changes_stop_watches(PollEvents *s);
 void poll_file_changes_free(PollEvents *s);
 
+#if SYSLOG_NG_HAVE_INOTIFY
+void poll_file_changes_follow_with_inotify(PollFileChanges *self, FileMonitorInotify *monitor);
+#endif
+
 #endif
@@ -62,7 +62,7 @@ static LogProtoServer *
 _construct_src_proto(FileOpener *s, LogTransport *transport, LogProtoFileReaderOptions *proto_options)
 {
   log_proto_server_options_set_ack_tracker_factory(&proto_options->super,
-                                                   consecutive_ack_tracker_factory_new());
+                                                   log_proto_file_reader_options_new_ack_tracker_factory(proto_options));
   return log_proto_file_reader_new(transport, proto_options);
 }
 
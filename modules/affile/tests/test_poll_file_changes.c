@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "poll-file-changes.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "timeutils/misc.h"
+
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "file-monitor-inotify.h"
+#endif
+
+#include <iv.h>
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+/* long enough that only inotify can notice a change within a test */
+#define FOLLOW_FREQ_NEVER (3600 * 1000)
+#define FOLLOW_FREQ_FAST 50
+
+typedef struct _TestFile
+{
+  gchar filename[64];
+  gint fd;
+  PollFileChanges *poll_events;
+  LogPipe *control;
+  gint read_count;
+  gboolean timed_out;
+  struct iv_timer guard_timer;
+} TestFile;
+
+static void
+_on_read(gpointer user_data)
+{
+  TestFile *test_file = (TestFile *) user_data;
+
+  test_file->read_count++;
+  iv_quit();
+}
+
+static void
+_on_guard_timer_elapsed(gpointer user_data)
+{
+  TestFile *test_file = (TestFile *) user_data;
+
+  test_file->timed_out = TRUE;
+  iv_quit();
+}
+
+/* runs the main loop until the file has something to read, or @timeout_msec elapses */
+static void
+_run_main_loop(TestFile *test_file, gint timeout_msec)
+{
+  test_file->timed_out = FALSE;
+
+  IV_TIMER_INIT(&test_file->guard_timer);
+  test_file->guard_timer.cookie = test_file;
+  test_file->guard_timer.handler = _on_guard_timer_elapsed;
+  iv_validate_now();
+  test_file->guard_timer.expires = iv_now;
+  timespec_add_msec(&test_file->guard_timer.expires, timeout_msec);
+  iv_timer_register(&test_file->guard_timer);
+
+  iv_main();
+
+  if (iv_timer_registered(&test_file->guard_timer))
+    iv_timer_unregister(&test_file->guard_timer);
+}
+
+static void
+_append(const gchar *filename, const gchar *data)
+{
+  gint fd = open(filename, O_WRONLY | O_APPEND);
+
+  cr_assert(fd >= 0);
+  cr_assert_eq(write(fd, data, strlen(data)), (gssize) strlen(data));
+  close(fd);
+}
+
+/* the file is opened and read up to its end, just as a reader would leave it */
+static void
+_test_file_init(TestFile *test_file, gint follow_freq)
+{
+  g_strlcpy(test_file->filename, "test_poll_file_changes_XXXXXX", sizeof(test_file->filename));
+  gint fd = g_mkstemp(test_file->filename);
+  cr_assert(fd >= 0);
+  close(fd);
+  _append(test_file->filename, "first line\n");
+
+  test_file->fd = open(test_file->filename, O_RDONLY);
+  cr_assert(test_file->fd >= 0);
+  cr_assert(lseek(test_file->fd, 0, SEEK_END) > 0);
+
+  test_file->read_count = 0;
+  test_file->control = log_pipe_new(configuration);
+  test_file->poll_events = (PollFileChanges *) poll_file_changes_new(test_file->fd, test_file->filename, follow_freq,
+                           test_file->control);
+  poll_events_set_callback(&test_file->poll_events->super, _on_read, test_file);
+}
+
+static void
+_test_file_deinit(TestFile *test_file)
+{
+  poll_events_stop_watches(&test_file->poll_events->super);
+  poll_events_free(&test_file->poll_events->super);
+  log_pipe_unref(test_file->control);
+  close(test_file->fd);
+  unlink(test_file->filename);
+}
+
+Test(poll_file_changes, changes_are_detected_by_polling)
+{
+  TestFile test_file;
+  _test_file_init(&test_file, FOLLOW_FREQ_FAST);
+
+  poll_events_update_watches(&test_file.poll_events->super, G_IO_IN);
+  cr_assert(iv_timer_registered(&test_file.poll_events->follow_timer));
+
+  _append(test_file.filename, "second line\n");
+  _run_main_loop(&test_file, 5000);
+  cr_assert_not(test_file.timed_out, "the change was not noticed by polling");
+  cr_assert_eq(test_file.read_count, 1);
+
+  _test_file_deinit(&test_file);
+}
+
+#if SYSLOG_NG_HAVE_INOTIFY
+
+Test(poll_file_changes, changes_are_detected_through_inotify_without_polling)
+{
+  FileMonitorInotify *monitor = file_monitor_inotify_new();
+  cr_assert(monitor);
+
+  TestFile test_file;
+  _test_file_init(&test_file, FOLLOW_FREQ_NEVER);
+  poll_file_changes_follow_with_inotify(test_file.poll_events, monitor);
+
+  /* at EOF nothing is polled, the watch tells when the file changes */
+  poll_events_update_watches(&test_file.poll_events->super, G_IO_IN);
+  cr_assert_not(iv_timer_registered(&test_file.poll_events->follow_timer));
+  cr_assert(file_monitor_inotify_watch_is_registered(&test_file.poll_events->file_watch));
+
+  _run_main_loop(&test_file, 200);
+  cr_assert(test_file.timed_out);
+  cr_assert_eq(test_file.read_count, 0);
+
+  _append(test_file.filename, "second line\n");
+  _run_main_loop(&test_file, 5000);
+  cr_assert_not(test_file.timed_out, "the change was not noticed through inotify");
+  cr_assert_eq(test_file.read_count, 1);
+
+  /* the watch is kept while the reader processes the new data */
+  poll_events_suspend_watches(&test_file.poll_events->super);
+  cr_assert(file_monitor_inotify_watch_is_registered(&test_file.poll_events->file_watch));
+
+  _test_file_deinit(&test_file);
+  file_monitor_inotify_free(monitor);
+}
+
+Test(poll_file_changes, renamed_file_falls_back_to_polling)
+{
+  FileMonitorInotify *monitor = file_monitor_inotify_new();
+  cr_assert(monitor);
+
+  TestFile test_file;
+  _test_file_init(&test_file, FOLLOW_FREQ_FAST);
+  poll_file_changes_follow_with_inotify(test_file.poll_events, monitor);
+
+  poll_events_update_watches(&test_file.poll_events->super, G_IO_IN);
+  cr_assert_not(iv_timer_registered(&test_file.poll_events->follow_timer));
+
+  /* the successor of a renamed file can only be found by polling its name */
+  gchar *renamed = g_strdup_printf("%s.1", test_file.filename);
+  cr_assert(rename(test_file.filename, renamed) == 0);
+
+  _run_main_loop(&test_file, 500);
+  cr_assert(test_file.timed_out);
+  cr_assert(test_file.poll_events->follow_by_polling);
+  cr_assert(iv_timer_registered(&test_file.poll_events->follow_timer));
+
+  /* data written to the file still being read is noticed by polling */
+  _append(renamed, "second line\n");
+  _run_main_loop(&test_file, 5000);
+  cr_assert_not(test_file.timed_out, "the change was not noticed after falling back to polling");
+  cr_assert_eq(test_file.read_count, 1);
+
+  _test_file_deinit(&test_file);
+  unlink(renamed);
+  g_free(renamed);
+  file_monitor_inotify_free(monitor);
+}
+
+#endif
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(poll_file_changes, .init = setup, .fini = teardown);
@@ -314,6 +314,44 @@ _add_directory_monitor(WildcardSourceDriver *self, const gchar *directory)
   return monitor;
 }
 
+#if SYSLOG_NG_HAVE_INOTIFY
+
+/* a single inotify instance follows all the files of the driver, instead of a poll timer per file */
+static void
+_init_file_monitor(WildcardSourceDriver *self)
+{
+  if (self->monitor_method == MM_POLL)
+    return;
+
+  self->file_monitor = file_monitor_inotify_new();
+  self->file_reader_options.file_monitor = self->file_monitor;
+}
+
+static void
+_deinit_file_monitor(WildcardSourceDriver *self)
+{
+  self->file_reader_options.file_monitor = NULL;
+  if (self->file_monitor)
+    {
+      file_monitor_inotify_free(self->file_monitor);
+      self->file_monitor = NULL;
+    }
+}
+
+#else
+
+static void
+_init_file_monitor(WildcardSourceDriver *self)
+{
+}
+
+static void
+_deinit_file_monitor(WildcardSourceDriver *self)
+{
+}
+
+#endif
+
 static gboolean
 _init(LogPipe *s)
 {
@@ -338,9 +376,13 @@ _init(LogPipe *s)
     return FALSE;
 
   _init_opener_options(self, cfg);
+  _init_file_monitor(self);
 
   if (!_add_directory_monitor(self, self->base_dir))
-    return FALSE;
+    {
+      _deinit_file_monitor(self);
+      return FALSE;
+    }
 
   return TRUE;
 }
@@ -360,6 +402,7 @@ _deinit(LogPipe *s)
 
   g_pattern_spec_free(self->compiled_pattern);
   g_hash_table_foreach(self->file_readers, _deinit_reader, NULL);
+  _deinit_file_monitor(self);
   return TRUE;
 }
 
@@ -28,6 +28,9 @@
 #include "file-list.h"
 #include "directory-monitor.h"
 #include "directory-monitor-factory.h"
+#if SYSLOG_NG_HAVE_INOTIFY
+#include "file-monitor-inotify.h"
+#endif
 
 #define DEFAULT_MAX_FILES 100
 
@@ -49,6 +52,9 @@ typedef struct _WildcardSourceDriver
   GHashTable *file_readers;
   GHashTable *directory_monitors;
   FileOpener *file_opener;
+#if SYSLOG_NG_HAVE_INOTIFY
+  FileMonitorInotify *file_monitor;
+#endif
 
   PendingFileList *waiting_list;
 } WildcardSourceDriver;
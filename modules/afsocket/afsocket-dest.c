@@ -645,6 +645,13 @@ afsocket_dd_init(LogPipe *s)
       return FALSE;
     }
 
+  if (self->socket_options->reload_so_rcvbuf)
+    {
+      msg_warning("WARNING: reload-so-rcvbuf() is only supported for datagram sources, ignoring it",
+                  log_pipe_location_tag(s));
+      self->socket_options->reload_so_rcvbuf = 0;
+    }
+
   if (!_update_legacy_connection_persist_name(self))
     return FALSE;
 
@@ -68,6 +68,8 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "allow_compress",     KW_ALLOW_COMPRESS },
   { "ocsp_stapling_verify", KW_OCSP_STAPLING_VERIFY },
   { "openssl_conf_cmds",  KW_CONF_CMDS},
+  { "ktls",               KW_KTLS },
+  { "record_coalescing",  KW_RECORD_COALESCING },
 
   { "localip",            KW_LOCALIP },
   { "ip",                 KW_IP },
@@ -80,6 +82,7 @@ static CfgLexerKeyword afsocket_keywords[] =
   { "ip_freebind",        KW_IP_FREEBIND },
   { "so_broadcast",       KW_SO_BROADCAST },
   { "so_rcvbuf",          KW_SO_RCVBUF },
+  { "reload_so_rcvbuf",   KW_RELOAD_SO_RCVBUF },
   { "so_sndbuf",          KW_SO_SNDBUF },
   { "so_keepalive",       KW_SO_KEEPALIVE },
   { "so_reuseport",       KW_SO_REUSEPORT },
@@ -53,6 +53,7 @@ int deny_severity = 0;
 
 static const glong DYNAMIC_WINDOW_TIMER_MSECS = 1000;
 static const gsize DYNAMIC_WINDOW_REALLOC_TICKS = 5;
+static const glong RELOAD_RCVBUF_CHECK_MSECS = 1000;
 
 typedef struct _AFSocketSourceConnection
 {
@@ -62,6 +63,8 @@ typedef struct _AFSocketSourceConnection
   int sock;
   GSockAddr *peer_addr;
   GSockAddr *local_addr;
+  /* receive buffer size before reload-so-rcvbuf() was applied, 0 if it wasn't */
+  gint so_rcvbuf_before_reload;
 } AFSocketSourceConnection;
 
 static void afsocket_sd_close_connection(AFSocketSourceDriver *self, AFSocketSourceConnection *sc);
@@ -977,6 +980,112 @@ afsocket_sd_setup_transport(AFSocketSourceDriver *self)
 }
 
 
+/* Datagram sockets have no flow control, anything that arrives while the
+ * reload is in progress has to fit into the receive buffer.  */
+static void
+_enlarge_receive_buffers_for_reload(AFSocketSourceDriver *self)
+{
+  gint reload_so_rcvbuf = self->socket_options->reload_so_rcvbuf;
+
+  if (!reload_so_rcvbuf || self->transport_mapper->sock_type != SOCK_DGRAM)
+    return;
+
+  for (GList *p = self->connections; p; p = p->next)
+    {
+      AFSocketSourceConnection *sc = (AFSocketSourceConnection *) p->data;
+
+      if (sc->so_rcvbuf_before_reload)
+        continue;
+
+      if (!socket_options_enlarge_receive_buffer(sc->sock, reload_so_rcvbuf, &sc->so_rcvbuf_before_reload))
+        {
+          sc->so_rcvbuf_before_reload = 0;
+          continue;
+        }
+
+      msg_verbose("Enlarged receive buffer for the duration of the reload",
+                  evt_tag_int("fd", sc->sock),
+                  evt_tag_int("so_rcvbuf", sc->so_rcvbuf_before_reload),
+                  evt_tag_int("reload_so_rcvbuf", reload_so_rcvbuf));
+    }
+}
+
+/* Puts back the original receive buffer of the restored connections that
+ * have drained whatever piled up during the reload, returns whether any of
+ * them is still enlarged.  */
+static gboolean
+_restore_drained_receive_buffers(AFSocketSourceDriver *self)
+{
+  gboolean enlarged = FALSE;
+
+  for (GList *p = self->connections; p; p = p->next)
+    {
+      AFSocketSourceConnection *sc = (AFSocketSourceConnection *) p->data;
+
+      if (!sc->so_rcvbuf_before_reload)
+        continue;
+
+      if (!socket_options_receive_queue_drained(sc->sock, sc->so_rcvbuf_before_reload))
+        {
+          enlarged = TRUE;
+          continue;
+        }
+
+      socket_options_restore_receive_buffer(sc->sock, sc->so_rcvbuf_before_reload);
+      msg_verbose("Restored receive buffer after the reload",
+                  evt_tag_int("fd", sc->sock),
+                  evt_tag_int("so_rcvbuf", sc->so_rcvbuf_before_reload));
+      sc->so_rcvbuf_before_reload = 0;
+    }
+
+  return enlarged;
+}
+
+static void
+_reload_rcvbuf_timer_arm(AFSocketSourceDriver *self)
+{
+  iv_validate_now();
+  self->reload_rcvbuf_timer.expires = iv_now;
+  timespec_add_msec(&self->reload_rcvbuf_timer.expires, RELOAD_RCVBUF_CHECK_MSECS);
+  iv_timer_register(&self->reload_rcvbuf_timer);
+}
+
+static void
+_on_reload_rcvbuf_timer_elapsed(gpointer cookie)
+{
+  AFSocketSourceDriver *self = (AFSocketSourceDriver *) cookie;
+
+  if (_restore_drained_receive_buffers(self))
+    _reload_rcvbuf_timer_arm(self);
+}
+
+static void
+_reload_rcvbuf_timer_init(AFSocketSourceDriver *self)
+{
+  IV_TIMER_INIT(&self->reload_rcvbuf_timer);
+  self->reload_rcvbuf_timer.cookie = self;
+  self->reload_rcvbuf_timer.handler = _on_reload_rcvbuf_timer_elapsed;
+}
+
+/* the buffers stay enlarged until the queue is drained, which is checked
+ * right away, as nothing may have arrived during the reload, then
+ * periodically */
+static void
+_reload_rcvbuf_timer_start(AFSocketSourceDriver *self)
+{
+  if (!_restore_drained_receive_buffers(self) || iv_timer_registered(&self->reload_rcvbuf_timer))
+    return;
+
+  _reload_rcvbuf_timer_arm(self);
+}
+
+static void
+_reload_rcvbuf_timer_stop(AFSocketSourceDriver *self)
+{
+  if (iv_timer_registered(&self->reload_rcvbuf_timer))
+    iv_timer_unregister(&self->reload_rcvbuf_timer);
+}
+
 static void
 afsocket_sd_save_connections(AFSocketSourceDriver *self)
 {
@@ -997,6 +1106,7 @@ afsocket_sd_save_connections(AFSocketSourceDriver *self)
         {
           log_pipe_deinit((LogPipe *) p->data);
         }
+      _enlarge_receive_buffers_for_reload(self);
       cfg_persist_config_add(cfg, afsocket_sd_format_connections_name(self), self->connections,
                              (GDestroyNotify)afsocket_sd_kill_connection_list);
     }
@@ -1030,6 +1140,7 @@ afsocket_sd_restore_kept_alive_connections(AFSocketSourceDriver *self)
               afsocket_sd_kill_connection((AFSocketSourceConnection *)sc);
             }
         }
+      _reload_rcvbuf_timer_start(self);
     }
 }
 
@@ -1041,6 +1152,7 @@ afsocket_sd_init_watches(AFSocketSourceDriver *self)
   _dynamic_window_timer_init(self);
   _listen_fd_init(self);
   _packet_stats_timer_init(self);
+  _reload_rcvbuf_timer_init(self);
 }
 
 static void
@@ -1054,6 +1166,7 @@ afsocket_sd_start_watches(AFSocketSourceDriver *self)
 static void
 afsocket_sd_stop_watches(AFSocketSourceDriver *self)
 {
+  _reload_rcvbuf_timer_stop(self);
   _packet_stats_timer_stop(self);
   _dynamic_window_timer_stop(self);
   _listen_fd_stop(self);
@@ -1321,6 +1434,13 @@ afsocket_sd_init_method(LogPipe *s)
   if (!afsocket_sd_setup_transport(self) || !afsocket_sd_setup_addresses(self))
     return FALSE;
 
+  if (self->socket_options->reload_so_rcvbuf && self->transport_mapper->sock_type != SOCK_DGRAM)
+    {
+      msg_warning("WARNING: reload-so-rcvbuf() is only supported for datagram sources, ignoring it",
+                  log_pipe_location_tag(s));
+      self->socket_options->reload_so_rcvbuf = 0;
+    }
+
   afsocket_sd_register_stats(self);
   afsocket_sd_dynamic_window_init(self);
   afsocket_sd_restore_kept_alive_connections(self);
@@ -1328,6 +1448,7 @@ afsocket_sd_init_method(LogPipe *s)
   if (!afsocket_sd_open_listener(self))
     {
       /* returning FALSE, so deinit is not called */
+      _reload_rcvbuf_timer_stop(self);
       afsocket_sd_unregister_stats(self);
       afsocket_sd_drop_dynamic_window_pool(self);
       return FALSE;
@@ -45,6 +45,7 @@ struct _AFSocketSourceDriver
           activate_listener:1;
   struct iv_fd listen_fd;
   struct iv_timer dynamic_window_timer;
+  struct iv_timer reload_rcvbuf_timer;
   gsize dynamic_window_size;
   gsize dynamic_window_timer_tick;
   glong dynamic_window_stats_freq;
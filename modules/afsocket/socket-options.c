@@ -25,6 +25,10 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/sock_diag.h>
+#endif
 
 static gboolean
 _setup_receive_buffer(gint fd, gint so_rcvbuf)
@@ -110,6 +114,67 @@ _setup_reuseport(gint fd)
 #endif
 }
 
+/* Temporarily grows the receive buffer of a socket that stays open across
+ * a configuration reload, so that datagrams arriving while no reader is
+ * draining it are queued instead of dropped.  SO_RCVBUFFORCE bypasses
+ * net.core.rmem_max when we have the privileges for it.  The size the
+ * kernel reported before the change is returned in @orig_size.  */
+gboolean
+socket_options_enlarge_receive_buffer(gint fd, gint so_rcvbuf, gint *orig_size)
+{
+  socklen_t sz = sizeof(*orig_size);
+
+  if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, orig_size, &sz) < 0 || sz != sizeof(*orig_size))
+    return FALSE;
+
+  if (*orig_size >= so_rcvbuf)
+    return FALSE;
+
+#ifdef SO_RCVBUFFORCE
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &so_rcvbuf, sizeof(so_rcvbuf)) == 0)
+    return TRUE;
+#endif
+  return setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &so_rcvbuf, sizeof(so_rcvbuf)) == 0;
+}
+
+/* Reverts socket_options_enlarge_receive_buffer(), @orig_size is the value
+ * returned by it.  Linux doubles the requested size to account for
+ * bookkeeping overhead and reports the doubled value, so halve it back.  */
+void
+socket_options_restore_receive_buffer(gint fd, gint orig_size)
+{
+#ifdef __linux__
+  orig_size /= 2;
+#endif
+#ifdef SO_RCVBUFFORCE
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &orig_size, sizeof(orig_size)) == 0)
+    return;
+#endif
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &orig_size, sizeof(orig_size));
+}
+
+/* Whether whatever piled up in the receive queue during the reload has been
+ * read, so that the buffer can go back to @orig_size without dropping the
+ * datagrams that arrive afterwards.  SO_MEMINFO reports the memory used by
+ * the whole queue, FIONREAD only the next datagram, so without the former
+ * we have to wait for the queue to become empty.  */
+gboolean
+socket_options_receive_queue_drained(gint fd, gint orig_size)
+{
+#if defined(SO_MEMINFO) && defined(SK_MEMINFO_RMEM_ALLOC)
+  guint32 meminfo[SK_MEMINFO_VARS];
+  socklen_t sz = sizeof(meminfo);
+
+  if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &sz) == 0 && sz > SK_MEMINFO_RMEM_ALLOC * sizeof(guint32))
+    return meminfo[SK_MEMINFO_RMEM_ALLOC] < (guint32) orig_size / 2;  /* leave room for new datagrams */
+#endif
+
+  gint queued = 0;
+  if (ioctl(fd, FIONREAD, &queued) < 0)
+    return TRUE;
+  return queued == 0;
+}
+
 gboolean
 socket_options_setup_socket_method(SocketOptions *self, gint fd, GSockAddr *bind_addr, AFSocketDirection dir)
 {
@@ -38,6 +38,7 @@ struct _SocketOptions
   /* socket options */
   gint so_sndbuf;
   gint so_rcvbuf;
+  gint reload_so_rcvbuf;
   gint so_broadcast;
   gint so_keepalive;
   gboolean so_reuseport;
@@ -48,6 +49,9 @@ struct _SocketOptions
 
 gboolean socket_options_setup_socket_method(SocketOptions *self, gint fd, GSockAddr *bind_addr, AFSocketDirection dir);
 gboolean socket_options_setup_peer_socket_method(SocketOptions *self, gint fd, GSockAddr *bind_addr);
+gboolean socket_options_enlarge_receive_buffer(gint fd, gint so_rcvbuf, gint *orig_size);
+void socket_options_restore_receive_buffer(gint fd, gint orig_size);
+gboolean socket_options_receive_queue_drained(gint fd, gint orig_size);
 void socket_options_init_instance(SocketOptions *self);
 SocketOptions *socket_options_new(void);
 
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "afinet-source.h"
+#include "socket-options.h"
+#include "cfg-persist.h"
+#include "apphook.h"
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+guint SCS_TCP;
+guint SCS_TCP6;
+guint SCS_UDP;
+guint SCS_UDP6;
+guint SCS_NETWORK;
+guint SCS_SYSLOG;
+
+static gchar port[16];
+
+static void
+_pick_free_port(void)
+{
+  struct sockaddr_in addr = { .sin_family = AF_INET };
+  socklen_t len = sizeof(addr);
+  gint fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  cr_assert(bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+  cr_assert(getsockname(fd, (struct sockaddr *) &addr, &len) == 0);
+  close(fd);
+
+  g_snprintf(port, sizeof(port), "%d", ntohs(addr.sin_port));
+}
+
+static AFSocketSourceDriver *
+_tcp_source_new(void)
+{
+  AFInetSourceDriver *self = afinet_sd_new_tcp(configuration);
+
+  afinet_sd_set_localip(&self->super.super.super, "127.0.0.1");
+  afinet_sd_set_localport(&self->super.super.super, port);
+  return &self->super;
+}
+
+/* deinit() keeps the listening sockets and the UDP connection in the persist
+ * config, just like a reload */
+static void
+_reload_source(AFSocketSourceDriver *self)
+{
+  cr_assert(log_pipe_deinit(&self->super.super.super));
+  log_pipe_unref(&self->super.super.super);
+}
+
+#define SMALL_SO_RCVBUF 4096
+#define RELOAD_SO_RCVBUF (128 * 1024)
+
+static gint
+_get_rcvbuf(gint fd)
+{
+  gint so_rcvbuf = 0;
+  socklen_t len = sizeof(so_rcvbuf);
+
+  cr_assert(getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &so_rcvbuf, &len) == 0);
+  return so_rcvbuf;
+}
+
+static gint
+_small_udp_socket(void)
+{
+  gint fd = socket(AF_INET, SOCK_DGRAM, 0);
+  gint so_rcvbuf = SMALL_SO_RCVBUF;
+
+  cr_assert(fd >= 0);
+  cr_assert(setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &so_rcvbuf, sizeof(so_rcvbuf)) == 0);
+  return fd;
+}
+
+Test(afsocket_source, receive_buffer_is_enlarged_and_restored)
+{
+  gint fd = _small_udp_socket();
+  gint orig_size = _get_rcvbuf(fd);
+  gint reported_orig_size;
+
+  cr_assert(socket_options_enlarge_receive_buffer(fd, RELOAD_SO_RCVBUF, &reported_orig_size));
+  cr_assert_eq(reported_orig_size, orig_size);
+  cr_assert_gt(_get_rcvbuf(fd), orig_size);
+
+  socket_options_restore_receive_buffer(fd, reported_orig_size);
+  cr_assert_eq(_get_rcvbuf(fd), orig_size);
+
+  close(fd);
+}
+
+Test(afsocket_source, receive_buffer_that_is_large_enough_is_not_changed)
+{
+  gint fd = _small_udp_socket();
+  gint orig_size = _get_rcvbuf(fd);
+  gint reported_orig_size;
+
+  cr_assert_not(socket_options_enlarge_receive_buffer(fd, orig_size / 2, &reported_orig_size));
+  cr_assert_eq(_get_rcvbuf(fd), orig_size);
+
+  close(fd);
+}
+
+Test(afsocket_source, receive_queue_is_drained_when_empty)
+{
+  gint fd = _small_udp_socket();
+  struct sockaddr_in addr = { .sin_family = AF_INET };
+  socklen_t len = sizeof(addr);
+  gchar datagram[1024] = { 0 };
+
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  cr_assert(bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+  cr_assert(getsockname(fd, (struct sockaddr *) &addr, &len) == 0);
+  cr_assert(socket_options_receive_queue_drained(fd, _get_rcvbuf(fd)));
+
+  gint client = socket(AF_INET, SOCK_DGRAM, 0);
+  for (gint i = 0; i < 4; i++)
+    cr_assert(sendto(client, datagram, sizeof(datagram), 0, (struct sockaddr *) &addr, sizeof(addr)) > 0);
+  cr_assert_not(socket_options_receive_queue_drained(fd, _get_rcvbuf(fd)));
+
+  while (recv(fd, datagram, sizeof(datagram), MSG_DONTWAIT) > 0)
+    ;
+  cr_assert(socket_options_receive_queue_drained(fd, _get_rcvbuf(fd)));
+
+  close(client);
+  close(fd);
+}
+
+static AFSocketSourceDriver *
+_start_udp_source(void)
+{
+  AFInetSourceDriver *self = afinet_sd_new_udp(configuration);
+
+  afinet_sd_set_localip(&self->super.super.super, "127.0.0.1");
+  afinet_sd_set_localport(&self->super.super.super, port);
+  self->super.socket_options->so_rcvbuf = SMALL_SO_RCVBUF;
+  self->super.socket_options->reload_so_rcvbuf = RELOAD_SO_RCVBUF;
+
+  cr_assert(log_pipe_init(&self->super.super.super.super));
+  return &self->super;
+}
+
+/* the connection of a UDP source is not reachable from here, look the
+ * socket up by its address instead */
+static gint
+_find_udp_source_socket(void)
+{
+  for (gint fd = 0; fd < 1024; fd++)
+    {
+      struct sockaddr_in addr;
+      socklen_t len = sizeof(addr);
+      gint type;
+      socklen_t type_len = sizeof(type);
+
+      if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_len) < 0 || type != SOCK_DGRAM)
+        continue;
+      if (getsockname(fd, (struct sockaddr *) &addr, &len) < 0 || addr.sin_family != AF_INET)
+        continue;
+      if (ntohs(addr.sin_port) == atoi(port))
+        return fd;
+    }
+  return -1;
+}
+
+static void
+_send_datagrams(gint n)
+{
+  struct sockaddr_in addr = { .sin_family = AF_INET };
+  gchar datagram[1024];
+  gint client = socket(AF_INET, SOCK_DGRAM, 0);
+
+  memset(datagram, 'x', sizeof(datagram));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(atoi(port));
+  for (gint i = 0; i < n; i++)
+    cr_assert(sendto(client, datagram, sizeof(datagram), 0, (struct sockaddr *) &addr, sizeof(addr)) > 0);
+  close(client);
+}
+
+Test(afsocket_source, udp_receive_buffer_is_enlarged_while_reloading_and_kept_until_drained)
+{
+  AFSocketSourceDriver *sd = _start_udp_source();
+  gint fd = _find_udp_source_socket();
+  cr_assert(fd >= 0);
+  gint orig_size = _get_rcvbuf(fd);
+
+  /* nothing reads the socket between deinit() and the next init() */
+  _reload_source(sd);
+  cr_assert_eq(_find_udp_source_socket(), fd, "the socket was not kept open across the reload");
+  cr_assert_gt(_get_rcvbuf(fd), orig_size);
+
+  /* more than the original buffer could hold */
+  _send_datagrams(16);
+
+  sd = _start_udp_source();
+  cr_assert_eq(_find_udp_source_socket(), fd, "the kept-alive socket was not reused");
+  cr_assert_gt(_get_rcvbuf(fd), orig_size, "the buffer was restored before the backlog was read");
+
+  gchar datagram[2048];
+  while (recv(fd, datagram, sizeof(datagram), MSG_DONTWAIT) > 0)
+    ;
+
+  /* the buffer is still enlarged, the next reload finds the queue drained */
+  _reload_source(sd);
+  sd = _start_udp_source();
+  cr_assert_eq(_find_udp_source_socket(), fd);
+  cr_assert_eq(_get_rcvbuf(fd), orig_size);
+  _reload_source(sd);
+}
+
+Test(afsocket_source, udp_receive_buffer_without_backlog_is_restored_right_after_the_reload)
+{
+  AFSocketSourceDriver *sd = _start_udp_source();
+  gint fd = _find_udp_source_socket();
+  gint orig_size = _get_rcvbuf(fd);
+
+  _reload_source(sd);
+  cr_assert_gt(_get_rcvbuf(fd), orig_size);
+
+  sd = _start_udp_source();
+  cr_assert_eq(_find_udp_source_socket(), fd);
+  cr_assert_eq(_get_rcvbuf(fd), orig_size);
+  _reload_source(sd);
+}
+
+Test(afsocket_source, reload_so_rcvbuf_is_ignored_by_stream_sources)
+{
+  AFSocketSourceDriver *sd = _tcp_source_new();
+  sd->socket_options->reload_so_rcvbuf = RELOAD_SO_RCVBUF;
+
+  cr_assert(log_pipe_init(&sd->super.super.super));
+  cr_assert_eq(sd->socket_options->reload_so_rcvbuf, 0);
+  _reload_source(sd);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  configuration->persist = persist_config_new();
+  _pick_free_port();
+}
+
+static void
+teardown(void)
+{
+  /* closes the listening sockets kept for the next "reload" */
+  persist_config_free(configuration->persist);
+  configuration->persist = NULL;
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(afsocket_source, .init = setup, .fini = teardown);
@@ -58,6 +58,19 @@ disk_queue_options_compaction_set(DiskQueueOptions *self, gboolean compaction)
   self->compaction = compaction;
 }
 
+void
+disk_queue_options_compression_set(DiskQueueOptions *self, gboolean compression)
+{
+#ifndef SYSLOG_NG_HAVE_ZLIB
+  if (compression)
+    {
+      msg_warning("WARNING: compression() was ignored as syslog-ng was compiled without zlib support");
+      compression = FALSE;
+    }
+#endif
+  self->compression = compression;
+}
+
 void
 disk_queue_options_flow_control_window_bytes_set(DiskQueueOptions *self, gint flow_control_window_bytes)
 {
@@ -36,6 +36,7 @@ typedef struct _DiskQueueOptions
   gboolean read_only;
   gboolean reliable;
   gboolean compaction;
+  gboolean compression;
   gint flow_control_window_bytes;
   gint flow_control_window_size;
   gchar *dir;
@@ -47,6 +48,7 @@ void disk_queue_options_front_cache_size_set(DiskQueueOptions *self, gint front_
 void disk_queue_options_capacity_bytes_set(DiskQueueOptions *self, gint64 capacity_bytes);
 void disk_queue_options_reliable_set(DiskQueueOptions *self, gboolean reliable);
 void disk_queue_options_compaction_set(DiskQueueOptions *self, gboolean compaction);
+void disk_queue_options_compression_set(DiskQueueOptions *self, gboolean compression);
 void disk_queue_options_flow_control_window_bytes_set(DiskQueueOptions *self, gint flow_control_window_bytes);
 void disk_queue_options_flow_control_window_size_set(DiskQueueOptions *self, gint flow_control_window_size);
 void disk_queue_options_check_plugin_settings(DiskQueueOptions *self);
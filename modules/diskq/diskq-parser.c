@@ -37,6 +37,7 @@ static CfgLexerKeyword diskq_keywords[] =
   { "capacity_bytes",    KW_CAPACITY_BYTES },
   { "reliable",          KW_RELIABLE },
   { "compaction",        KW_COMPACTION },
+  { "compression",       KW_COMPRESSION },
   { "mem_buf_size",              KW_FLOW_CONTROL_WINDOW_BYTES },
   { "flow_control_window_bytes", KW_FLOW_CONTROL_WINDOW_BYTES },
   { "qout_size",         KW_FRONT_CACHE_SIZE },
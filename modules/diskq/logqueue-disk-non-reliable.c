@@ -315,12 +315,18 @@ _pop_head(LogQueue *s, LogPathOptions *path_options)
     {
       msg = _pop_head_front_cache(self, path_options);
       if (msg)
-        goto success;
+        {
+          stats_counter_inc(self->super.metrics.front_cache_hits);
+          goto success;
+        }
     }
 
   msg = log_queue_disk_read_message(&self->super, path_options);
   if (msg)
-    goto success;
+    {
+      stats_counter_inc(self->super.metrics.front_cache_misses);
+      goto success;
+    }
 
   if (self->flow_control_window->length > 0 && qdisk_is_read_only(self->super.qdisk))
     msg = _pop_head_flow_control_window(self, path_options);
@@ -59,6 +59,7 @@ log_queue_disk_stop(LogQueue *s, gboolean *persistent)
     }
 
   log_queue_queued_messages_sub(s, log_queue_get_length(s));
+  log_queue_backlog_reset(s);
   return self->stop(self, persistent);
 }
 
@@ -117,6 +118,31 @@ _unregister_counters(LogQueueDisk *self)
 
         stats_cluster_key_free(self->metrics.disk_allocated_sc_key);
       }
+
+    if (self->metrics.compression_input_sc_key)
+      {
+        stats_unregister_counter(self->metrics.compression_input_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.compression_input);
+        stats_unregister_counter(self->metrics.compression_output_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.compression_output);
+        stats_unregister_counter(self->metrics.compression_cpu_time_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.compression_cpu_time);
+
+        stats_cluster_key_free(self->metrics.compression_input_sc_key);
+        stats_cluster_key_free(self->metrics.compression_output_sc_key);
+        stats_cluster_key_free(self->metrics.compression_cpu_time_sc_key);
+      }
+
+    if (self->metrics.front_cache_hits_sc_key)
+      {
+        stats_unregister_counter(self->metrics.front_cache_hits_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.front_cache_hits);
+        stats_unregister_counter(self->metrics.front_cache_misses_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.front_cache_misses);
+
+        stats_cluster_key_free(self->metrics.front_cache_hits_sc_key);
+        stats_cluster_key_free(self->metrics.front_cache_misses_sc_key);
+      }
   }
   stats_unlock();
 }
@@ -137,6 +163,16 @@ log_queue_disk_update_disk_related_counters(LogQueueDisk *self)
 {
   stats_counter_set(self->metrics.disk_usage, B_TO_KiB(qdisk_get_used_useful_space(self->qdisk)));
   stats_counter_set(self->metrics.disk_allocated, B_TO_KiB(qdisk_get_file_size(self->qdisk)));
+
+  if (self->metrics.compression_input)
+    {
+      gint64 input_bytes, output_bytes, usec;
+
+      qdisk_get_compression_stats(self->qdisk, &input_bytes, &output_bytes, &usec);
+      stats_counter_set(self->metrics.compression_input, B_TO_KiB(input_bytes));
+      stats_counter_set(self->metrics.compression_output, B_TO_KiB(output_bytes));
+      stats_counter_set_time(self->metrics.compression_cpu_time, usec / 1000);
+    }
 }
 
 static gboolean
@@ -348,12 +384,73 @@ log_queue_disk_restart_corrupted(LogQueueDisk *self)
 {
   _restart_diskq(self);
   log_queue_queued_messages_reset(&self->super);
+  log_queue_backlog_reset(&self->super);
   log_queue_disk_update_disk_related_counters(self);
   stats_counter_set(self->metrics.capacity, B_TO_KiB(qdisk_get_max_useful_space(self->qdisk)));
 }
 
+/* the ratio is output/input, the time is the CPU time of the threads
+ * spent compressing and decompressing records */
 static void
-_register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
+_register_compression_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
+{
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_unit(builder, SCU_KIB);
+
+    stats_cluster_key_builder_set_name(builder, "compression_input_bytes");
+    self->metrics.compression_input_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "compression_output_bytes");
+    self->metrics.compression_output_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_unit(builder, SCU_MILLISECONDS);
+
+    stats_cluster_key_builder_set_name(builder, "compression_cpu_seconds");
+    self->metrics.compression_cpu_time_sc_key = stats_cluster_key_builder_build_single(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_lock();
+  {
+    stats_register_counter(stats_level, self->metrics.compression_input_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.compression_input);
+    stats_register_counter(stats_level, self->metrics.compression_output_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.compression_output);
+    stats_register_counter(stats_level, self->metrics.compression_cpu_time_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.compression_cpu_time);
+  }
+  stats_unlock();
+}
+
+/* only meaningful for non-reliable queues, where the front cache holds the
+ * messages to be read next in memory, a miss means a read from the disk */
+static void
+_register_front_cache_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
+{
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_name(builder, "front_cache_hits_total");
+    self->metrics.front_cache_hits_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_set_name(builder, "front_cache_misses_total");
+    self->metrics.front_cache_misses_sc_key = stats_cluster_key_builder_build_single(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_lock();
+  {
+    stats_register_counter(MAX(stats_level, STATS_LEVEL1), self->metrics.front_cache_hits_sc_key,
+                           SC_TYPE_SINGLE_VALUE, &self->metrics.front_cache_hits);
+    stats_register_counter(MAX(stats_level, STATS_LEVEL1), self->metrics.front_cache_misses_sc_key,
+                           SC_TYPE_SINGLE_VALUE, &self->metrics.front_cache_misses);
+  }
+  stats_unlock();
+}
+
+static void
+_register_counters(LogQueueDisk *self, DiskQueueOptions *options, gint stats_level,
+                   StatsClusterKeyBuilder *builder)
 {
   if (!builder)
     return;
@@ -384,6 +481,12 @@ _register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder
                            &self->metrics.disk_allocated);
   }
   stats_unlock();
+
+  if (options->compression)
+    _register_compression_counters(self, stats_level, builder);
+
+  if (!options->reliable && options->front_cache_size > 0)
+    _register_front_cache_counters(self, stats_level, builder);
 }
 
 void
@@ -407,7 +510,7 @@ log_queue_disk_init_instance(LogQueueDisk *self, DiskQueueOptions *options, cons
   self->compaction = options->compaction;
 
   self->qdisk = qdisk_new(options, qdisk_file_id, filename);
-  _register_counters(self, stats_level, queue_sck_builder);
+  _register_counters(self, options, stats_level, queue_sck_builder);
 
   if (queue_sck_builder)
     stats_cluster_key_builder_pop(queue_sck_builder);
@@ -46,10 +46,20 @@ struct _LogQueueDisk
     StatsClusterKey *capacity_sc_key;
     StatsClusterKey *disk_usage_sc_key;
     StatsClusterKey *disk_allocated_sc_key;
+    StatsClusterKey *compression_input_sc_key;
+    StatsClusterKey *compression_output_sc_key;
+    StatsClusterKey *compression_cpu_time_sc_key;
+    StatsClusterKey *front_cache_hits_sc_key;
+    StatsClusterKey *front_cache_misses_sc_key;
 
     StatsCounterItem *capacity;
     StatsCounterItem *disk_usage;
     StatsCounterItem *disk_allocated;
+    StatsCounterItem *compression_input;
+    StatsCounterItem *compression_output;
+    StatsCounterItem *compression_cpu_time;
+    StatsCounterItem *front_cache_hits;
+    StatsCounterItem *front_cache_misses;
   } metrics;
 
   gboolean compaction;
@@ -30,6 +30,7 @@
 #include "reloc.h"
 #include "compat/lfs.h"
 #include "scratch-buffers.h"
+#include "tls-support.h"
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -40,15 +41,36 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/file.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <time.h>
+
+#ifdef SYSLOG_NG_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 /* MADV_RANDOM not defined on legacy Linux systems. Could be removed in the
  * future, when support for Glibc 2.1.X drops.*/
 #ifndef MADV_RANDOM
 #define MADV_RANDOM 1
 #endif
+#ifndef MADV_SEQUENTIAL
+#define MADV_SEQUENTIAL 2
+#endif
 
 #define MAX_RECORD_LENGTH 100 * 1024 * 1024
 
+/* the first byte of each record in a compressed queue file */
+#define QDISK_RECORD_STORED 0
+#define QDISK_RECORD_DEFLATE 1
+
+/* marker, original length, length of the dictionary used */
+#define QDISK_DEFLATE_RECORD_HEADER_LEN (1 + sizeof(guint32) + sizeof(guint16))
+
+/* size of the preset dictionary kept in the file header, it has to fit
+ * into QDISK_RESERVED_SPACE along with the rest of the header */
+#define QDISK_COMPRESSION_DICT_SIZE 3072
+
 #define PATH_QDISK              PATH_LOCALSTATEDIR
 
 #define QDISK_HDR_VERSION_CURRENT 3
@@ -90,10 +112,22 @@ typedef union _QDiskFileHeader
 
     guint8 use_v1_wrap_condition;
     gint64 capacity_bytes;
+
+    /* records are stored in the format of _compress_record(), files
+     * created before this field existed have it zeroed */
+    guint8 compressed;
+
+    /* preset dictionary shared by the compressed records of the file, it is
+     * made of the first records pushed, and only grows until the file is
+     * emptied, see _extend_compression_dict() */
+    guint16 compression_dict_len;
+    gchar compression_dict[QDISK_COMPRESSION_DICT_SIZE];
   };
   gchar _pad2[QDISK_RESERVED_SPACE];
 } QDiskFileHeader;
 
+G_STATIC_ASSERT(sizeof(QDiskFileHeader) == QDISK_RESERVED_SPACE);
+
 struct _QDisk
 {
   gchar *filename;
@@ -102,6 +136,25 @@ struct _QDisk
   gint64 cached_file_size;
   QDiskFileHeader *hdr;
   DiskQueueOptions *options;
+
+  /* read-only mapping of the whole file, records are read back through it */
+  const gchar *read_map;
+  gint64 read_map_size;
+  gboolean read_map_failed;
+
+  struct
+  {
+    gint64 input_bytes;
+    gint64 output_bytes;
+    gint64 usec;
+#ifdef SYSLOG_NG_HAVE_ZLIB
+    /* raw deflate streams, reset for each record */
+    z_stream deflate;
+    gboolean deflate_initialized;
+    z_stream inflate;
+    gboolean inflate_initialized;
+#endif
+  } compression;
 };
 
 #define QDISK_ERROR qdisk_error_quark()
@@ -687,12 +740,9 @@ qdisk_get_next_tail_position(QDisk *self)
   return self->hdr->write_head;
 }
 
-gboolean
-qdisk_push_tail(QDisk *self, GString *record)
+static gboolean
+_push_tail_record(QDisk *self, GString *record)
 {
-  if (!qdisk_started(self))
-    return FALSE;
-
   if (_could_not_wrap_write_head_last_push_but_now_can(self))
     {
       /*
@@ -768,10 +818,407 @@ qdisk_push_tail(QDisk *self, GString *record)
   return TRUE;
 }
 
+/* the time spent in zlib is measured in CPU time of the calling thread,
+ * waiting for the queue lock or being scheduled out does not count */
+static gint64
+_thread_cpu_time_usec(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+#endif
+  return g_get_monotonic_time();
+}
+
+#ifdef SYSLOG_NG_HAVE_ZLIB
+
+static gboolean
+_deflate_payload(QDisk *self, const gchar *payload, gsize payload_len, GString *compressed)
+{
+  z_stream *strm = &self->compression.deflate;
+
+  if (!self->compression.deflate_initialized)
+    {
+      memset(strm, 0, sizeof(*strm));
+      if (deflateInit2(strm, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return FALSE;
+      self->compression.deflate_initialized = TRUE;
+    }
+  else if (deflateReset(strm) != Z_OK)
+    return FALSE;
+
+  guint16 dict_len = self->hdr->compression_dict_len;
+  if (dict_len > 0 && deflateSetDictionary(strm, (const Bytef *) self->hdr->compression_dict, dict_len) != Z_OK)
+    return FALSE;
+
+  gsize header_end = compressed->len + QDISK_DEFLATE_RECORD_HEADER_LEN;
+  uLong bound = deflateBound(strm, payload_len);
+
+  g_string_set_size(compressed, header_end + bound);
+  strm->next_in = (Bytef *) payload;
+  strm->avail_in = payload_len;
+  strm->next_out = (Bytef *) compressed->str + header_end;
+  strm->avail_out = bound;
+  if (deflate(strm, Z_FINISH) != Z_STREAM_END)
+    return FALSE;
+
+  gsize deflated_len = bound - strm->avail_out;
+  if (QDISK_DEFLATE_RECORD_HEADER_LEN + deflated_len >= payload_len)
+    return FALSE;
+
+  guint32 original_len = GUINT32_TO_BE(payload_len);
+  guint16 used_dict_len = GUINT16_TO_BE(dict_len);
+  gchar *header = compressed->str + header_end - QDISK_DEFLATE_RECORD_HEADER_LEN;
+
+  header[0] = QDISK_RECORD_DEFLATE;
+  memcpy(header + 1, &original_len, sizeof(original_len));
+  memcpy(header + 1 + sizeof(original_len), &used_dict_len, sizeof(used_dict_len));
+  g_string_set_size(compressed, header_end + deflated_len);
+  return TRUE;
+}
+
+static gboolean
+_inflate_payload(QDisk *self, GString *raw, GString *record)
+{
+  z_stream *strm = &self->compression.inflate;
+  guint32 original_len;
+  guint16 dict_len;
+
+  if (raw->len < QDISK_DEFLATE_RECORD_HEADER_LEN)
+    return FALSE;
+
+  memcpy(&original_len, raw->str + 1, sizeof(original_len));
+  original_len = GUINT32_FROM_BE(original_len);
+  memcpy(&dict_len, raw->str + 1 + sizeof(original_len), sizeof(dict_len));
+  dict_len = GUINT16_FROM_BE(dict_len);
+
+  /* the dictionary only grows, so the part this record used is still there */
+  if (original_len > MAX_RECORD_LENGTH || dict_len > self->hdr->compression_dict_len)
+    return FALSE;
+
+  if (!self->compression.inflate_initialized)
+    {
+      memset(strm, 0, sizeof(*strm));
+      if (inflateInit2(strm, -MAX_WBITS) != Z_OK)
+        return FALSE;
+      self->compression.inflate_initialized = TRUE;
+    }
+  else if (inflateReset(strm) != Z_OK)
+    return FALSE;
+
+  if (dict_len > 0 && inflateSetDictionary(strm, (const Bytef *) self->hdr->compression_dict, dict_len) != Z_OK)
+    return FALSE;
+
+  g_string_set_size(record, original_len);
+  strm->next_in = (Bytef *) raw->str + QDISK_DEFLATE_RECORD_HEADER_LEN;
+  strm->avail_in = raw->len - QDISK_DEFLATE_RECORD_HEADER_LEN;
+  strm->next_out = (Bytef *) record->str;
+  strm->avail_out = original_len;
+
+  return inflate(strm, Z_FINISH) == Z_STREAM_END && strm->avail_out == 0;
+}
+
+static void
+_free_compression_streams(QDisk *self)
+{
+  if (self->compression.deflate_initialized)
+    deflateEnd(&self->compression.deflate);
+  if (self->compression.inflate_initialized)
+    inflateEnd(&self->compression.inflate);
+
+  self->compression.deflate_initialized = FALSE;
+  self->compression.inflate_initialized = FALSE;
+}
+
+#else
+
+#define _deflate_payload(self, payload, payload_len, compressed) FALSE
+#define _inflate_payload(self, raw, record) FALSE
+#define _free_compression_streams(self)
+
+#endif
+
+/*
+ * Each record is compressed on its own, so the framing, the positions kept
+ * in the header and everything built on them (backlog ack/rewind, loading
+ * the queue after a restart) stay the same as in uncompressed files.
+ *
+ * A single message has little redundancy within itself, most of it is
+ * shared with the other messages of the same destination: name-value pair
+ * names, hosts, programs, the parts of the template that do not change.
+ * That is captured by a preset dictionary shared by every record of the
+ * file, stored in the header.  Each record notes how much of the
+ * dictionary it was compressed with, so the dictionary can keep growing
+ * while records are being written.  Records that do not shrink are stored
+ * as they are.
+ */
+static void
+_compress_record(QDisk *self, GString *record, GString *compressed)
+{
+  const gchar *payload = record->str + sizeof(guint32);
+  gsize payload_len = record->len - sizeof(guint32);
+  guint32 frame = 0;
+
+  g_string_truncate(compressed, 0);
+  g_string_append_len(compressed, (gchar *) &frame, sizeof(frame));
+
+  if (!_deflate_payload(self, payload, payload_len, compressed))
+    {
+      g_string_truncate(compressed, sizeof(frame));
+      g_string_append_c(compressed, QDISK_RECORD_STORED);
+      g_string_append_len(compressed, payload, payload_len);
+    }
+
+  frame = GUINT32_TO_BE(compressed->len - sizeof(frame));
+  memcpy(compressed->str, &frame, sizeof(frame));
+}
+
+/* the dictionary is filled with the payload of the first records written
+ * to the file, only bytes that no record refers to yet are changed */
+static void
+_extend_compression_dict(QDisk *self, GString *record)
+{
+  gsize dict_len = self->hdr->compression_dict_len;
+
+  if (dict_len >= QDISK_COMPRESSION_DICT_SIZE)
+    return;
+
+  gsize payload_len = record->len - sizeof(guint32);
+  gsize len = MIN(payload_len, QDISK_COMPRESSION_DICT_SIZE - dict_len);
+
+  memcpy(self->hdr->compression_dict + dict_len, record->str + sizeof(guint32), len);
+  self->hdr->compression_dict_len = dict_len + len;
+}
+
+static void
+_reset_compression_dict(QDisk *self)
+{
+  self->hdr->compression_dict_len = 0;
+}
+
+static gboolean
+_decompress_record(QDisk *self, GString *raw, GString *record)
+{
+  if (raw->len < 1)
+    return FALSE;
+
+  switch (raw->str[0])
+    {
+    case QDISK_RECORD_STORED:
+      g_string_truncate(record, 0);
+      g_string_append_len(record, raw->str + 1, raw->len - 1);
+      return TRUE;
+    case QDISK_RECORD_DEFLATE:
+      return _inflate_payload(self, raw, record);
+    default:
+      return FALSE;
+    }
+}
+
+gboolean
+qdisk_push_tail(QDisk *self, GString *record)
+{
+  if (!qdisk_started(self))
+    return FALSE;
+
+  if (!self->hdr->compressed)
+    return _push_tail_record(self, record);
+
+  ScratchBuffersMarker marker;
+  GString *compressed = scratch_buffers_alloc_and_mark(&marker);
+
+  gint64 start = _thread_cpu_time_usec();
+  _compress_record(self, record, compressed);
+  self->compression.usec += _thread_cpu_time_usec() - start;
+
+  gboolean success = _push_tail_record(self, compressed);
+  if (success)
+    {
+      self->compression.input_bytes += record->len;
+      self->compression.output_bytes += compressed->len;
+      _extend_compression_dict(self, record);
+    }
+
+  scratch_buffers_reclaim_marked(marker);
+  return success;
+}
+
+static void
+_unmap_read_map(QDisk *self)
+{
+  if (self->read_map)
+    munmap((void *) self->read_map, self->read_map_size);
+
+  self->read_map = NULL;
+  self->read_map_size = 0;
+  self->read_map_failed = FALSE;
+}
+
+/*
+ * Reading a MAP_SHARED mapping raises SIGBUS instead of returning an error
+ * if the page cannot be brought in: an I/O error of the underlying device,
+ * or the file being truncated by someone else.  qdisk_pop_head() and
+ * qdisk_peek_head() set a jump point once per record, copies out of the
+ * mapping are only done while one is set.  A SIGBUS raised during such a
+ * copy jumps back there, the mapping is disabled and the record is read
+ * again with pread(), which reports the error the usual way.  SIGBUS raised
+ * anywhere else is passed on to the previous handler.
+ *
+ * The handler is installed with SA_NODEFER, so SIGBUS is not left blocked
+ * when jumping out of it, and sigsetjmp() does not need to save the signal
+ * mask, which would cost a syscall per record.
+ */
+TLS_BLOCK_START
+{
+  sigjmp_buf *read_map_fault_jump;
+  gboolean read_map_copying;
+}
+TLS_BLOCK_END;
+
+#define read_map_fault_jump __tls_deref(read_map_fault_jump)
+#define read_map_copying __tls_deref(read_map_copying)
+
+static struct sigaction previous_sigbus_action;
+
+static void
+_read_map_sigbus_handler(gint signo, siginfo_t *info, gpointer context)
+{
+  if (read_map_copying && read_map_fault_jump)
+    {
+      read_map_copying = FALSE;
+      siglongjmp(*read_map_fault_jump, 1);
+    }
+
+  if (previous_sigbus_action.sa_flags & SA_SIGINFO)
+    {
+      previous_sigbus_action.sa_sigaction(signo, info, context);
+      return;
+    }
+
+  if (previous_sigbus_action.sa_handler != SIG_DFL && previous_sigbus_action.sa_handler != SIG_IGN)
+    {
+      previous_sigbus_action.sa_handler(signo);
+      return;
+    }
+
+  /* returning re-executes the faulting access, with the default action this time */
+  signal(SIGBUS, SIG_DFL);
+}
+
+static gpointer
+_install_read_map_sigbus_handler(gpointer user_data)
+{
+  struct sigaction sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = _read_map_sigbus_handler;
+  sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+  sigemptyset(&sa.sa_mask);
+
+  return GINT_TO_POINTER(sigaction(SIGBUS, &sa, &previous_sigbus_action) == 0);
+}
+
+static gboolean
+_read_map_sigbus_handler_installed(void)
+{
+  static GOnce install_once = G_ONCE_INIT;
+
+  return GPOINTER_TO_INT(g_once(&install_once, _install_read_map_sigbus_handler, NULL));
+}
+
+static void
+_copy_from_read_map(QDisk *self, gchar *buf, gsize length, gint64 position)
+{
+  read_map_copying = TRUE;
+  memcpy(buf, self->read_map + position, length);
+  read_map_copying = FALSE;
+}
+
+/* the record is read again with pread(), which reports the error (EIO,
+ * short read) to the caller, the mapping stays disabled until the file is
+ * reopened */
+static void
+_disable_read_map_after_fault(QDisk *self)
+{
+  read_map_fault_jump = NULL;
+
+  msg_warning("Error reading disk-queue file through its memory mapping, falling back to pread()",
+              evt_tag_str("filename", self->filename));
+  _unmap_read_map(self);
+  self->read_map_failed = TRUE;
+}
+
+/*
+ * The mapping is sized for the whole capacity (plus the one record that may
+ * stick out of it) up front, so it does not have to follow the file as
+ * pwrite() extends it.  MAP_SHARED pages come from the page cache, so
+ * whatever qdisk_push_tail() wrote is visible here without a remap.  Bytes
+ * beyond the current end of file are never touched, those would raise
+ * SIGBUS; such reads fall back to pread() and its short read errors.
+ */
+static gboolean
+_ensure_read_map(QDisk *self, gint64 position, gsize length)
+{
+  gint64 end = position + length;
+
+  if (end > self->cached_file_size)
+    return FALSE;
+
+  if (end <= self->read_map_size)
+    return TRUE;
+
+  if (self->read_map_failed)
+    return FALSE;
+
+  _unmap_read_map(self);
+
+  if (!_read_map_sigbus_handler_installed())
+    {
+      self->read_map_failed = TRUE;
+      return FALSE;
+    }
+
+  gint64 map_size = MAX(self->hdr->capacity_bytes + MAX_RECORD_LENGTH, self->cached_file_size);
+  if ((guint64) map_size > G_MAXSIZE)
+    {
+      self->read_map_failed = TRUE;
+      return FALSE;
+    }
+
+  void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, self->fd, 0);
+  if (map == MAP_FAILED)
+    {
+      msg_debug("Unable to map disk-queue file for reading, falling back to pread()",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      self->read_map_failed = TRUE;
+      return FALSE;
+    }
+
+  madvise(map, map_size, MADV_SEQUENTIAL);
+  self->read_map = map;
+  self->read_map_size = map_size;
+  return TRUE;
+}
+
+/* the mapping is only used where a fault can be recovered from, see
+ * _read_map_sigbus_handler() */
+static gssize
+_read_from_disk(QDisk *self, gchar *buf, gsize length, gint64 position)
+{
+  if (!read_map_fault_jump || !_ensure_read_map(self, position, length))
+    return pread(self->fd, buf, length, position);
+
+  _copy_from_read_map(self, buf, length, position);
+  return length;
+}
+
 static inline gssize
 _read_record_length_from_disk(QDisk *self, gint64 position, guint32 *record_length)
 {
-  gssize bytes_read = pread(self->fd, (gchar *)record_length, sizeof(guint32), position);
+  gssize bytes_read = _read_from_disk(self, (gchar *)record_length, sizeof(guint32), position);
 
   *record_length = GUINT32_FROM_BE(*record_length);
 
@@ -835,7 +1282,7 @@ _read_record_from_disk(QDisk *self, GString *record, guint32 record_length)
 {
   g_string_set_size(record, record_length);
 
-  gssize bytes_read = pread(self->fd, record->str, record_length, self->hdr->read_head + sizeof(record_length));
+  gssize bytes_read = _read_from_disk(self, record->str, record_length, self->hdr->read_head + sizeof(record_length));
   if (bytes_read != record_length)
     {
       msg_error("Error reading disk-queue file",
@@ -849,6 +1296,32 @@ _read_record_from_disk(QDisk *self, GString *record, guint32 record_length)
   return TRUE;
 }
 
+static gboolean
+_read_record(QDisk *self, GString *record, guint32 record_length)
+{
+  if (!self->hdr->compressed)
+    return _read_record_from_disk(self, record, record_length);
+
+  ScratchBuffersMarker marker;
+  GString *raw = scratch_buffers_alloc_and_mark(&marker);
+  gboolean success = _read_record_from_disk(self, raw, record_length);
+
+  if (success)
+    {
+      gint64 start = _thread_cpu_time_usec();
+      success = _decompress_record(self, raw, record);
+      self->compression.usec += _thread_cpu_time_usec() - start;
+
+      if (!success)
+        msg_error("Error decompressing disk-queue record",
+                  evt_tag_str("filename", self->filename),
+                  evt_tag_long("offset", self->hdr->read_head));
+    }
+
+  scratch_buffers_reclaim_marked(marker);
+  return success;
+}
+
 static inline void
 _maybe_apply_non_reliable_corrections(QDisk *self)
 {
@@ -882,8 +1355,8 @@ qdisk_get_next_head_position(QDisk *self)
   return next_read_head_position;
 }
 
-gboolean
-qdisk_peek_head(QDisk *self, GString *record)
+static gboolean
+_peek_head(QDisk *self, GString *record)
 {
   if (self->hdr->read_head == self->hdr->write_head)
     return FALSE;
@@ -895,14 +1368,14 @@ qdisk_peek_head(QDisk *self, GString *record)
   if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
     return FALSE;
 
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record(self, record, record_length))
     return FALSE;
 
   return TRUE;
 }
 
-gboolean
-qdisk_pop_head(QDisk *self, GString *record)
+static gboolean
+_pop_head(QDisk *self, GString *record)
 {
   if (self->hdr->read_head == self->hdr->write_head)
     return FALSE;
@@ -914,7 +1387,7 @@ qdisk_pop_head(QDisk *self, GString *record)
   if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
     return FALSE;
 
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record(self, record, record_length))
     return FALSE;
 
   _update_position_after_read(self, record_length, &self->hdr->read_head);
@@ -925,8 +1398,41 @@ qdisk_pop_head(QDisk *self, GString *record)
   return TRUE;
 }
 
+/* nothing is changed before the record is read in full, so after a fault
+ * it is read again from scratch (a scratch buffer taken by a compressed
+ * read is left to the next scratch buffer gc in that case) */
+gboolean
+qdisk_peek_head(QDisk *self, GString *record)
+{
+  sigjmp_buf fault_jump;
+
+  if (sigsetjmp(fault_jump, 0))
+    _disable_read_map_after_fault(self);
+  else
+    read_map_fault_jump = &fault_jump;
+
+  gboolean success = _peek_head(self, record);
+  read_map_fault_jump = NULL;
+  return success;
+}
+
+gboolean
+qdisk_pop_head(QDisk *self, GString *record)
+{
+  sigjmp_buf fault_jump;
+
+  if (sigsetjmp(fault_jump, 0))
+    _disable_read_map_after_fault(self);
+  else
+    read_map_fault_jump = &fault_jump;
+
+  gboolean success = _pop_head(self, record);
+  read_map_fault_jump = NULL;
+  return success;
+}
+
 static gboolean
-_skip_record(QDisk *self, gint64 position, gint64 *new_position)
+_skip_record_unguarded(QDisk *self, gint64 position, gint64 *new_position)
 {
   if (position == self->hdr->write_head)
     return FALSE;
@@ -944,6 +1450,21 @@ _skip_record(QDisk *self, gint64 position, gint64 *new_position)
   return TRUE;
 }
 
+static gboolean
+_skip_record(QDisk *self, gint64 position, gint64 *new_position)
+{
+  sigjmp_buf fault_jump;
+
+  if (sigsetjmp(fault_jump, 0))
+    _disable_read_map_after_fault(self);
+  else
+    read_map_fault_jump = &fault_jump;
+
+  gboolean success = _skip_record_unguarded(self, position, new_position);
+  read_map_fault_jump = NULL;
+  return success;
+}
+
 gboolean
 qdisk_remove_head(QDisk *self)
 {
@@ -1341,6 +1862,9 @@ _save_state(QDisk *self, GQueue *front_cache, GQueue *backlog, GQueue *flow_cont
 static void
 _close_file(QDisk *self)
 {
+  _unmap_read_map(self);
+  _free_compression_streams(self);
+
   if (self->hdr)
     {
       if (self->options->read_only)
@@ -1381,6 +1905,7 @@ _ensure_header_byte_order(QDisk *self)
       self->hdr->backlog_head = GUINT64_SWAP_LE_BE(self->hdr->backlog_head);
       self->hdr->backlog_len = GUINT64_SWAP_LE_BE(self->hdr->backlog_len);
       self->hdr->capacity_bytes = GUINT64_SWAP_LE_BE(self->hdr->capacity_bytes);
+      self->hdr->compression_dict_len = GUINT16_SWAP_LE_BE(self->hdr->compression_dict_len);
       self->hdr->big_endian = (G_BYTE_ORDER == G_BIG_ENDIAN);
     }
 }
@@ -1451,6 +1976,8 @@ _create_header(QDisk *self)
   self->hdr->length = 0;
   self->hdr->use_v1_wrap_condition = FALSE;
   self->hdr->capacity_bytes = self->options->capacity_bytes;
+  self->hdr->compressed = self->options->compression;
+  _reset_compression_dict(self);
 
   return TRUE;
 }
@@ -1523,6 +2050,15 @@ _load_header(QDisk *self)
       return FALSE;
     }
 
+#ifndef SYSLOG_NG_HAVE_ZLIB
+  if (self->hdr->compressed)
+    {
+      msg_error("Error reading disk-queue file, it is compressed but syslog-ng was compiled without zlib support",
+                evt_tag_str("filename", self->filename));
+      return FALSE;
+    }
+#endif
+
   if (qdisk_header_is_inconsistent(self))
     {
       msg_error("Inconsistent header data in disk-queue file, ignoring",
@@ -1555,7 +2091,8 @@ _load_state(QDisk *self, GQueue *front_cache, GQueue *backlog, GQueue *flow_cont
 
       msg_info("Disk-buffer state loaded",
                evt_tag_str("filename", self->filename),
-               evt_tag_long("number_of_messages", _number_of_messages(self)));
+               evt_tag_long("number_of_messages", _number_of_messages(self)),
+               evt_tag_str("compression", self->hdr->compressed ? "yes" : "no"));
 
       msg_debug("Disk-buffer internal state",
                 evt_tag_str("filename", self->filename),
@@ -1576,7 +2113,8 @@ _load_state(QDisk *self, GQueue *front_cache, GQueue *backlog, GQueue *flow_cont
       self->cached_file_size = st.st_size;
       msg_info("Reliable disk-buffer state loaded",
                evt_tag_str("filename", self->filename),
-               evt_tag_long("number_of_messages", _number_of_messages(self)));
+               evt_tag_long("number_of_messages", _number_of_messages(self)),
+               evt_tag_str("compression", self->hdr->compressed ? "yes" : "no"));
 
       msg_debug("Reliable disk-buffer internal state",
                 evt_tag_str("filename", self->filename),
@@ -1766,9 +2304,28 @@ qdisk_reset_file_if_empty(QDisk *self)
   self->hdr->write_head = QDISK_RESERVED_SPACE;
   self->hdr->backlog_head = QDISK_RESERVED_SPACE;
 
+  /* nothing is left in the old format, so compression() can take effect,
+   * and the dictionary can be rebuilt from the records to come */
+  self->hdr->compressed = self->options->compression;
+  _reset_compression_dict(self);
+
   _maybe_truncate_file(self, QDISK_RESERVED_SPACE);
 }
 
+void
+qdisk_get_compression_stats(QDisk *self, gint64 *input_bytes, gint64 *output_bytes, gint64 *usec)
+{
+  *input_bytes = self->compression.input_bytes;
+  *output_bytes = self->compression.output_bytes;
+  *usec = self->compression.usec;
+}
+
+gboolean
+qdisk_is_compressed(QDisk *self)
+{
+  return self->hdr && self->hdr->compressed;
+}
+
 DiskQueueOptions *
 qdisk_get_options(QDisk *self)
 {
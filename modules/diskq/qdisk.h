@@ -86,6 +86,8 @@ gint qdisk_get_flow_control_window_bytes(QDisk *self);
 gboolean qdisk_is_read_only(QDisk *self);
 const gchar *qdisk_get_filename(QDisk *self);
 gint64 qdisk_get_file_size(QDisk *self);
+gboolean qdisk_is_compressed(QDisk *self);
+void qdisk_get_compression_stats(QDisk *self, gint64 *input_bytes, gint64 *output_bytes, gint64 *usec);
 
 gchar *qdisk_get_next_filename(const gchar *dir, gboolean reliable);
 gboolean qdisk_is_file_a_disk_buffer_file(const gchar *filename);
@@ -391,6 +391,46 @@ ParameterizedTest(restart_test_parameters *test_case, diskq, testcase_diskbuffer
   disk_queue_options_destroy(&options);
 }
 
+Test(diskq, testcase_rewound_messages_dropped_by_a_restart_are_not_left_out_of_the_age_histogram)
+{
+  DiskQueueOptions options;
+  _construct_options(&options, 1000123, 100000, FALSE);
+  const gchar *filename = "test-diskq-restart-rewound.qf";
+  const gchar *filename_corrupted_dq = "test-diskq-restart-rewound.qf.corrupted";
+  unlink(filename);
+  unlink(filename_corrupted_dq);
+
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_disk_non_reliable_new(&options, filename, NULL, STATS_LEVEL0, driver_sck_builder,
+                                                queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+  log_queue_disk_start(q);
+
+  feed_some_messages(q, 10);
+  send_some_messages(q, 10, FALSE);
+  log_queue_rewind_backlog_all(q);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.message_age_count), 10);
+
+  /* the rewound messages go away with the corrupted file, they are never popped again */
+  log_queue_disk_restart_corrupted((LogQueueDisk *) q);
+  cr_assert_eq(log_queue_get_length(q), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.backlog), 0);
+
+  feed_some_messages(q, 5);
+  send_some_messages(q, 5, TRUE);
+  cr_assert_eq(stats_counter_get(q->metrics.owned.message_age_count), 15,
+               "fresh messages were taken for the dropped rewound ones");
+
+  gboolean persistent;
+  log_queue_disk_stop(q, &persistent);
+  log_queue_unref(q);
+  unlink(filename);
+  unlink(filename_corrupted_dq);
+  disk_queue_options_destroy(&options);
+}
+
 static gboolean
 is_valid_msg_size(guint32 one_msg_size)
 {
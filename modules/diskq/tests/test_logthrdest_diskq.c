@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <criterion/criterion.h>
+
+#include "diskq.h"
+#include "diskq-global-metrics.h"
+#include "logthrdest/logthrdestdrv.h"
+#include "mainloop.h"
+#include "mainloop-worker.h"
+#include "apphook.h"
+
+#define TEST_PERSIST_FILE "test_logthrdest_diskq.persist"
+#define TEST_DISKQ_DIR "test_logthrdest_diskq"
+
+/* a third of them fits in a single disk-buffer, all of them do not, so
+ * moving the queues of the removed workers fills up the remaining one */
+#define NUM_MESSAGES 3000
+#define MESSAGE_PAYLOAD_LENGTH 512
+
+/* spins maximum about 30 seconds */
+#define MAX_SPIN_ITERATIONS 30000
+
+static gint delivered[NUM_MESSAGES];
+
+static const gchar *
+_generate_persist_name(const LogPipe *s)
+{
+  return "test-logthrdest-diskq";
+}
+
+static const gchar *
+_format_stats_key(LogThreadedDestDriver *s, StatsClusterKeyBuilder *kb)
+{
+  stats_cluster_key_builder_add_legacy_label(kb, stats_cluster_label("driver", "test-logthrdest-diskq"));
+  return NULL;
+}
+
+static LogThreadedResult
+_insert_and_record_delivery(LogThreadedDestWorker *s, LogMessage *msg)
+{
+  gint index = atoi(log_msg_get_value(msg, LM_V_PID, NULL));
+
+  cr_assert(index >= 0 && index < NUM_MESSAGES);
+  g_atomic_int_inc(&delivered[index]);
+  return LTR_SUCCESS;
+}
+
+static LogThreadedDestWorker *
+_construct_worker(LogThreadedDestDriver *s, gint worker_index)
+{
+  LogThreadedDestWorker *self = g_new0(LogThreadedDestWorker, 1);
+
+  log_threaded_dest_worker_init_instance(self, s, worker_index);
+  self->insert = _insert_and_record_delivery;
+  return self;
+}
+
+static LogThreadedDestDriver *
+_test_dd_new(gint num_workers)
+{
+  LogThreadedDestDriver *self = g_new0(LogThreadedDestDriver, 1);
+
+  log_threaded_dest_driver_init_instance(self, main_loop_get_current_config(main_loop_get_instance()));
+  self->super.super.super.generate_persist_name = _generate_persist_name;
+  self->format_stats_key = _format_stats_key;
+  self->worker.construct = _construct_worker;
+  log_threaded_dest_driver_set_num_workers(&self->super.super, num_workers);
+
+  DiskQDestPlugin *plugin = diskq_dest_plugin_new();
+  DiskQueueOptions *options = diskq_get_options(plugin);
+  disk_queue_options_capacity_bytes_set(options, MIN_CAPACITY_BYTES);
+  disk_queue_options_reliable_set(options, TRUE);
+  disk_queue_options_set_dir(options, TEST_DISKQ_DIR);
+  cr_assert(log_driver_add_plugin(&self->super.super, (LogDriverPlugin *) plugin));
+
+  return self;
+}
+
+static void
+_free_dd(LogThreadedDestDriver *dd)
+{
+  main_loop_sync_worker_startup_and_teardown();
+  cr_assert(log_pipe_deinit(&dd->super.super.super));
+  log_pipe_unref(&dd->super.super.super);
+}
+
+static void
+_queue_messages(LogThreadedDestDriver *dd, gint n)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT_NOACK;
+  gchar payload[MESSAGE_PAYLOAD_LENGTH + 1];
+  gchar pid[32];
+
+  memset(payload, 'x', MESSAGE_PAYLOAD_LENGTH);
+  payload[MESSAGE_PAYLOAD_LENGTH] = 0;
+
+  for (gint i = 0; i < n; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+
+      g_snprintf(pid, sizeof(pid), "%d", i);
+      log_msg_set_value(msg, LM_V_PID, pid, -1);
+      log_msg_set_value(msg, LM_V_MESSAGE, payload, -1);
+      log_pipe_queue(&dd->super.super.super, msg, &path_options);
+    }
+}
+
+static gint64
+_queued_messages(LogThreadedDestDriver *dd)
+{
+  gint64 queued = 0;
+
+  for (gint i = 0; i < dd->num_workers; i++)
+    queued += log_queue_get_length(dd->workers[i]->queue);
+  return queued;
+}
+
+static void
+_spin_for_written_messages(LogThreadedDestDriver *dd, gssize expected_value)
+{
+  gssize value = stats_counter_get(dd->metrics.written_messages);
+
+  for (gint c = 0; value != expected_value && c < MAX_SPIN_ITERATIONS; c++)
+    {
+      g_usleep(1000);
+      value = stats_counter_get(dd->metrics.written_messages);
+    }
+  cr_assert(value == expected_value,
+            "messages were not delivered in time, expected=%" G_GSSIZE_FORMAT ", delivered=%" G_GSSIZE_FORMAT,
+            expected_value, value);
+}
+
+Test(logthrdest_diskq, lowering_workers_moves_the_queues_of_removed_workers_without_drops)
+{
+  /* fill the disk-buffers of 3 workers without delivering anything */
+  LogThreadedDestDriver *dd = _test_dd_new(3);
+  cr_assert(log_pipe_init(&dd->super.super.super));
+
+  _queue_messages(dd, NUM_MESSAGES);
+  cr_assert(_queued_messages(dd) == NUM_MESSAGES, "the initial queues must hold every message, queued=%"
+            G_GINT64_FORMAT, _queued_messages(dd));
+  for (gint i = 0; i < dd->num_workers; i++)
+    cr_assert(log_queue_get_length(dd->workers[i]->queue) > 0, "worker %d has nothing queued", i);
+
+  _free_dd(dd);
+
+  /* restart with a single worker, the other two disk-buffers are adopted */
+  dd = _test_dd_new(1);
+  cr_assert(log_pipe_init(&dd->super.super.super));
+  cr_assert(log_pipe_post_config_init(&dd->super.super.super));
+
+  _spin_for_written_messages(dd, NUM_MESSAGES);
+
+  for (gint i = 0; i < NUM_MESSAGES; i++)
+    cr_assert(g_atomic_int_get(&delivered[i]) == 1, "message %d delivered %d times", i, delivered[i]);
+  cr_assert(stats_counter_get(dd->metrics.dropped_messages) == 0);
+
+  _free_dd(dd);
+
+  /* the adopted queues are emptied, and nothing is left to move */
+  dd = _test_dd_new(1);
+  cr_assert(log_pipe_init(&dd->super.super.super));
+  cr_assert(_queued_messages(dd) == 0);
+  cr_assert(dd->workers[0]->adopted_queues == NULL);
+  _free_dd(dd);
+}
+
+static void
+_remove_test_dir(void)
+{
+  GDir *dir = g_dir_open(TEST_DISKQ_DIR, 0, NULL);
+
+  if (!dir)
+    return;
+
+  const gchar *name;
+  while ((name = g_dir_read_name(dir)))
+    {
+      gchar *path = g_build_filename(TEST_DISKQ_DIR, name, NULL);
+      unlink(path);
+      g_free(path);
+    }
+  g_dir_close(dir);
+  rmdir(TEST_DISKQ_DIR);
+}
+
+MainLoopOptions main_loop_options = {0};
+
+static void
+setup(void)
+{
+  app_startup();
+
+  MainLoop *main_loop = main_loop_get_instance();
+  main_loop_init(main_loop, &main_loop_options);
+
+  GlobalConfig *cfg = main_loop_get_current_config(main_loop);
+  cfg_set_current_version(cfg);
+  cfg->state = persist_state_new(TEST_PERSIST_FILE);
+  persist_state_start(cfg->state);
+  diskq_global_metrics_init();
+
+  main_loop_worker_allocate_thread_space(3);
+  main_loop_worker_finalize_thread_space();
+}
+
+static void
+teardown(void)
+{
+  MainLoop *main_loop = main_loop_get_instance();
+  GlobalConfig *cfg = main_loop_get_current_config(main_loop);
+
+  persist_state_cancel(cfg->state);
+  unlink(TEST_PERSIST_FILE);
+  _remove_test_dir();
+
+  main_loop_deinit(main_loop);
+  app_shutdown();
+}
+
+TestSuite(logthrdest_diskq, .init = setup, .fini = teardown);
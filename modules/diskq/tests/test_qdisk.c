@@ -27,11 +27,16 @@
 #include "apphook.h"
 #include "qdisk.h"
 #include "scratch-buffers.h"
+#include "logmsg/logmsg-serialize.h"
 
 #include <unistd.h>
 #include <sys/stat.h>
 #include <errno.h>
 
+#ifdef SYSLOG_NG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 /* QDisk-internal: the frame is a 4-byte integer */
 #define FRAME_LENGTH 4
 
@@ -261,6 +266,156 @@ Test(qdisk, qdisk_basic_ack_rewind)
   cleanup_qdisk(filename, qdisk);
 }
 
+#ifdef SYSLOG_NG_HAVE_ZLIB
+
+Test(qdisk, compressed_records_survive_ack_rewind_and_restart)
+{
+  const gchar *filename = "test_qdisk_compressed.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  disk_queue_options_compression_set(qdisk_get_options(qdisk), TRUE);
+  qdisk_start(qdisk, NULL, NULL, NULL);
+  cr_assert(qdisk_is_compressed(qdisk));
+
+  gsize num_of_records = 100;
+  guint record_len = 1024;
+
+  for (gsize i = 0; i < num_of_records; ++i)
+    cr_assert(push_dummy_record(qdisk, record_len));
+
+  gint64 input_bytes, output_bytes, usec;
+  qdisk_get_compression_stats(qdisk, &input_bytes, &output_bytes, &usec);
+  cr_assert_eq(input_bytes, num_of_records * (record_len + FRAME_LENGTH));
+  cr_assert_lt(output_bytes, input_bytes / 10, "repetitive records should compress well, in: %" G_GINT64_FORMAT
+               ", out: %" G_GINT64_FORMAT, input_bytes, output_bytes);
+  cr_assert_lt(qdisk_get_writer_head(qdisk) - QDISK_RESERVED_SPACE, input_bytes / 10);
+
+  GString *popped_data = g_string_new(NULL);
+  for (gsize i = 0; i < 10; ++i)
+    {
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+  for (gsize i = 0; i < 5; ++i)
+    cr_assert(qdisk_ack_backlog(qdisk));
+  cr_assert(qdisk_rewind_backlog(qdisk, 5));
+  cr_assert_eq(qdisk_get_length(qdisk), num_of_records - 5);
+
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+
+  /* the file stays compressed even if the option is turned off */
+  disk_queue_options_compression_set(qdisk_get_options(qdisk), FALSE);
+  cr_assert(qdisk_start(qdisk, NULL, NULL, NULL));
+  cr_assert(qdisk_is_compressed(qdisk));
+
+  for (gsize i = 5; i < num_of_records; ++i)
+    {
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+
+  g_string_free(popped_data, TRUE);
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+static const gchar *realistic_programs[] = { "sshd", "sudo", "kernel", "postfix/smtpd", "CRON" };
+
+static gboolean
+_serialize_realistic_message(SerializeArchive *sa, gpointer user_data)
+{
+  gsize i = GPOINTER_TO_SIZE(user_data);
+  LogMessage *msg = log_msg_new_empty();
+  gchar value[256];
+
+  log_msg_set_value(msg, LM_V_HOST, i % 3 ? "web-01.example.com" : "db-02.example.com", -1);
+  log_msg_set_value(msg, LM_V_PROGRAM, realistic_programs[i % G_N_ELEMENTS(realistic_programs)], -1);
+  g_snprintf(value, sizeof(value), "%" G_GSIZE_FORMAT, 1000 + i * 7);
+  log_msg_set_value(msg, LM_V_PID, value, -1);
+  g_snprintf(value, sizeof(value), "Accepted publickey for user%" G_GSIZE_FORMAT " from 10.0.%" G_GSIZE_FORMAT
+             ".%" G_GSIZE_FORMAT " port %" G_GSIZE_FORMAT " ssh2: RSA SHA256:%08" G_GSIZE_MODIFIER "x",
+             i % 17, i % 256, (i * 31) % 256, 20000 + (i * 7919) % 40000, i * 2654435761U);
+  log_msg_set_value(msg, LM_V_MESSAGE, value, -1);
+  log_msg_set_value_by_name(msg, ".SDATA.meta.sequenceId", value + strlen(value) - 8, -1);
+  log_msg_set_value_by_name(msg, "environment", "production", -1);
+
+  gboolean success = log_msg_serialize(msg, sa, 0);
+  log_msg_unref(msg);
+  return success;
+}
+
+/* the size of the same payloads, each deflated on its own */
+static gint64
+_deflate_records_one_by_one(GPtrArray *records)
+{
+  gint64 total = 0;
+
+  for (guint i = 0; i < records->len; i++)
+    {
+      GString *record = g_ptr_array_index(records, i);
+      uLongf len = compressBound(record->len);
+      Bytef *buf = g_malloc(len);
+
+      cr_assert_eq(compress2(buf, &len, (const Bytef *) record->str, record->len, Z_BEST_SPEED), Z_OK);
+      total += FRAME_LENGTH + MIN(len, record->len);
+      g_free(buf);
+    }
+  return total;
+}
+
+Test(qdisk, compressed_realistic_records_share_redundancy_across_records)
+{
+  const gchar *filename = "test_qdisk_compressed_realistic.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  disk_queue_options_compression_set(qdisk_get_options(qdisk), TRUE);
+  qdisk_start(qdisk, NULL, NULL, NULL);
+
+  gsize num_of_records = 500;
+  GPtrArray *records = g_ptr_array_new_with_free_func((GDestroyNotify) g_string_free);
+
+  for (gsize i = 0; i < num_of_records; ++i)
+    {
+      GString *record = g_string_new(NULL);
+      cr_assert(qdisk_serialize(record, _serialize_realistic_message, GSIZE_TO_POINTER(i), NULL));
+      cr_assert(qdisk_push_tail(qdisk, record));
+
+      g_string_erase(record, 0, FRAME_LENGTH);
+      g_ptr_array_add(records, record);
+    }
+
+  gint64 input_bytes, output_bytes, usec;
+  qdisk_get_compression_stats(qdisk, &input_bytes, &output_bytes, &usec);
+  gint64 one_by_one_bytes = _deflate_records_one_by_one(records);
+
+  cr_log_info("realistic records, in: %" G_GINT64_FORMAT ", out: %" G_GINT64_FORMAT
+              ", deflated one by one: %" G_GINT64_FORMAT, input_bytes, output_bytes, one_by_one_bytes);
+  cr_assert_lt(output_bytes, one_by_one_bytes * 2 / 3,
+               "the shared dictionary should capture the redundancy between records, out: %" G_GINT64_FORMAT
+               ", deflated one by one: %" G_GINT64_FORMAT, output_bytes, one_by_one_bytes);
+
+  /* the dictionary is kept in the header, so the records can be read back after a restart */
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+  cr_assert(qdisk_start(qdisk, NULL, NULL, NULL));
+
+  GString *popped_data = g_string_new(NULL);
+  for (gsize i = 0; i < num_of_records; ++i)
+    {
+      GString *record = g_ptr_array_index(records, i);
+
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+      cr_assert_eq(popped_data->len, record->len);
+      cr_assert(memcmp(popped_data->str, record->str, record->len) == 0, "record %" G_GSIZE_FORMAT " differs", i);
+    }
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+
+  g_string_free(popped_data, TRUE);
+  g_ptr_array_free(records, TRUE);
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+#endif
+
 Test(qdisk, qdisk_empty_backlog)
 {
   const gchar *filename = "test_qdisk_empty_backlog.rqf";
@@ -302,6 +457,64 @@ Test(qdisk, allow_writing_more_than_max_size_when_last_message_does_not_fit)
   cleanup_qdisk(filename, qdisk);
 }
 
+Test(qdisk, records_written_after_reading_started_are_read_back_correctly)
+{
+  const gchar *filename = "test_qdisk_read_after_write.qf";
+  QDisk *qdisk = create_qdisk(TDISKQ_NON_RELIABLE, filename, MiB(1));
+  qdisk_start(qdisk, NULL, NULL, NULL);
+  GString *popped_data = g_string_new(NULL);
+
+  /* the non-reliable queue truncates the file each time it becomes empty,
+   * so the file shrinks and grows again under the reader multiple times */
+  for (guint round = 0; round < 16; ++round)
+    {
+      guint record_len = 1000 + round * 4000;
+
+      cr_assert(push_dummy_record(qdisk, record_len));
+      cr_assert(push_dummy_record(qdisk, record_len + 1));
+
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+
+      cr_assert(push_dummy_record(qdisk, record_len + 2));
+
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len + 1);
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len + 2);
+
+      cr_assert_eq(qdisk_get_length(qdisk), 0);
+    }
+
+  g_string_free(popped_data, TRUE);
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, read_errors_of_the_memory_mapping_are_reported_instead_of_crashing)
+{
+  const gchar *filename = "test_qdisk_read_map_fault.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  qdisk_start(qdisk, NULL, NULL, NULL);
+  GString *popped_data = g_string_new(NULL);
+
+  for (gint i = 0; i < 3; ++i)
+    cr_assert(push_dummy_record(qdisk, 10000));
+
+  /* the first read maps the file */
+  cr_assert(qdisk_pop_head(qdisk, popped_data));
+  assert_dummy_record(popped_data, 10000);
+
+  /* the pages of the remaining records disappear under the mapping, reading
+   * them raises SIGBUS, just like an I/O error of the device would */
+  cr_assert_eq(truncate(filename, QDISK_RESERVED_SPACE), 0);
+  cr_assert_not(qdisk_pop_head(qdisk, popped_data));
+
+  g_string_free(popped_data, TRUE);
+  qdisk_stop(qdisk, NULL, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
 Test(qdisk, do_not_allow_diskq_to_exceed_max_size_if_last_message_fits)
 {
   const gchar *filename = "test_qdisk_do_not_exceed_max_size_when_msg_fits.rqf";
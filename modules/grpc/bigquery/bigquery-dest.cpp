@@ -22,6 +22,7 @@
 
 #include "bigquery-dest.hpp"
 #include "bigquery-worker.hpp"
+#include "bigquery-wire-format.hpp"
 
 #include "compat/cpp-start.h"
 #include "logthrdest/logthrdestdrv.h"
@@ -177,6 +178,8 @@ DestinationDriver::init()
       return false;
     }
 
+  this->compile_field_encoders();
+
   if (this->get_project().empty() || this->get_dataset().empty() || this->get_table().empty())
     {
       msg_error("Error initializing BigQuery destination, project(), dataset(), and table() are mandatory options",
@@ -323,6 +326,16 @@ DestinationDriver::load_protobuf_schema()
   return true;
 }
 
+/*
+ * Rows are encoded directly into their wire format by the workers, the
+ * tags are the same for every row, so they are calculated only once.
+ */
+void
+DestinationDriver::compile_field_encoders()
+{
+  for (auto &field : this->fields)
+    field.tag = wire_format_tag(field.field_desc);
+}
 
 /* C Wrappers */
 
@@ -39,6 +39,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstdint>
 
 namespace syslogng {
 namespace grpc {
@@ -51,11 +52,14 @@ struct Field
   LogTemplate *value;
   const google::protobuf::FieldDescriptor *field_desc;
 
+  /* wire format tag, precomputed by DestinationDriver::compile_field_encoders() */
+  uint32_t tag;
+
   Field(std::string name_, google::protobuf::FieldDescriptorProto::Type type_, LogTemplate *value_)
-    : name(name_), type(type_), value(log_template_ref(value_)), field_desc(nullptr) {}
+    : name(name_), type(type_), value(log_template_ref(value_)), field_desc(nullptr), tag(0) {}
 
   Field(const Field &a)
-    : name(a.name), type(a.type), value(log_template_ref(a.value)), field_desc(a.field_desc) {}
+    : name(a.name), type(a.type), value(log_template_ref(a.value)), field_desc(a.field_desc), tag(a.tag) {}
 
   Field &operator=(const Field &a)
   {
@@ -64,6 +68,7 @@ struct Field
     log_template_unref(value);
     value = log_template_ref(a.value);
     field_desc = a.field_desc;
+    tag = a.tag;
 
     return *this;
   }
@@ -162,6 +167,7 @@ private:
   friend class DestinationWorker;
   void construct_schema_prototype();
   bool load_protobuf_schema();
+  void compile_field_encoders();
 
 private:
   BigQueryDestDriver *super;
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "bigquery-wire-format.hpp"
+
+#include "compat/cpp-start.h"
+#include "logmsg/type-hinting.h"
+#include "compat/cpp-end.h"
+
+#include <google/protobuf/wire_format_lite.h>
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+uint32_t
+syslogng::grpc::bigquery::wire_format_tag(const FieldDescriptor *field_desc)
+{
+  WireFormatLite::FieldType field_type = (WireFormatLite::FieldType) field_desc->type();
+  return WireFormatLite::MakeTag(field_desc->number(), WireFormatLite::WireTypeForFieldType(field_type));
+}
+
+bool
+syslogng::grpc::bigquery::write_field(const FieldDescriptor *field_desc, uint32_t tag,
+                                      const char *value, std::size_t value_len,
+                                      CodedOutputStream *output, const char **failed_type)
+{
+  *failed_type = nullptr;
+
+  switch (field_desc->cpp_type())
+    {
+    /* TYPE_STRING, TYPE_BYTES (embedded nulls are possible, no null-termination is assumed) */
+    case FieldDescriptor::CppType::CPPTYPE_STRING:
+      output->WriteTag(tag);
+      output->WriteVarint32((uint32_t) value_len);
+      output->WriteRaw(value, (int) value_len);
+      return true;
+    case FieldDescriptor::CppType::CPPTYPE_INT32:
+    {
+      int32_t v;
+      if (!type_cast_to_int32(value, -1, &v, NULL))
+        {
+          *failed_type = "integer";
+          return false;
+        }
+      output->WriteTag(tag);
+      if (field_desc->type() == FieldDescriptor::TYPE_SINT32)
+        WireFormatLite::WriteSInt32NoTag(v, output);
+      else if (field_desc->type() == FieldDescriptor::TYPE_SFIXED32)
+        WireFormatLite::WriteSFixed32NoTag(v, output);
+      else
+        WireFormatLite::WriteInt32NoTag(v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_INT64:
+    {
+      int64_t v;
+      if (!type_cast_to_int64(value, -1, &v, NULL))
+        {
+          *failed_type = "integer";
+          return false;
+        }
+      output->WriteTag(tag);
+      if (field_desc->type() == FieldDescriptor::TYPE_SINT64)
+        WireFormatLite::WriteSInt64NoTag(v, output);
+      else if (field_desc->type() == FieldDescriptor::TYPE_SFIXED64)
+        WireFormatLite::WriteSFixed64NoTag(v, output);
+      else
+        WireFormatLite::WriteInt64NoTag(v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_UINT32:
+    {
+      int64_t v;
+      if (!type_cast_to_int64(value, -1, &v, NULL))
+        {
+          *failed_type = "integer";
+          return false;
+        }
+      output->WriteTag(tag);
+      if (field_desc->type() == FieldDescriptor::TYPE_FIXED32)
+        WireFormatLite::WriteFixed32NoTag((uint32_t) v, output);
+      else
+        WireFormatLite::WriteUInt32NoTag((uint32_t) v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_UINT64:
+    {
+      int64_t v;
+      if (!type_cast_to_int64(value, -1, &v, NULL))
+        {
+          *failed_type = "integer";
+          return false;
+        }
+      output->WriteTag(tag);
+      if (field_desc->type() == FieldDescriptor::TYPE_FIXED64)
+        WireFormatLite::WriteFixed64NoTag((uint64_t) v, output);
+      else
+        WireFormatLite::WriteUInt64NoTag((uint64_t) v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
+    {
+      double v;
+      if (!type_cast_to_double(value, -1, &v, NULL))
+        {
+          *failed_type = "double";
+          return false;
+        }
+      output->WriteTag(tag);
+      WireFormatLite::WriteDoubleNoTag(v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_FLOAT:
+    {
+      double v;
+      if (!type_cast_to_double(value, -1, &v, NULL))
+        {
+          *failed_type = "double";
+          return false;
+        }
+      output->WriteTag(tag);
+      WireFormatLite::WriteFloatNoTag((float) v, output);
+      return true;
+    }
+    case FieldDescriptor::CppType::CPPTYPE_BOOL:
+    {
+      gboolean v;
+      if (!type_cast_to_boolean(value, -1, &v, NULL))
+        {
+          *failed_type = "boolean";
+          return false;
+        }
+      output->WriteTag(tag);
+      WireFormatLite::WriteBoolNoTag(v, output);
+      return true;
+    }
+    default:
+      return false;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef BIGQUERY_WIRE_FORMAT_HPP
+#define BIGQUERY_WIRE_FORMAT_HPP
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace syslogng {
+namespace grpc {
+namespace bigquery {
+
+/* the wire format tag of a field, it is the same for every row */
+uint32_t wire_format_tag(const google::protobuf::FieldDescriptor *field_desc);
+
+/*
+ * Converts the textual @value to the type of @field_desc, and appends it
+ * with @tag to @output, the same way Message::Serialize() would encode it.
+ *
+ * Returns false if @value cannot be converted, nothing is written in that
+ * case.  @failed_type is set to the name of the expected type, or NULL if
+ * the field type is not supported at all.
+ */
+bool write_field(const google::protobuf::FieldDescriptor *field_desc, uint32_t tag,
+                 const char *value, std::size_t value_len,
+                 google::protobuf::io::CodedOutputStream *output, const char **failed_type);
+
+}
+}
+}
+
+#endif
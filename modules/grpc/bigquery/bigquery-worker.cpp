@@ -23,6 +23,7 @@
 
 #include "bigquery-worker.hpp"
 #include "bigquery-dest.hpp"
+#include "bigquery-wire-format.hpp"
 
 #include "compat/cpp-start.h"
 #include "logthrdest/logthrdestdrv.h"
@@ -39,10 +40,11 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 #include <google/protobuf/compiler/importer.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 using syslogng::grpc::bigquery::DestinationWorker;
 using syslogng::grpc::bigquery::DestinationDriver;
-using google::protobuf::FieldDescriptor;
+using syslogng::grpc::bigquery::write_field;
 
 struct _BigQueryDestWorker
 {
@@ -135,14 +137,25 @@ DestinationWorker::prepare_batch()
 {
   this->batch_size = 0;
   this->current_batch_bytes = 0;
-  this->current_batch = google::cloud::bigquery::storage::v1::AppendRowsRequest{};
 
   this->current_batch.set_write_stream(write_stream.name());
   this->current_batch.set_trace_id("syslog-ng-bigquery");
   google::cloud::bigquery::storage::v1::AppendRowsRequest_ProtoData *proto_rows =
     this->current_batch.mutable_proto_rows();
-  google::cloud::bigquery::storage::v1::ProtoSchema *schema = proto_rows->mutable_writer_schema();
-  this->get_owner()->schema_descriptor->CopyTo(schema->mutable_proto_descriptor());
+
+  /*
+   * Only the rows are cleared, the request itself is not: Clear() would
+   * delete the proto_rows oneof, and with it the row strings.  The cleared
+   * elements of a repeated field are kept, add_serialized_rows() hands them
+   * out again along with their capacity.
+   */
+  proto_rows->mutable_rows()->clear_serialized_rows();
+
+  if (!proto_rows->has_writer_schema())
+    {
+      google::cloud::bigquery::storage::v1::ProtoSchema *schema = proto_rows->mutable_writer_schema();
+      this->get_owner()->schema_descriptor->CopyTo(schema->mutable_proto_descriptor());
+    }
 }
 
 bool
@@ -172,9 +185,12 @@ DestinationWorker::format_template(LogTemplate *tmpl, LogMessage *msg, GString *
   return Slice{value->str, value->len};
 }
 
+/*
+ * Appends the field to the row in protobuf wire format, the same way
+ * Message::Serialize() would, without going through a DynamicMessage.
+ */
 bool
-DestinationWorker::insert_field(const google::protobuf::Reflection *reflection, const Field &field,
-                                LogMessage *msg, google::protobuf::Message *message)
+DestinationWorker::insert_field(const Field &field, LogMessage *msg, google::protobuf::io::CodedOutputStream *row)
 {
   DestinationDriver *owner = this->get_owner();
 
@@ -182,6 +198,7 @@ DestinationWorker::insert_field(const google::protobuf::Reflection *reflection,
   GString *buf = scratch_buffers_alloc_and_mark(&m);
 
   LogMessageValueType type;
+  const char *failed_type;
 
   Slice value = this->format_template(field.value, msg, buf, &type);
 
@@ -197,90 +214,10 @@ DestinationWorker::insert_field(const google::protobuf::Reflection *reflection,
       return true;
     }
 
-  switch (field.field_desc->cpp_type())
-    {
-    /* TYPE_STRING, TYPE_BYTES (embedded nulls are possible, no null-termination is assumed) */
-    case FieldDescriptor::CppType::CPPTYPE_STRING:
-      reflection->SetString(message, field.field_desc, std::string{value.str, value.len});
-      break;
-    case FieldDescriptor::CppType::CPPTYPE_INT32:
-    {
-      int32_t v;
-      if (!type_cast_to_int32(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "integer");
-          goto error;
-        }
-      reflection->SetInt32(message, field.field_desc, v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_INT64:
-    {
-      int64_t v;
-      if (!type_cast_to_int64(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "integer");
-          goto error;
-        }
-      reflection->SetInt64(message, field.field_desc, v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_UINT32:
-    {
-      int64_t v;
-      if (!type_cast_to_int64(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "integer");
-          goto error;
-        }
-      reflection->SetUInt32(message, field.field_desc, (uint32_t) v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_UINT64:
-    {
-      int64_t v;
-      if (!type_cast_to_int64(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "integer");
-          goto error;
-        }
-      reflection->SetUInt64(message, field.field_desc, (uint64_t) v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_DOUBLE:
-    {
-      double v;
-      if (!type_cast_to_double(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "double");
-          goto error;
-        }
-      reflection->SetDouble(message, field.field_desc, v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_FLOAT:
+  if (!write_field(field.field_desc, field.tag, value.str, value.len, row, &failed_type))
     {
-      double v;
-      if (!type_cast_to_double(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "double");
-          goto error;
-        }
-      reflection->SetFloat(message, field.field_desc, (float) v);
-      break;
-    }
-    case FieldDescriptor::CppType::CPPTYPE_BOOL:
-    {
-      gboolean v;
-      if (!type_cast_to_boolean(value.str, -1, &v, NULL))
-        {
-          type_cast_drop_helper(owner->template_options.on_error, value.str, -1, "boolean");
-          goto error;
-        }
-      reflection->SetBool(message, field.field_desc, v);
-      break;
-    }
-    default:
+      if (failed_type)
+        type_cast_drop_helper(owner->template_options.on_error, value.str, -1, failed_type);
       goto error;
     }
 
@@ -296,52 +233,56 @@ LogThreadedResult
 DestinationWorker::insert(LogMessage *msg)
 {
   DestinationDriver *owner = this->get_owner();
-  std::string serialized_row;
   size_t row_bytes = 0;
 
   google::cloud::bigquery::storage::v1::ProtoRows *rows = this->current_batch.mutable_proto_rows()->mutable_rows();
 
-  google::protobuf::Message *message = owner->schema_prototype->New();
-  const google::protobuf::Reflection *reflection = message->GetReflection();
+  /* cleared rows of previous batches are reused, along with their capacity */
+  std::string *serialized_row = rows->add_serialized_rows();
 
   bool msg_has_field = false;
-  for (const auto &field : owner->fields)
-    {
-      bool field_inserted = this->insert_field(reflection, field, msg, message);
-      msg_has_field |= field_inserted;
-
-      if (!field_inserted && (owner->template_options.on_error & ON_ERROR_DROP_MESSAGE))
-        goto drop;
-    }
-
-  if (!msg_has_field)
+  bool drop_msg = false;
+  {
+    google::protobuf::io::StringOutputStream row_stream(serialized_row);
+    google::protobuf::io::CodedOutputStream row(&row_stream);
+
+    for (const auto &field : owner->fields)
+      {
+        bool field_inserted = this->insert_field(field, msg, &row);
+        msg_has_field |= field_inserted;
+
+        if (!field_inserted && (owner->template_options.on_error & ON_ERROR_DROP_MESSAGE))
+          {
+            drop_msg = true;
+            break;
+          }
+      }
+  }
+
+  if (drop_msg || !msg_has_field)
     goto drop;
 
   this->batch_size++;
 
-  message->SerializePartialToString(&serialized_row);
-  row_bytes = serialized_row.size();
-  rows->add_serialized_rows(std::move(serialized_row));
+  row_bytes = serialized_row->size();
 
   this->current_batch_bytes += row_bytes;
   log_threaded_dest_driver_insert_msg_length_stats(this->super->super.owner, row_bytes);
 
   msg_trace("Message added to BigQuery batch", log_pipe_location_tag((LogPipe *) this->super->super.owner));
 
-  delete message;
-
   if (this->should_initiate_flush())
     return log_threaded_dest_worker_flush(&this->super->super, LTF_FLUSH_NORMAL);
 
   return LTR_QUEUED;
 
 drop:
+  rows->mutable_serialized_rows()->RemoveLast();
   if (!(owner->template_options.on_error & ON_ERROR_SILENT))
     {
       msg_error("Failed to format message for BigQuery, dropping message",
                 log_pipe_location_tag((LogPipe *) this->super->super.owner));
     }
-  delete message;
 
   /* LTR_DROP currently drops the entire batch */
   return LTR_QUEUED;
@@ -32,7 +32,7 @@
 
 #include <grpcpp/create_channel.h>
 #include <google/protobuf/descriptor.h>
-#include <google/protobuf/message.h>
+#include <google/protobuf/io/coded_stream.h>
 
 #include <string>
 #include <memory>
@@ -69,8 +69,7 @@ private:
   void construct_write_stream();
   void prepare_batch();
   bool should_initiate_flush();
-  bool insert_field(const google::protobuf::Reflection *reflection, const Field &field,
-                    LogMessage *msg, google::protobuf::Message *message);
+  bool insert_field(const Field &field, LogMessage *msg, google::protobuf::io::CodedOutputStream *row);
   LogThreadedResult handle_row_errors(const google::cloud::bigquery::storage::v1::AppendRowsResponse &response);
   Slice format_template(LogTemplate *tmpl, LogMessage *msg, GString *value, LogMessageValueType *type);
   DestinationDriver *get_owner();
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published
+ * by the Free Software Foundation, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "bigquery-wire-format.hpp"
+
+#include "compat/cpp-start.h"
+#include "apphook.h"
+#include "compat/cpp-end.h"
+
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <criterion/criterion.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace syslogng::grpc::bigquery;
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+struct TestField
+{
+  const char *name;
+  FieldDescriptorProto::Type type;
+  std::string value;
+};
+
+/* every type the encoder supports, with values that exercise the
+ * sign handling of each integer encoding */
+static const std::vector<TestField> test_fields =
+{
+  {"string_field", FieldDescriptorProto::TYPE_STRING, "hello world"},
+  {"bytes_field", FieldDescriptorProto::TYPE_BYTES, std::string("bin\0ary", 7)},
+  {"int32_field", FieldDescriptorProto::TYPE_INT32, "-42"},
+  {"sint32_field", FieldDescriptorProto::TYPE_SINT32, "-42"},
+  {"sfixed32_field", FieldDescriptorProto::TYPE_SFIXED32, "-42"},
+  {"int64_field", FieldDescriptorProto::TYPE_INT64, "-1234567890123"},
+  {"sint64_field", FieldDescriptorProto::TYPE_SINT64, "-1234567890123"},
+  {"sfixed64_field", FieldDescriptorProto::TYPE_SFIXED64, "-1234567890123"},
+  {"uint32_field", FieldDescriptorProto::TYPE_UINT32, "4000000000"},
+  {"fixed32_field", FieldDescriptorProto::TYPE_FIXED32, "4000000000"},
+  {"uint64_field", FieldDescriptorProto::TYPE_UINT64, "1234567890123"},
+  {"fixed64_field", FieldDescriptorProto::TYPE_FIXED64, "1234567890123"},
+  {"double_field", FieldDescriptorProto::TYPE_DOUBLE, "-3.25"},
+  {"float_field", FieldDescriptorProto::TYPE_FLOAT, "1.5"},
+  {"bool_field", FieldDescriptorProto::TYPE_BOOL, "true"},
+};
+
+static const Descriptor *
+_build_schema(DescriptorPool &pool)
+{
+  FileDescriptorProto file;
+  file.set_name("test_bigquery_wire_format.proto");
+  file.set_syntax("proto2");
+
+  google::protobuf::DescriptorProto *message = file.add_message_type();
+  message->set_name("TestRow");
+
+  int number = 1;
+  for (const auto &test_field : test_fields)
+    {
+      FieldDescriptorProto *field = message->add_field();
+      field->set_name(test_field.name);
+      field->set_number(number++);
+      field->set_type(test_field.type);
+      field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    }
+
+  const google::protobuf::FileDescriptor *file_desc = pool.BuildFile(file);
+  cr_assert(file_desc);
+  return file_desc->message_type(0);
+}
+
+/* the row as the encoder writes it */
+static std::string
+_encode_row(const Descriptor *schema)
+{
+  std::string row;
+  {
+    google::protobuf::io::StringOutputStream row_stream(&row);
+    google::protobuf::io::CodedOutputStream output(&row_stream);
+
+    for (const auto &test_field : test_fields)
+      {
+        const FieldDescriptor *field_desc = schema->FindFieldByName(test_field.name);
+        const char *failed_type;
+
+        cr_assert(write_field(field_desc, wire_format_tag(field_desc), test_field.value.c_str(),
+                              test_field.value.length(), &output, &failed_type),
+                  "failed to encode %s", test_field.name);
+      }
+  }
+  return row;
+}
+
+/* the same row, set through Reflection and serialized by protobuf itself */
+static void
+_fill_reference_row(Message *row)
+{
+  const Reflection *reflection = row->GetReflection();
+  const Descriptor *schema = row->GetDescriptor();
+
+  reflection->SetString(row, schema->FindFieldByName("string_field"), "hello world");
+  reflection->SetString(row, schema->FindFieldByName("bytes_field"), std::string("bin\0ary", 7));
+  reflection->SetInt32(row, schema->FindFieldByName("int32_field"), -42);
+  reflection->SetInt32(row, schema->FindFieldByName("sint32_field"), -42);
+  reflection->SetInt32(row, schema->FindFieldByName("sfixed32_field"), -42);
+  reflection->SetInt64(row, schema->FindFieldByName("int64_field"), -1234567890123);
+  reflection->SetInt64(row, schema->FindFieldByName("sint64_field"), -1234567890123);
+  reflection->SetInt64(row, schema->FindFieldByName("sfixed64_field"), -1234567890123);
+  reflection->SetUInt32(row, schema->FindFieldByName("uint32_field"), 4000000000U);
+  reflection->SetUInt32(row, schema->FindFieldByName("fixed32_field"), 4000000000U);
+  reflection->SetUInt64(row, schema->FindFieldByName("uint64_field"), 1234567890123U);
+  reflection->SetUInt64(row, schema->FindFieldByName("fixed64_field"), 1234567890123U);
+  reflection->SetDouble(row, schema->FindFieldByName("double_field"), -3.25);
+  reflection->SetFloat(row, schema->FindFieldByName("float_field"), 1.5f);
+  reflection->SetBool(row, schema->FindFieldByName("bool_field"), true);
+}
+
+Test(bigquery_wire_format, encoded_row_matches_the_dynamic_message_serialization)
+{
+  DescriptorPool pool;
+  const Descriptor *schema = _build_schema(pool);
+  DynamicMessageFactory factory;
+  const Message *prototype = factory.GetPrototype(schema);
+
+  std::unique_ptr<Message> reference_row(prototype->New());
+  _fill_reference_row(reference_row.get());
+  std::string reference;
+  cr_assert(reference_row->SerializePartialToString(&reference));
+
+  std::string encoded = _encode_row(schema);
+  cr_assert(encoded == reference, "the encoded row differs from the one serialized by protobuf");
+
+  std::unique_ptr<Message> decoded_row(prototype->New());
+  cr_assert(decoded_row->ParseFromString(encoded));
+
+  for (int i = 0; i < schema->field_count(); i++)
+    {
+      const FieldDescriptor *field_desc = schema->field(i);
+      cr_assert(decoded_row->GetReflection()->HasField(*decoded_row, field_desc), "%s is missing",
+                field_desc->name().c_str());
+    }
+
+  std::string decoded_text = decoded_row->DebugString();
+  std::string reference_text = reference_row->DebugString();
+  cr_assert_str_eq(decoded_text.c_str(), reference_text.c_str());
+}
+
+Test(bigquery_wire_format, values_that_do_not_match_the_field_type_are_not_written)
+{
+  DescriptorPool pool;
+  const Descriptor *schema = _build_schema(pool);
+
+  std::string row;
+  {
+    google::protobuf::io::StringOutputStream row_stream(&row);
+    google::protobuf::io::CodedOutputStream output(&row_stream);
+    const char *failed_type;
+
+    const FieldDescriptor *int_field = schema->FindFieldByName("sint64_field");
+    cr_assert_not(write_field(int_field, wire_format_tag(int_field), "not-a-number", 12, &output, &failed_type));
+    cr_assert_str_eq(failed_type, "integer");
+
+    const FieldDescriptor *float_field = schema->FindFieldByName("float_field");
+    cr_assert_not(write_field(float_field, wire_format_tag(float_field), "abc", 3, &output, &failed_type));
+    cr_assert_str_eq(failed_type, "double");
+
+    const FieldDescriptor *bool_field = schema->FindFieldByName("bool_field");
+    cr_assert_not(write_field(bool_field, wire_format_tag(bool_field), "maybe", 5, &output, &failed_type));
+    cr_assert_str_eq(failed_type, "boolean");
+  }
+
+  cr_assert(row.empty());
+}
+
+TestSuite(bigquery_wire_format, .init = app_startup, .fini = app_shutdown);
@@ -280,7 +280,5 @@ loki_dd_new(GlobalConfig *cfg)
 
   self->super.worker.construct = loki_dw_new;
 
-  self->super.flush_on_key_change = TRUE;
-
   return &self->super.super.super;
 }
@@ -34,6 +34,7 @@
 #include "push.grpc.pb.h"
 
 #include <string>
+#include <cstring>
 #include <sstream>
 #include <chrono>
 #include <sys/time.h>
@@ -47,6 +48,8 @@ using syslogng::grpc::loki::DestinationWorker;
 using syslogng::grpc::loki::DestinationDriver;
 using google::protobuf::FieldDescriptor;
 
+#define LOKI_LABEL_CACHE_MAX 10000
+
 struct _LokiDestWorker
 {
   LogThreadedDestWorker super;
@@ -132,42 +135,82 @@ void
 DestinationWorker::prepare_batch()
 {
   this->current_batch = logproto::PushRequest{};
-  this->current_batch.add_streams();
+  this->batch_streams.clear();
 }
 
+/*
+ * Renders the label values of msg, each terminated by a NUL character.
+ * Values are escaped, so they can't contain NUL themselves.
+ */
 void
-DestinationWorker::set_labels(LogMessage *msg)
+DestinationWorker::format_label_values(LogMessage *msg, std::string &label_values)
 {
   DestinationDriver *owner = this->get_owner();
-  logproto::StreamAdapter *stream = this->current_batch.mutable_streams(0);
 
   LogTemplateEvalOptions options = {&owner->template_options, LTZ_SEND, this->super->super.seq_num, NULL, LM_VT_STRING};
 
   ScratchBuffersMarker m;
   GString *buf = scratch_buffers_alloc_and_mark(&m);
-  GString *sanitized_value = scratch_buffers_alloc();
+  GString *sanitized_values = scratch_buffers_alloc();
+
+  for (const auto &label : owner->labels)
+    {
+      log_template_format(label.value, msg, &options, buf);
+      append_unsafe_utf8_as_escaped_binary(sanitized_values, buf->str, -1, "\"");
+      g_string_append_c(sanitized_values, '\0');
+    }
+
+  label_values.assign(sanitized_values->str, sanitized_values->len);
+  scratch_buffers_reclaim_marked(m);
+}
+
+const std::string &
+DestinationWorker::lookup_labels(const std::string &label_values)
+{
+  auto cached = this->label_cache.find(label_values);
+  if (cached != this->label_cache.end())
+    return cached->second;
+
+  /* high cardinality labels would make the cache grow without bounds */
+  if (this->label_cache.size() >= LOKI_LABEL_CACHE_MAX)
+    this->label_cache.clear();
 
+  DestinationDriver *owner = this->get_owner();
   std::stringstream formatted_labels;
   bool comma_needed = false;
+  const char *value = label_values.c_str();
+
   formatted_labels << "{";
   for (const auto &label : owner->labels)
     {
       if (comma_needed)
         formatted_labels << ", ";
 
-      log_template_format(label.value, msg, &options, buf);
-
-      g_string_truncate(sanitized_value, 0);
-      append_unsafe_utf8_as_escaped_binary(sanitized_value, buf->str, -1, "\"");
-
-      formatted_labels << label.name << "=\"" << sanitized_value->str << "\"";
+      formatted_labels << label.name << "=\"" << value << "\"";
+      value += strlen(value) + 1;
 
       comma_needed = true;
     }
   formatted_labels << "}";
-  stream->set_labels(formatted_labels.str());
 
-  scratch_buffers_reclaim_marked(m);
+  return this->label_cache.emplace(label_values, formatted_labels.str()).first->second;
+}
+
+logproto::StreamAdapter *
+DestinationWorker::lookup_stream(LogMessage *msg)
+{
+  std::string label_values;
+  this->format_label_values(msg, label_values);
+
+  auto it = this->batch_streams.find(label_values);
+  if (it != this->batch_streams.end())
+    return this->current_batch.mutable_streams(it->second);
+
+  logproto::StreamAdapter *stream = this->current_batch.add_streams();
+  stream->set_labels(this->lookup_labels(label_values));
+  this->batch_streams.emplace(std::move(label_values), this->current_batch.streams_size() - 1);
+
+  return stream;
 }
 
 void
@@ -190,10 +233,7 @@ LogThreadedResult
 DestinationWorker::insert(LogMessage *msg)
 {
   DestinationDriver *owner = this->get_owner();
-  logproto::StreamAdapter *stream = this->current_batch.mutable_streams(0);
-
-  if (stream->entries_size() == 0)
-    this->set_labels(msg);
+  logproto::StreamAdapter *stream = this->lookup_stream(msg);
 
   logproto::EntryAdapter *entry = stream->add_entries();
 
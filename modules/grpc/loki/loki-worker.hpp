@@ -34,6 +34,7 @@
 
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 #include "push.grpc.pb.h"
 
@@ -56,7 +57,9 @@ public:
 
 private:
   void prepare_batch();
-  void set_labels(LogMessage *msg);
+  void format_label_values(LogMessage *msg, std::string &label_values);
+  const std::string &lookup_labels(const std::string &label_values);
+  logproto::StreamAdapter *lookup_stream(LogMessage *msg);
   void set_timestamp(logproto::EntryAdapter *entry, LogMessage *msg);
   DestinationDriver *get_owner();
 
@@ -68,6 +71,12 @@ private:
   std::shared_ptr<::grpc::Channel> channel;
   std::unique_ptr<logproto::Pusher::Stub> stub;
   logproto::PushRequest current_batch;
+
+  /* rendered label values -> index of their stream in current_batch */
+  std::unordered_map<std::string, int> batch_streams;
+
+  /* rendered label values -> formatted label set, kept across batches */
+  std::unordered_map<std::string, std::string> label_cache;
 };
 
 }
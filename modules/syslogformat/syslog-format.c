@@ -523,6 +523,9 @@ _syslog_format_parse_hostname(LogMessage *msg, const guchar **data, gint *length
  * Parse an http://www.syslog.cc/ietf/drafts/draft-ietf-syslog-protocol-23.txt formatted log
  * message for structured data elements and store the parsed information
  * in @msg.values and dup the SD string. Parsing is affected by the bits set @flags argument.
+ *
+ * If @msg is NULL, the SD string is only validated and skipped, without
+ * storing anything.
  **/
 gboolean
 _syslog_format_parse_sd(LogMessage *msg, const guchar **data, gint *length, const MsgFormatOptions *options)
@@ -609,7 +612,8 @@ _syslog_format_parse_sd(LogMessage *msg, const guchar **data, gint *length, cons
 
           if (left && *src == ']')
             {
-              log_msg_set_value_by_name(msg, sd_value_name, "", 0);
+              if (msg)
+                log_msg_set_value_by_name(msg, sd_value_name, "", 0);
             }
           else
             {
@@ -732,7 +736,8 @@ _syslog_format_parse_sd(LogMessage *msg, const guchar **data, gint *length, cons
                   goto error;
                 }
 
-              log_msg_set_value_by_name(msg, sd_value_name, sd_param_value, sd_param_value_len);
+              if (msg)
+                log_msg_set_value_by_name(msg, sd_value_name, sd_param_value, sd_param_value_len);
             }
 
           if (left && *src == ']')
@@ -771,6 +776,41 @@ error:
   return ret;
 }
 
+/* defaults as enforced by msg_format_options_init() for flags(lazy-sdata) */
+static MsgFormatOptions lazy_sdata_options =
+{
+  .sdata_prefix = (gchar *) logmsg_sd_prefix,
+  .sdata_param_value_max = MSG_FORMAT_SDATA_PARAM_VALUE_MAX_DEFAULT,
+};
+
+static void
+_syslog_format_decode_lazy_sd(LogMessage *msg, const gchar *raw_sdata, gsize raw_sdata_len)
+{
+  const guchar *src = (const guchar *) raw_sdata;
+  gint left = raw_sdata_len;
+
+  /* the block was validated when the message was received */
+  _syslog_format_parse_sd(msg, &src, &left, &lazy_sdata_options);
+}
+
+/*
+ * flags(lazy-sdata): the SD block is validated (so that malformed messages
+ * are still rejected at the source) and stored verbatim.  Unescaping it
+ * into individual name-value pairs is postponed until an SDATA value is
+ * first accessed, see log_msg_set_lazy_sdata().
+ */
+static gboolean
+_syslog_format_parse_lazy_sd(LogMessage *msg, const guchar **data, gint *length, const MsgFormatOptions *options)
+{
+  const guchar *sdata_start = *data;
+
+  if (!_syslog_format_parse_sd(NULL, data, length, options))
+    return FALSE;
+
+  log_msg_set_lazy_sdata(msg, (const gchar *) sdata_start, *data - sdata_start);
+  return TRUE;
+}
+
 gboolean
 _syslog_format_parse_sd_column(LogMessage *msg, const guchar **data, gint *length, const MsgFormatOptions *options)
 {
@@ -778,6 +818,8 @@ _syslog_format_parse_sd_column(LogMessage *msg, const guchar **data, gint *lengt
     return TRUE;
 
   guchar first_char = (*data)[0];
+  if (first_char == '[' && (options->flags & LP_LAZY_SDATA))
+    return _syslog_format_parse_lazy_sd(msg, data, length, options);
   if (first_char == '-' || first_char == '[')
     return _syslog_format_parse_sd(msg, data, length, options);
 
@@ -1120,6 +1162,8 @@ syslog_format_init(void)
     {
       handles.is_synced = log_msg_get_value_handle(".SDATA.timeQuality.isSynced");
       handles.cisco_seqid = log_msg_get_value_handle(".SDATA.meta.sequenceId");
+      lazy_sdata_options.sdata_prefix_len = logmsg_sd_prefix_len;
+      log_msg_register_sdata_decoder(_syslog_format_decode_lazy_sd);
       handles.initialized = TRUE;
     }
 
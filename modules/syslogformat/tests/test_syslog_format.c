@@ -295,3 +295,73 @@ Test(syslog_format, test_long_sdata)
   strcpy(long_sdata + 1 + long_sdata_id, " a=b]");
   cr_expect_not(_extract_sdata_into_message_with_prefix(long_sdata, NULL, sdata_prefix));
 }
+
+static LogMessage *
+_parse_syslog_proto_with_lazy_sdata(const gchar *data)
+{
+  gsize data_length = strlen(data);
+
+  parse_options.flags |= LP_SYSLOG_PROTOCOL | LP_LAZY_SDATA;
+  msg_format_options_init(&parse_options, cfg);
+  LogMessage *msg = msg_format_construct_message(&parse_options, (const guchar *) data, data_length);
+
+  gsize problem_position;
+  cr_assert(syslog_format_handler(&parse_options, msg, (const guchar *) data, data_length, &problem_position));
+  msg_format_options_destroy(&parse_options);
+  return msg;
+}
+
+Test(syslog_format, lazy_sdata_is_decoded_when_first_accessed)
+{
+  LogMessage *msg = _parse_syslog_proto_with_lazy_sdata("<165>1 2003-10-11T22:14:15.003Z host prg 1 ID47 "
+                                                        "[foo bar=\"b\\]az\"][chew peek=\"poke\"] message");
+
+  cr_assert(msg->flags & LF_STATE_LAZY_SDATA);
+  assert_log_message_value_by_name(msg, "PROGRAM", "prg");
+  assert_log_message_value_by_name(msg, "MSG", "message");
+  cr_assert(msg->flags & LF_STATE_LAZY_SDATA);
+
+  assert_log_message_value_by_name(msg, ".SDATA.foo.bar", "b]az");
+  cr_assert_not(msg->flags & LF_STATE_LAZY_SDATA);
+  assert_log_message_value_by_name(msg, ".SDATA.chew.peek", "poke");
+  assert_log_message_value_by_name(msg, "SDATA", "[foo bar=\"b\\]az\"][chew peek=\"poke\"]");
+  log_msg_unref(msg);
+}
+
+Test(syslog_format, lazy_sdata_is_decoded_before_updating_sdata_values)
+{
+  LogMessage *msg = _parse_syslog_proto_with_lazy_sdata("<165>1 2003-10-11T22:14:15.003Z host prg 1 ID47 "
+                                                        "[foo bar=\"baz\"] message");
+
+  log_msg_set_value_by_name(msg, ".SDATA.foo.bar", "overridden", -1);
+  assert_log_message_value_by_name(msg, ".SDATA.foo.bar", "overridden");
+  assert_log_message_value_by_name(msg, "SDATA", "[foo bar=\"overridden\"]");
+  log_msg_unref(msg);
+}
+
+Test(syslog_format, lazy_sdata_is_decoded_when_the_message_is_write_protected)
+{
+  LogMessage *msg = _parse_syslog_proto_with_lazy_sdata("<165>1 2003-10-11T22:14:15.003Z host prg 1 ID47 "
+                                                        "[foo bar=\"baz\"] message");
+
+  log_msg_write_protect(msg);
+  cr_assert_not(msg->flags & LF_STATE_LAZY_SDATA);
+  assert_log_message_value_by_name(msg, ".SDATA.foo.bar", "baz");
+  log_msg_unref(msg);
+}
+
+Test(syslog_format, lazy_sdata_still_rejects_invalid_sdata)
+{
+  const gchar *data = "<165>1 2003-10-11T22:14:15.003Z host prg 1 ID47 [foo bar=\"baz\" message";
+  gsize data_length = strlen(data);
+
+  parse_options.flags |= LP_SYSLOG_PROTOCOL | LP_LAZY_SDATA | LP_NO_RFC3164_FALLBACK;
+  msg_format_options_init(&parse_options, cfg);
+  LogMessage *msg = msg_format_construct_message(&parse_options, (const guchar *) data, data_length);
+
+  gsize problem_position;
+  cr_assert_not(syslog_format_handler(&parse_options, msg, (const guchar *) data, data_length, &problem_position));
+
+  msg_format_options_destroy(&parse_options);
+  log_msg_unref(msg);
+}
@@ -27,12 +27,14 @@
 static gboolean config_options_preprocessed = FALSE;
 static gboolean config_options_verify = FALSE;
 static gboolean config_options_id = FALSE;
+static gboolean config_options_timings = FALSE;
 
 GOptionEntry config_options[] =
 {
   { "preprocessed", 'p', 0, G_OPTION_ARG_NONE, &config_options_preprocessed, "preprocessed", NULL },
   { "verify", 'v', 0, G_OPTION_ARG_NONE, &config_options_verify, "verify", NULL },
   { "id", 'i', 0, G_OPTION_ARG_NONE, &config_options_id, "Get config identifier", NULL },
+  { "timings", 't', 0, G_OPTION_ARG_NONE, &config_options_timings, "Show the duration of the last startup/reload phases in seconds", NULL },
   { NULL,           0,   0, G_OPTION_ARG_NONE, NULL,                         NULL,           NULL }
 };
 
@@ -45,6 +47,8 @@ slng_config(int argc, char *argv[], const gchar *mode, GOptionContext *ctx)
     g_string_append(cmd, "ID");
   else if (config_options_verify)
     g_string_append(cmd, "VERIFY ");
+  else if (config_options_timings)
+    g_string_append(cmd, "TIMINGS");
   else
     {
       g_string_append(cmd, "GET ");
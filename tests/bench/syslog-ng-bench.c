@@ -0,0 +1,678 @@
+/*
+ * Copyright (c) 2024 One Identity
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+/*
+ * syslog-ng-bench: in-process pipeline benchmark
+ *
+ * A scenario file describes a linear pipeline (parsers, rewrites, filters,
+ * an optional queue and an output template). Messages are injected through
+ * a fake transport (msg_format_parse() on raw lines, exactly as a source
+ * driver would do) and consumed by a null destination that measures the
+ * end-to-end latency from LM_TS_RECVD to the point of writing.
+ *
+ * Each stage is wrapped by a probe LogPipe that accounts the thread CPU
+ * time spent in that stage, so the report can show where time goes.
+ *
+ * With a backlog, the queue is only drained once it holds that many
+ * messages, the growth of the resident set size by then is reported as the
+ * memory cost of a queued message.
+ */
+
+#include "syslog-ng.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "cfg-lexer.h"
+#include "cfg-parser.h"
+#include "plugin.h"
+#include "logpipe.h"
+#include "logqueue.h"
+#include "logqueue-fifo.h"
+#include "msg-format.h"
+#include "filter/filter-expr.h"
+#include "filter/filter-expr-parser.h"
+#include "filter/filter-pipe.h"
+#include "template/templates.h"
+#include "timeutils/cache.h"
+#include "reloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_LATENCY_SAMPLES (1024 * 1024)
+
+static gchar *scenario_file;
+static gchar *input_file;
+static gchar *module_path;
+static gint64 message_count = 100000;
+
+static GOptionEntry bench_options[] =
+{
+  { "scenario", 's', 0, G_OPTION_ARG_FILENAME, &scenario_file, "Scenario file describing the pipeline", "<file>" },
+  { "messages", 'n', 0, G_OPTION_ARG_INT64, &message_count, "Number of messages to inject (default: 100000)", "<count>" },
+  { "input", 'i', 0, G_OPTION_ARG_FILENAME, &input_file, "Replay recorded messages from this file, one per line", "<file>" },
+  { "module-path", 0, 0, G_OPTION_ARG_STRING, &module_path, "Set the module search path", "<path>" },
+  { NULL }
+};
+
+static inline guint64
+_thread_cpu_nsec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+static inline gint64
+_realtime_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static gint64
+_resident_set_bytes(void)
+{
+  FILE *statm = fopen("/proc/self/statm", "r");
+  long size, resident = 0;
+
+  if (!statm)
+    return 0;
+  if (fscanf(statm, "%ld %ld", &size, &resident) != 2)
+    resident = 0;
+  fclose(statm);
+  return (gint64) resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Probe: measures the CPU time of everything downstream of it */
+
+typedef struct _BenchProbe
+{
+  LogPipe super;
+  gchar *name;
+  guint64 messages;
+  guint64 cpu_nsec;
+} BenchProbe;
+
+static void
+bench_probe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  BenchProbe *self = (BenchProbe *) s;
+  guint64 start = _thread_cpu_nsec();
+
+  self->messages++;
+  log_pipe_forward_msg(s, msg, path_options);
+  self->cpu_nsec += _thread_cpu_nsec() - start;
+}
+
+static void
+bench_probe_free(LogPipe *s)
+{
+  BenchProbe *self = (BenchProbe *) s;
+
+  g_free(self->name);
+  log_pipe_free_method(s);
+}
+
+static BenchProbe *
+bench_probe_new(GlobalConfig *cfg, const gchar *name)
+{
+  BenchProbe *self = g_new0(BenchProbe, 1);
+
+  log_pipe_init_instance(&self->super, cfg);
+  self->super.queue = bench_probe_queue;
+  self->super.free_fn = bench_probe_free;
+  self->name = g_strdup(name);
+  return self;
+}
+
+/* Null destination: formats the message (if requested) and records latency */
+
+typedef struct _BenchSink
+{
+  LogPipe super;
+  LogTemplate *template;
+  LogQueue *queue;
+  gint backlog;
+  gint64 baseline_rss;
+  gint64 backlog_rss;
+  gint64 backlog_len;
+  GString *formatted;
+  GArray *latencies;
+  guint64 written;
+  guint64 written_bytes;
+} BenchSink;
+
+static void
+bench_sink_write(BenchSink *self, LogMessage *msg)
+{
+  if (self->template)
+    {
+      LogTemplateEvalOptions options = DEFAULT_TEMPLATE_EVAL_OPTIONS;
+
+      log_template_format(self->template, msg, &options, self->formatted);
+      self->written_bytes += self->formatted->len;
+    }
+
+  const UnixTime *recvd = &msg->timestamps[LM_TS_RECVD];
+  gint64 latency = _realtime_usec() - (recvd->ut_sec * G_USEC_PER_SEC + recvd->ut_usec);
+
+  if (self->latencies->len < BENCH_MAX_LATENCY_SAMPLES)
+    g_array_append_val(self->latencies, latency);
+  self->written++;
+}
+
+static void
+bench_sink_drain_queue(BenchSink *self)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg;
+  guint popped = 0;
+
+  while ((msg = log_queue_pop_head(self->queue, &path_options)))
+    {
+      bench_sink_write(self, msg);
+      log_msg_unref(msg);
+      popped++;
+    }
+  log_queue_ack_backlog(self->queue, popped);
+}
+
+static void
+bench_sink_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  BenchSink *self = (BenchSink *) s;
+
+  if (!self->queue)
+    {
+      bench_sink_write(self, msg);
+      log_msg_drop(msg, path_options, AT_PROCESSED);
+      return;
+    }
+
+  /* the queue is pushed from the "input" side and drained right away from
+   * the "output" side, which is what a destination does when it keeps up */
+  log_queue_push_tail(self->queue, msg, path_options);
+
+  if (self->backlog)
+    {
+      gint64 queued = log_queue_get_length(self->queue);
+
+      if (queued < self->backlog)
+        return;
+
+      if (!self->backlog_len)
+        {
+          self->backlog_rss = _resident_set_bytes() - self->baseline_rss;
+          self->backlog_len = queued;
+        }
+    }
+  bench_sink_drain_queue(self);
+}
+
+static void
+bench_sink_free(LogPipe *s)
+{
+  BenchSink *self = (BenchSink *) s;
+
+  if (self->queue)
+    log_queue_unref(self->queue);
+  log_template_unref(self->template);
+  g_string_free(self->formatted, TRUE);
+  g_array_free(self->latencies, TRUE);
+  log_pipe_free_method(s);
+}
+
+static BenchSink *
+bench_sink_new(GlobalConfig *cfg)
+{
+  BenchSink *self = g_new0(BenchSink, 1);
+
+  log_pipe_init_instance(&self->super, cfg);
+  self->super.queue = bench_sink_queue;
+  self->super.free_fn = bench_sink_free;
+  self->formatted = g_string_sized_new(1024);
+  self->latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+  return self;
+}
+
+/* Scenario */
+
+typedef struct _BenchScenario
+{
+  GlobalConfig *cfg;
+  MsgFormatOptions parse_options;
+  GPtrArray *messages;
+  GPtrArray *stages;
+  GPtrArray *probes;
+  BenchSink *sink;
+} BenchScenario;
+
+static LogPipe *
+_parse_plugin(GlobalConfig *cfg, gint context, const gchar *expr)
+{
+  const gchar *paren = strchr(expr, '(');
+  LogPipe *result = NULL;
+
+  if (!paren)
+    {
+      fprintf(stderr, "Plugin expression must be in the form of name(options): %s\n", expr);
+      return NULL;
+    }
+
+  gchar *name = g_strstrip(g_strndup(expr, paren - expr));
+  Plugin *plugin = cfg_find_plugin(cfg, context, name);
+  if (!plugin)
+    {
+      fprintf(stderr, "Unknown plugin: %s, maybe a module directive is missing?\n", name);
+      g_free(name);
+      return NULL;
+    }
+  g_free(name);
+
+  CfgLexer *lexer = cfg_lexer_new_buffer(cfg, paren, strlen(paren));
+  CFG_LTYPE yylloc = { .first_line = 1, .first_column = 1, .last_line = 1, .last_column = 1 };
+
+  cfg->lexer = lexer;
+  cfg_lexer_push_context(lexer, main_parser.context, main_parser.keywords, main_parser.name);
+  result = (LogPipe *) cfg_parse_plugin(cfg, plugin, &yylloc, NULL);
+  cfg_lexer_pop_context(lexer);
+  cfg->lexer = NULL;
+  cfg_lexer_free(lexer);
+
+  return result;
+}
+
+static LogPipe *
+_parse_filter(GlobalConfig *cfg, const gchar *expr)
+{
+  CfgLexer *lexer = cfg_lexer_new_buffer(cfg, expr, strlen(expr));
+  FilterExprNode *filter_expr = NULL;
+
+  if (!cfg_run_parser_with_main_context(cfg, lexer, &filter_expr_parser, (gpointer *) &filter_expr, NULL,
+                                        "bench filter"))
+    return NULL;
+  return log_filter_pipe_new(filter_expr, cfg);
+}
+
+static gboolean
+_load_messages_from_file(BenchScenario *self, const gchar *filename)
+{
+  gchar *contents;
+  GError *error = NULL;
+
+  if (!g_file_get_contents(filename, &contents, NULL, &error))
+    {
+      fprintf(stderr, "Error reading input file: %s\n", error->message);
+      g_clear_error(&error);
+      return FALSE;
+    }
+
+  gchar **lines = g_strsplit(contents, "\n", -1);
+  for (gint i = 0; lines[i]; i++)
+    {
+      if (lines[i][0])
+        g_ptr_array_add(self->messages, g_strdup(lines[i]));
+    }
+  g_strfreev(lines);
+  g_free(contents);
+  return TRUE;
+}
+
+static gboolean
+_process_directive(BenchScenario *self, const gchar *keyword, const gchar *arg)
+{
+  if (strcmp(keyword, "module") == 0)
+    return cfg_load_module(self->cfg, arg);
+
+  if (strcmp(keyword, "format") == 0)
+    {
+      g_free(self->parse_options.format);
+      self->parse_options.format = g_strdup(arg);
+      return TRUE;
+    }
+
+  if (strcmp(keyword, "message") == 0)
+    {
+      g_ptr_array_add(self->messages, g_strdup(arg));
+      return TRUE;
+    }
+
+  if (strcmp(keyword, "parser") == 0 || strcmp(keyword, "rewrite") == 0 || strcmp(keyword, "filter") == 0)
+    {
+      LogPipe *stage;
+
+      if (strcmp(keyword, "filter") == 0)
+        stage = _parse_filter(self->cfg, arg);
+      else
+        stage = _parse_plugin(self->cfg, keyword[0] == 'p' ? LL_CONTEXT_PARSER : LL_CONTEXT_REWRITE, arg);
+
+      if (!stage)
+        return FALSE;
+
+      g_ptr_array_add(self->stages, stage);
+      g_ptr_array_add(self->probes, bench_probe_new(self->cfg, arg));
+      return TRUE;
+    }
+
+  if (strcmp(keyword, "queue") == 0)
+    {
+      gint fifo_size = atoi(arg);
+
+      if (fifo_size <= 0)
+        {
+          fprintf(stderr, "Invalid queue size: %s\n", arg);
+          return FALSE;
+        }
+      if (self->sink->queue)
+        log_queue_unref(self->sink->queue);
+      self->sink->queue = log_queue_fifo_new(fifo_size, NULL, STATS_LEVEL0, NULL, NULL);
+      return TRUE;
+    }
+
+  if (strcmp(keyword, "backlog") == 0)
+    {
+      self->sink->backlog = atoi(arg);
+
+      if (self->sink->backlog <= 0)
+        {
+          fprintf(stderr, "Invalid backlog size: %s\n", arg);
+          return FALSE;
+        }
+      return TRUE;
+    }
+
+  if (strcmp(keyword, "template") == 0)
+    {
+      GError *error = NULL;
+
+      log_template_unref(self->sink->template);
+      self->sink->template = log_template_new(self->cfg, NULL);
+      if (!log_template_compile(self->sink->template, arg, &error))
+        {
+          fprintf(stderr, "Error compiling template: %s\n", error->message);
+          g_clear_error(&error);
+          return FALSE;
+        }
+      return TRUE;
+    }
+
+  fprintf(stderr, "Unknown scenario directive: %s\n", keyword);
+  return FALSE;
+}
+
+static gboolean
+bench_scenario_load(BenchScenario *self, const gchar *filename)
+{
+  gchar *contents;
+  GError *error = NULL;
+  gboolean success = TRUE;
+
+  if (!g_file_get_contents(filename, &contents, NULL, &error))
+    {
+      fprintf(stderr, "Error reading scenario file: %s\n", error->message);
+      g_clear_error(&error);
+      return FALSE;
+    }
+
+  gchar **lines = g_strsplit(contents, "\n", -1);
+  for (gint i = 0; lines[i] && success; i++)
+    {
+      gchar *line = g_strstrip(lines[i]);
+
+      if (!line[0] || line[0] == '#')
+        continue;
+
+      gchar **directive = g_strsplit_set(line, " \t", 2);
+      success = _process_directive(self, directive[0], directive[1] ? g_strchug(directive[1]) : "");
+      if (!success)
+        fprintf(stderr, "Error in scenario file %s at line %d\n", filename, i + 1);
+      g_strfreev(directive);
+    }
+  g_strfreev(lines);
+  g_free(contents);
+  return success;
+}
+
+/*
+ * The pipeline looks like this, each probe accounting the stage right
+ * after it (and everything downstream):
+ *
+ *   probe[0] -> stage[0] -> probe[1] -> stage[1] -> ... -> probe[n] -> sink
+ */
+static gboolean
+bench_scenario_build(BenchScenario *self)
+{
+  if (self->sink->backlog && !self->sink->queue)
+    {
+      fprintf(stderr, "The backlog directive requires a queue\n");
+      return FALSE;
+    }
+
+  g_ptr_array_add(self->probes, bench_probe_new(self->cfg, self->sink->queue ? "queue + sink" : "sink"));
+
+  for (guint i = 0; i < self->stages->len; i++)
+    {
+      LogPipe *stage = g_ptr_array_index(self->stages, i);
+
+      log_pipe_append(g_ptr_array_index(self->probes, i), stage);
+      log_pipe_append(stage, g_ptr_array_index(self->probes, i + 1));
+    }
+  log_pipe_append(g_ptr_array_index(self->probes, self->stages->len), &self->sink->super);
+
+  msg_format_options_init(&self->parse_options, self->cfg);
+
+  if (!log_pipe_init(&self->sink->super))
+    return FALSE;
+  for (guint i = 0; i < self->stages->len; i++)
+    {
+      if (!log_pipe_init(g_ptr_array_index(self->stages, i)))
+        {
+          fprintf(stderr, "Error initializing stage %s\n",
+                  ((BenchProbe *) g_ptr_array_index(self->probes, i))->name);
+          return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+static void
+bench_scenario_run(BenchScenario *self, gint64 count)
+{
+  LogPipe *head = g_ptr_array_index(self->probes, 0);
+
+  self->sink->baseline_rss = _resident_set_bytes();
+  for (gint64 i = 0; i < count; i++)
+    {
+      const gchar *line = g_ptr_array_index(self->messages, i % self->messages->len);
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+      /* make sure LM_TS_RECVD reflects the real time of reception, not
+       * the time cached at the previous message */
+      invalidate_cached_realtime();
+      LogMessage *msg = msg_format_parse(&self->parse_options, (const guchar *) line, strlen(line));
+      log_pipe_queue(head, msg, &path_options);
+    }
+
+  /* whatever is left below the backlog size */
+  if (self->sink->queue)
+    bench_sink_drain_queue(self->sink);
+}
+
+static gint
+_compare_latency(gconstpointer a, gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return (x > y) - (x < y);
+}
+
+static gint64
+_percentile(GArray *sorted, gdouble percentile)
+{
+  if (sorted->len == 0)
+    return 0;
+
+  guint index = (guint) (percentile / 100.0 * (sorted->len - 1) + 0.5);
+  return g_array_index(sorted, gint64, index);
+}
+
+static void
+bench_scenario_report(BenchScenario *self, gint64 count, gdouble elapsed_sec, guint64 total_cpu_nsec)
+{
+  GArray *latencies = self->sink->latencies;
+
+  g_array_sort(latencies, _compare_latency);
+
+  printf("scenario:         %s\n", scenario_file);
+  printf("messages:         %" G_GINT64_FORMAT " injected, %" G_GUINT64_FORMAT " written, %"
+         G_GUINT64_FORMAT " dropped\n",
+         count, self->sink->written, (guint64) count - self->sink->written);
+  printf("elapsed:          %.3f sec (cpu: %.3f sec)\n", elapsed_sec, total_cpu_nsec / 1e9);
+  printf("throughput:       %.0f msg/sec\n", elapsed_sec > 0 ? count / elapsed_sec : 0);
+  if (self->sink->template)
+    printf("output:           %" G_GUINT64_FORMAT " bytes\n", self->sink->written_bytes);
+  printf("latency (usec):   p50=%" G_GINT64_FORMAT " p99=%" G_GINT64_FORMAT " max=%" G_GINT64_FORMAT "\n",
+         _percentile(latencies, 50), _percentile(latencies, 99),
+         latencies->len ? g_array_index(latencies, gint64, latencies->len - 1) : 0);
+  if (self->sink->backlog_len)
+    printf("memory:           %.1f bytes/msg with %" G_GINT64_FORMAT " messages queued "
+           "(LogMessage: %" G_GSIZE_FORMAT " bytes, queue node: %" G_GSIZE_FORMAT " bytes)\n",
+           self->sink->backlog_rss / (gdouble) self->sink->backlog_len, self->sink->backlog_len,
+           sizeof(LogMessage), sizeof(LogMessageQueueNode));
+
+  /* everything not accounted by probe[0] was spent in the fake transport */
+  guint64 pipeline_cpu_nsec = ((BenchProbe *) g_ptr_array_index(self->probes, 0))->cpu_nsec;
+
+  printf("\n%-40s %12s %12s %8s\n", "stage", "messages", "ns/msg", "cpu%");
+  printf("%-40s %12" G_GINT64_FORMAT " %12.1f %7.1f%%\n", "transport (msg-format)", count,
+         count ? (total_cpu_nsec - pipeline_cpu_nsec) / (gdouble) count : 0,
+         total_cpu_nsec ? 100.0 * (total_cpu_nsec - pipeline_cpu_nsec) / total_cpu_nsec : 0);
+
+  for (guint i = 0; i < self->probes->len; i++)
+    {
+      BenchProbe *probe = g_ptr_array_index(self->probes, i);
+      guint64 exclusive_nsec = probe->cpu_nsec;
+
+      if (i + 1 < self->probes->len)
+        exclusive_nsec -= ((BenchProbe *) g_ptr_array_index(self->probes, i + 1))->cpu_nsec;
+
+      printf("%-40.40s %12" G_GUINT64_FORMAT " %12.1f %7.1f%%\n", probe->name, probe->messages,
+             probe->messages ? exclusive_nsec / (gdouble) probe->messages : 0,
+             total_cpu_nsec ? 100.0 * exclusive_nsec / total_cpu_nsec : 0);
+    }
+}
+
+static void
+bench_scenario_init(BenchScenario *self, GlobalConfig *cfg)
+{
+  self->cfg = cfg;
+  msg_format_options_defaults(&self->parse_options);
+  self->messages = g_ptr_array_new_with_free_func(g_free);
+  self->stages = g_ptr_array_new_with_free_func((GDestroyNotify) log_pipe_unref);
+  self->probes = g_ptr_array_new_with_free_func((GDestroyNotify) log_pipe_unref);
+  self->sink = bench_sink_new(cfg);
+}
+
+static void
+bench_scenario_destroy(BenchScenario *self)
+{
+  for (guint i = 0; i < self->stages->len; i++)
+    log_pipe_deinit(g_ptr_array_index(self->stages, i));
+  log_pipe_deinit(&self->sink->super);
+
+  g_ptr_array_free(self->stages, TRUE);
+  g_ptr_array_free(self->probes, TRUE);
+  log_pipe_unref(&self->sink->super);
+  g_ptr_array_free(self->messages, TRUE);
+  msg_format_options_destroy(&self->parse_options);
+}
+
+int
+main(int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *error = NULL;
+  BenchScenario scenario;
+  gint rc = 1;
+
+  ctx = g_option_context_new(" - in-process pipeline benchmark");
+  g_option_context_add_main_entries(ctx, bench_options, NULL);
+  if (!g_option_context_parse(ctx, &argc, &argv, &error))
+    {
+      fprintf(stderr, "Error parsing command line arguments: %s\n", error->message);
+      g_clear_error(&error);
+      g_option_context_free(ctx);
+      return 1;
+    }
+  g_option_context_free(ctx);
+
+  if (!scenario_file)
+    {
+      fprintf(stderr, "A scenario file must be specified using --scenario\n");
+      return 1;
+    }
+
+  app_startup();
+  configuration = cfg_new_snippet();
+  plugin_context_set_module_path(&configuration->plugin_context,
+                                 module_path ? : get_installation_path_for(SYSLOG_NG_MODULE_PATH));
+  cfg_load_module(configuration, "syslogformat");
+
+  bench_scenario_init(&scenario, configuration);
+  if (!bench_scenario_load(&scenario, scenario_file))
+    goto exit;
+  if (input_file && !_load_messages_from_file(&scenario, input_file))
+    goto exit;
+  if (scenario.messages->len == 0)
+    {
+      fprintf(stderr, "No messages to inject, use a message directive or --input\n");
+      goto exit;
+    }
+  if (!bench_scenario_build(&scenario))
+    goto exit;
+
+  gint64 start_time = g_get_monotonic_time();
+  guint64 start_cpu = _thread_cpu_nsec();
+
+  bench_scenario_run(&scenario, message_count);
+
+  guint64 total_cpu_nsec = _thread_cpu_nsec() - start_cpu;
+  gdouble elapsed_sec = (g_get_monotonic_time() - start_time) / (gdouble) G_USEC_PER_SEC;
+
+  bench_scenario_report(&scenario, message_count, elapsed_sec, total_cpu_nsec);
+  rc = 0;
+
+exit:
+  bench_scenario_destroy(&scenario);
+  cfg_free(configuration);
+  configuration = NULL;
+  app_shutdown();
+  return rc;
+}